@@ -29,6 +29,99 @@ extern "C" {
 KHIVA_C_API void k_means(const khiva_array *tss, const int *k, khiva_array *centroids, khiva_array *labels, const float *tolerance,
                          const int *max_iterations, int *error_code, char *error_message);
 
+/**
+ * @brief Calculates the k-means algorithm from several concurrent initialisations and keeps the solution with the
+ * lowest inertia.
+ *
+ * @param tss            Expects an input array whose dimension zero is the length of the time series (all the same) and
+ *                       dimension one indicates the number of time series.
+ * @param k              The number of means to be computed.
+ * @param restarts       The number of runs.
+ * @param centroids      The resulting means or centroids of the best run.
+ * @param labels         The resulting labels of each time series of the best run.
+ * @param stats          An array of 2 x restarts with the inertia and the number of iterations of every run.
+ * @param tolerance      The error tolerance to stop the computation of the centroids.
+ * @param max_iterations The maximum number of iterations allowed.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_means_restarts(const khiva_array *tss, const int *k, const int *restarts, khiva_array *centroids,
+                                  khiva_array *labels, khiva_array *stats, const float *tolerance,
+                                  const int *max_iterations, int *error_code, char *error_message);
+
+/**
+ * @brief Calculates the k-means algorithm with Hamerly's acceleration, which skips the distances that the triangle
+ * inequality proves unnecessary and gives the same result as k_means.
+ *
+ * [1] G. Hamerly. 2010. Making k-means even faster. Proceedings of the 2010 SIAM International Conference on Data
+ * Mining, Pages 130-140.
+ *
+ * @param tss            Expects an input array whose dimension zero is the length of the time series (all the same) and
+ *                       dimension one indicates the number of time series.
+ * @param k              The number of means to be computed.
+ * @param centroids      The resulting means or centroids.
+ * @param labels         The resulting labels of each time series which is the closest centroid.
+ * @param tolerance      The error tolerance to stop the computation of the centroids.
+ * @param max_iterations The maximum number of iterations allowed.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_means_accelerated(const khiva_array *tss, const int *k, khiva_array *centroids, khiva_array *labels,
+                                     const float *tolerance, const int *max_iterations, int *error_code,
+                                     char *error_message);
+
+/**
+ * @brief Labels new time series with the closest of the centroids computed by k_means. Use create_k_means_predictor
+ * to label several batches with the same centroids.
+ *
+ * @param tss            Expects an input array whose dimension zero is the length of the centroids and dimension one
+ *                       indicates the number of time series.
+ * @param centroids      The centroids computed by k_means.
+ * @param labels         The resulting labels of each time series which is the closest centroid.
+ * @param distances      The resulting euclidean distances to the closest centroid.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_means_predict(const khiva_array *tss, const khiva_array *centroids, khiva_array *labels,
+                                 khiva_array *distances, int *error_code, char *error_message);
+
+/**
+ * @brief Creates a predictor that labels new time series with the centroids computed by k_means. Its centroid data is
+ * prepared once, so every call to k_means_predictor_predict only processes the new time series. It must be released
+ * with delete_k_means_predictor.
+ *
+ * @param centroids      The centroids computed by k_means.
+ * @param result         The predictor created.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void create_k_means_predictor(const khiva_array *centroids, khiva_kmeans_predictor *result, int *error_code,
+                                          char *error_message);
+
+/**
+ * @brief Labels new time series with a predictor created by create_k_means_predictor.
+ *
+ * @param predictor      The predictor.
+ * @param tss            Expects an input array whose dimension zero is the length of the centroids and dimension one
+ *                       indicates the number of time series.
+ * @param labels         The resulting labels of each time series which is the closest centroid.
+ * @param distances      The resulting euclidean distances to the closest centroid.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_means_predictor_predict(const khiva_kmeans_predictor *predictor, const khiva_array *tss,
+                                           khiva_array *labels, khiva_array *distances, int *error_code,
+                                           char *error_message);
+
+/**
+ * @brief Releases a predictor created by create_k_means_predictor.
+ *
+ * @param predictor      The predictor to release.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void delete_k_means_predictor(khiva_kmeans_predictor *predictor, int *error_code, char *error_message);
+
 /**
  * @brief Calculates the K-Shape algorithm.
  *
@@ -48,6 +141,152 @@ KHIVA_C_API void k_means(const khiva_array *tss, const int *k, khiva_array *cent
 KHIVA_C_API void k_shape(const khiva_array *tss, const int *k, khiva_array *centroids, khiva_array *labels, const float *tolerance,
                          const int *max_iterations, int *error_code, char *error_message);
 
+/**
+ * @brief Calculates the K-Shape algorithm from several concurrent initialisations and keeps the solution with the
+ * lowest sum of shape-based distances.
+ *
+ * @param tss            Expects an input array whose dimension zero is the length of the time series (all the same) and
+ *                       dimension one indicates the number of time series.
+ * @param k              The number of means to be computed.
+ * @param restarts       The number of runs.
+ * @param centroids      The resulting means or centroids of the best run.
+ * @param labels         The resulting labels of each time series of the best run.
+ * @param stats          An array of 2 x restarts with the sum of shape-based distances and the number of iterations of
+ *                       every run.
+ * @param tolerance      The error tolerance to stop the computation of the centroids.
+ * @param max_iterations The maximum number of iterations allowed.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_shape_restarts(const khiva_array *tss, const int *k, const int *restarts, khiva_array *centroids,
+                                  khiva_array *labels, khiva_array *stats, const float *tolerance,
+                                  const int *max_iterations, int *error_code, char *error_message);
+
+/**
+ * @brief Labels new time series with the centroid computed by k_shape at the lowest shape-based distance. Use
+ * create_k_shape_predictor to label several batches with the same centroids.
+ *
+ * @param tss            Expects an input array whose dimension zero is the length of the centroids and dimension one
+ *                       indicates the number of time series.
+ * @param centroids      The centroids computed by k_shape.
+ * @param labels         The resulting labels of each time series which is the closest centroid.
+ * @param distances      The resulting shape-based distances to the closest centroid.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_shape_predict(const khiva_array *tss, const khiva_array *centroids, khiva_array *labels,
+                                 khiva_array *distances, int *error_code, char *error_message);
+
+/**
+ * @brief Creates a predictor that labels new time series with the centroids computed by k_shape. Its centroid data is
+ * prepared once, so every call to k_shape_predictor_predict only processes the new time series. It must be released
+ * with delete_k_shape_predictor.
+ *
+ * @param centroids      The centroids computed by k_shape.
+ * @param result         The predictor created.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void create_k_shape_predictor(const khiva_array *centroids, khiva_kshape_predictor *result, int *error_code,
+                                          char *error_message);
+
+/**
+ * @brief Labels new time series with a predictor created by create_k_shape_predictor.
+ *
+ * @param predictor      The predictor.
+ * @param tss            Expects an input array whose dimension zero is the length of the centroids and dimension one
+ *                       indicates the number of time series.
+ * @param labels         The resulting labels of each time series which is the closest centroid.
+ * @param distances      The resulting shape-based distances to the closest centroid.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_shape_predictor_predict(const khiva_kshape_predictor *predictor, const khiva_array *tss,
+                                           khiva_array *labels, khiva_array *distances, int *error_code,
+                                           char *error_message);
+
+/**
+ * @brief Releases a predictor created by create_k_shape_predictor.
+ *
+ * @param predictor      The predictor to release.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void delete_k_shape_predictor(khiva_kshape_predictor *predictor, int *error_code, char *error_message);
+
+/**
+ * @brief Calculates the k-medoids clustering with FasterPAM over a distance matrix.
+ *
+ * [1] E. Schubert and P. J. Rousseeuw. 2021. Fast and eager k-medoids clustering: O(k) runtime improvement of the
+ * PAM, CLARA, and CLARANS algorithms. Information Systems, 101, 101804.
+ *
+ * @param distances      The distances between the time series, either as a numOfTs x numOfTs matrix of which only
+ *                       the upper triangle is read or as a condensed vector.
+ * @param k              The number of medoids to be computed.
+ * @param medoids        The resulting positions of the medoids.
+ * @param labels         The resulting labels of each time series, which is the position of its closest medoid.
+ * @param condensed      Whether distances is a condensed vector.
+ * @param max_iterations The maximum number of passes over the swap candidates.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void k_medoids(const khiva_array *distances, const int *k, khiva_array *medoids, khiva_array *labels,
+                           const bool *condensed, const int *max_iterations, int *error_code, char *error_message);
+
+/**
+ * @brief Calculates the hierarchical agglomerative clustering of the time series.
+ *
+ * [1] D. Müllner. 2011. Modern hierarchical, agglomerative clustering algorithms. arXiv:1109.2378.
+ *
+ * @param distances      The distances between the time series, either as a numOfTs x numOfTs matrix of which only
+ *                       the upper triangle is read or as a condensed vector.
+ * @param method         The linkage method: 0 for single, 1 for complete, 2 for average and 3 for ward.
+ * @param condensed      Whether distances is a condensed vector.
+ * @param result         The linkage matrix of (numOfTs - 1) x 4 in the format of scipy.cluster.hierarchy.linkage.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void agglomerative(const khiva_array *distances, const int *method, const bool *condensed,
+                               khiva_array *result, int *error_code, char *error_message);
+
+/**
+ * @brief Calculates the DBSCAN clustering with range queries on a vantage-point tree.
+ *
+ * [1] M. Ester, H.-P. Kriegel, J. Sander and X. Xu. 1996. A density-based algorithm for discovering clusters in large
+ * spatial databases with noise. Proceedings of the Second International Conference on Knowledge Discovery and Data
+ * Mining, Pages 226-231.
+ *
+ * @param tss            Expects an input array whose dimension zero is the length of the time series (all the same) and
+ *                       dimension one indicates the number of time series.
+ * @param epsilon        The radius of the neighbourhoods.
+ * @param min_points     The minimum number of time series in the neighbourhood of a core point.
+ * @param metric         The metric: 0 for euclidean and 1 for z-normalised euclidean.
+ * @param labels         The resulting labels of each time series, or -1 for noise.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void dbscan(const khiva_array *tss, const double *epsilon, const int *min_points, const int *metric,
+                        khiva_array *labels, int *error_code, char *error_message);
+
+/**
+ * @brief Calculates the HDBSCAN clustering.
+ *
+ * [1] R. J. G. B. Campello, D. Moulavi and J. Sander. 2013. Density-based clustering based on hierarchical density
+ * estimates. Advances in Knowledge Discovery and Data Mining, Pages 160-172.
+ *
+ * @param tss              Expects an input array whose dimension zero is the length of the time series (all the same)
+ *                         and dimension one indicates the number of time series.
+ * @param min_cluster_size The minimum number of time series of a cluster.
+ * @param min_points       The number of neighbours defining the core distances, or a negative value to use
+ *                         min_cluster_size.
+ * @param metric           The metric: 0 for euclidean and 1 for z-normalised euclidean.
+ * @param labels           The resulting labels of each time series, or -1 for noise.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void hdbscan(const khiva_array *tss, const int *min_cluster_size, const int *min_points, const int *metric,
+                         khiva_array *labels, int *error_code, char *error_message);
+
 #ifdef __cplusplus
 }
 #endif
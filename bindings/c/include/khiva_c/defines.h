@@ -18,5 +18,7 @@
 #endif
 
 using khiva_array = void *;
+using khiva_kmeans_predictor = void *;
+using khiva_kshape_predictor = void *;
 
 #endif
@@ -13,6 +13,98 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Calculates the k coefficients of the discrete Fourier transform of every time series with the largest
+ * contribution to its energy.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of coefficients kept, between 1 and n / 2 + 1.
+ * @param coefficients The resulting complex coefficients, k x numOfTs, sorted by decreasing energy.
+ * @param indexes The resulting frequencies of the coefficients, k x numOfTs.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void dft_top_k(const khiva_array *tss, const int *k, khiva_array *coefficients, khiva_array *indexes,
+                           int *error_code, char *error_message);
+
+/**
+ * @brief Reconstructs the time series from the coefficients of the discrete Fourier transform kept by dft_top_k.
+ *
+ * @param coefficients The complex coefficients, k x numOfTs.
+ * @param indexes The frequencies of the coefficients, k x numOfTs.
+ * @param n The length of the time series.
+ * @param result The reconstructed time series, n x numOfTs.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void inverse_dft_top_k(const khiva_array *coefficients, const khiva_array *indexes, const int *n,
+                                   khiva_array *result, int *error_code, char *error_message);
+
+/**
+ * @brief Calculates the multi-level discrete wavelet transform of every time series with the lifting scheme.
+ *
+ * [1] I. Daubechies and W. Sweldens. 1998. Factoring wavelet transforms into lifting steps. Journal of Fourier
+ * Analysis and Applications, 4(3), 247-269.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same), a multiple
+ * of 2^levels, and dimension one indicates the number of time series.
+ * @param wavelet The wavelet: 0 for Haar and 1 for Daubechies D4.
+ * @param levels The number of levels.
+ * @param result The coefficients of every time series, with the approximation of the last level first and then the
+ * details from the last level to the first one.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void dwt(const khiva_array *tss, const int *wavelet, const int *levels, khiva_array *result,
+                     int *error_code, char *error_message);
+
+/**
+ * @brief Reconstructs the time series from the coefficients of their multi-level discrete wavelet transform.
+ *
+ * @param coefficients The coefficients computed by dwt, with one time series per column.
+ * @param wavelet The wavelet: 0 for Haar and 1 for Daubechies D4.
+ * @param levels The number of levels.
+ * @param result The reconstructed time series.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void inverse_dwt(const khiva_array *coefficients, const int *wavelet, const int *levels,
+                             khiva_array *result, int *error_code, char *error_message);
+
+/**
+ * @brief Largest-Triangle-Three-Buckets (LTTB) downsamples a time series to a fixed number of points for plotting,
+ * keeping from every bucket the point forming the largest triangle with its neighbours.
+ *
+ * [1] S. Steinarsson. 2013. Downsampling Time Series for Visual Representation. MSc thesis, University of Iceland.
+ *
+ * @param points Expects an input array whose first column is the x coordinate and second column the y coordinate of
+ * the points. Dimension two indicates the number of time series.
+ * @param num_points Sets the number of points returned, at least 3.
+ * @param res_points The reduced points of every time series.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void lttb(const khiva_array *points, const int *num_points, khiva_array *res_points, int *error_code,
+                      char *error_message);
+
+/**
+ * @brief M4 downsamples a time series for a plot with a fixed number of pixel columns, keeping the first, the minimum,
+ * the maximum and the last points of every bucket.
+ *
+ * [1] U. Jugel, Z. Jerzak, G. Hackenbroich and V. Markl. 2014. M4: A Visualization-Oriented Time Series Data
+ * Aggregation. Proceedings of the VLDB Endowment, 7(10), 797-808.
+ *
+ * @param points Expects an input array whose first column is the x coordinate and second column the y coordinate of
+ * the points. Dimension two indicates the number of time series.
+ * @param buckets The number of buckets, usually the width of the plot in pixels.
+ * @param res_points The reduced points of every time series, the shorter ones padded with NaN.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void m4(const khiva_array *points, const int *buckets, khiva_array *res_points, int *error_code,
+                    char *error_message);
+
 /**
  * @brief Piecewise Aggregate Approximation (PAA) approximates a time series \f$X\f$ of length \f$n\f$ into vector
  * \f$\bar{X}=(\bar{x}_{1},…,\bar{x}_{M})\f$ of any arbitrary length \f$M \leq n\f$ where each of \f$\bar{x_{i}}\f$ is
@@ -123,6 +215,21 @@ KHIVA_C_API void ramer_douglas_peucker(const khiva_array *points, const double *
 KHIVA_C_API void sax(const khiva_array *a, const int *alphabet_size, khiva_array *result, int *error_code,
                      char *error_message);
 
+/**
+ * @brief Symbolic Aggregate approXimation (SAX) of many time series at once, with the statistics of all of them
+ * computed in a single reduction and a binary search over the breakpoints on the device.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param alphabet_size Number of element within the alphabet.
+ * @param bins Number of PAA segments of every time series, or zero to map every value.
+ * @param result An array of symbols, with one column per time series.
+ * @param error_code Allocated pointer to integer, where the resulting error_code is stored.
+ * @param error_message Allocated char array to KHIVA_ERROR_LENGTH, where the resulting error message is stored.
+ */
+KHIVA_C_API void sax_batch(const khiva_array *tss, const int *alphabet_size, const int *bins, khiva_array *result,
+                           int *error_code, char *error_message);
+
 /**
  * @brief Reduces a set of points by applying the Visvalingam method (minimum triangle area) until the number
  * of points is reduced to numPoints.
@@ -35,6 +35,124 @@ void k_means(const khiva_array *tss, const int *k, khiva_array *centroids, khiva
     }
 }
 
+void k_means_restarts(const khiva_array *tss, const int *k, const int *restarts, khiva_array *centroids,
+                      khiva_array *labels, khiva_array *stats, const float *tolerance, const int *max_iterations,
+                      int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels;
+        af::array primitive_centroids;
+        af::array primitive_stats;
+
+        khiva::clustering::kMeans(var_tss, *k, *restarts, primitive_centroids, primitive_labels, primitive_stats,
+                                  *tolerance, *max_iterations);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *centroids = array::increment_ref_count(primitive_centroids.get());
+        *stats = array::increment_ref_count(primitive_stats.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void k_means_accelerated(const khiva_array *tss, const int *k, khiva_array *centroids, khiva_array *labels,
+                         const float *tolerance, const int *max_iterations, int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels;
+        af::array primitive_centroids;
+
+        khiva::clustering::kMeansAccelerated(var_tss, *k, primitive_centroids, primitive_labels, *tolerance,
+                                             *max_iterations);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *centroids = array::increment_ref_count(primitive_centroids.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void k_means_predict(const khiva_array *tss, const khiva_array *centroids, khiva_array *labels, khiva_array *distances,
+                     int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        auto var_centroids = array::from_af_array(*centroids);
+        af::array primitive_labels;
+        af::array primitive_distances;
+
+        khiva::clustering::kMeansPredict(var_tss, var_centroids, primitive_labels, primitive_distances);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *distances = array::increment_ref_count(primitive_distances.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void create_k_means_predictor(const khiva_array *centroids, khiva_kmeans_predictor *result, int *error_code,
+                              char *error_message) {
+    try {
+        auto var_centroids = array::from_af_array(*centroids);
+
+        *result = new khiva::clustering::KMeansPredictor(var_centroids);
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void k_means_predictor_predict(const khiva_kmeans_predictor *predictor, const khiva_array *tss, khiva_array *labels,
+                               khiva_array *distances, int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels;
+        af::array primitive_distances;
+
+        auto var_predictor = static_cast<const khiva::clustering::KMeansPredictor *>(*predictor);
+        var_predictor->predict(var_tss, primitive_labels, primitive_distances);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *distances = array::increment_ref_count(primitive_distances.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void delete_k_means_predictor(khiva_kmeans_predictor *predictor, int *error_code, char *error_message) {
+    try {
+        delete static_cast<khiva::clustering::KMeansPredictor *>(*predictor);
+        *predictor = nullptr;
+        *error_code = 0;
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
 void k_shape(const khiva_array *tss, const int *k, khiva_array *centroids, khiva_array *labels, const float *tolerance,
              const int *max_iterations, int *error_code, char *error_message) {
     try {
@@ -55,3 +173,172 @@ void k_shape(const khiva_array *tss, const int *k, khiva_array *centroids, khiva
         *error_code = AF_ERR_UNKNOWN;
     }
 }
+
+void k_shape_restarts(const khiva_array *tss, const int *k, const int *restarts, khiva_array *centroids,
+                      khiva_array *labels, khiva_array *stats, const float *tolerance, const int *max_iterations,
+                      int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels;
+        af::array primitive_centroids;
+        af::array primitive_stats;
+
+        khiva::clustering::kShape(var_tss, *k, *restarts, primitive_centroids, primitive_labels, primitive_stats,
+                                  *tolerance, *max_iterations);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *centroids = array::increment_ref_count(primitive_centroids.get());
+        *stats = array::increment_ref_count(primitive_stats.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void k_shape_predict(const khiva_array *tss, const khiva_array *centroids, khiva_array *labels, khiva_array *distances,
+                     int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        auto var_centroids = array::from_af_array(*centroids);
+        af::array primitive_labels;
+        af::array primitive_distances;
+
+        khiva::clustering::kShapePredict(var_tss, var_centroids, primitive_labels, primitive_distances);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *distances = array::increment_ref_count(primitive_distances.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void create_k_shape_predictor(const khiva_array *centroids, khiva_kshape_predictor *result, int *error_code,
+                              char *error_message) {
+    try {
+        auto var_centroids = array::from_af_array(*centroids);
+
+        *result = new khiva::clustering::KShapePredictor(var_centroids);
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void k_shape_predictor_predict(const khiva_kshape_predictor *predictor, const khiva_array *tss, khiva_array *labels,
+                               khiva_array *distances, int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels;
+        af::array primitive_distances;
+
+        auto var_predictor = static_cast<const khiva::clustering::KShapePredictor *>(*predictor);
+        var_predictor->predict(var_tss, primitive_labels, primitive_distances);
+
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *distances = array::increment_ref_count(primitive_distances.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void delete_k_shape_predictor(khiva_kshape_predictor *predictor, int *error_code, char *error_message) {
+    try {
+        delete static_cast<khiva::clustering::KShapePredictor *>(*predictor);
+        *predictor = nullptr;
+        *error_code = 0;
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void k_medoids(const khiva_array *distances, const int *k, khiva_array *medoids, khiva_array *labels,
+               const bool *condensed, const int *max_iterations, int *error_code, char *error_message) {
+    try {
+        auto var_distances = array::from_af_array(*distances);
+        af::array primitive_medoids;
+        af::array primitive_labels;
+
+        khiva::clustering::kMedoids(var_distances, *k, primitive_medoids, primitive_labels, *condensed,
+                                    *max_iterations);
+
+        *medoids = array::increment_ref_count(primitive_medoids.get());
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void agglomerative(const khiva_array *distances, const int *method, const bool *condensed, khiva_array *result,
+                   int *error_code, char *error_message) {
+    try {
+        auto var_distances = array::from_af_array(*distances);
+        af::array primitive_result = khiva::clustering::agglomerative(
+            var_distances, static_cast<khiva::clustering::Linkage>(*method), *condensed);
+        *result = array::increment_ref_count(primitive_result.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void dbscan(const khiva_array *tss, const double *epsilon, const int *min_points, const int *metric,
+            khiva_array *labels, int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels = khiva::clustering::dbscan(var_tss, *epsilon, *min_points,
+                                                               static_cast<khiva::search::Metric>(*metric));
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void hdbscan(const khiva_array *tss, const int *min_cluster_size, const int *min_points, const int *metric,
+             khiva_array *labels, int *error_code, char *error_message) {
+    try {
+        auto var_tss = array::from_af_array(*tss);
+        af::array primitive_labels = khiva::clustering::hdbscan(var_tss, *min_cluster_size, *min_points,
+                                                                static_cast<khiva::search::Metric>(*metric));
+        *labels = array::increment_ref_count(primitive_labels.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
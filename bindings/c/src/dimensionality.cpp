@@ -13,6 +13,106 @@
 using namespace khiva;
 using namespace khiva::util;
 
+void dft_top_k(const khiva_array *tss, const int *k, khiva_array *coefficients, khiva_array *indexes, int *error_code,
+               char *error_message) {
+    try {
+        auto array = array::from_af_array(*tss);
+        af::array primitive_coefficients;
+        af::array primitive_indexes;
+        khiva::dimensionality::DFTTopK(array, *k, primitive_coefficients, primitive_indexes);
+        *coefficients = array::increment_ref_count(primitive_coefficients.get());
+        *indexes = array::increment_ref_count(primitive_indexes.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void inverse_dft_top_k(const khiva_array *coefficients, const khiva_array *indexes, const int *n, khiva_array *result,
+                       int *error_code, char *error_message) {
+    try {
+        auto var_coefficients = array::from_af_array(*coefficients);
+        auto var_indexes = array::from_af_array(*indexes);
+        auto r = khiva::dimensionality::inverseDFTTopK(var_coefficients, var_indexes, *n);
+        *result = array::increment_ref_count(r.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void dwt(const khiva_array *tss, const int *wavelet, const int *levels, khiva_array *result, int *error_code,
+         char *error_message) {
+    try {
+        auto array = array::from_af_array(*tss);
+        auto r = khiva::dimensionality::DWT(array, static_cast<khiva::dimensionality::Wavelet>(*wavelet), *levels);
+        *result = array::increment_ref_count(r.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void inverse_dwt(const khiva_array *coefficients, const int *wavelet, const int *levels, khiva_array *result,
+                 int *error_code, char *error_message) {
+    try {
+        auto array = array::from_af_array(*coefficients);
+        auto r =
+            khiva::dimensionality::inverseDWT(array, static_cast<khiva::dimensionality::Wavelet>(*wavelet), *levels);
+        *result = array::increment_ref_count(r.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void lttb(const khiva_array *points, const int *num_points, khiva_array *res_points, int *error_code,
+          char *error_message) {
+    try {
+        auto array = array::from_af_array(*points);
+        auto r = khiva::dimensionality::LTTB(array, *num_points);
+        *res_points = array::increment_ref_count(r.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
+void m4(const khiva_array *points, const int *buckets, khiva_array *res_points, int *error_code, char *error_message) {
+    try {
+        auto array = array::from_af_array(*points);
+        auto r = khiva::dimensionality::M4(array, *buckets);
+        *res_points = array::increment_ref_count(r.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
 void paa(const khiva_array *a, const int *bins, khiva_array *result, int *error_code, char *error_message) {
     try {
         auto array = array::from_af_array(*a);
@@ -106,6 +206,22 @@ void sax(const khiva_array *a, const int *alphabet_size, khiva_array *result, in
     }
 }
 
+void sax_batch(const khiva_array *tss, const int *alphabet_size, const int *bins, khiva_array *result, int *error_code,
+               char *error_message) {
+    try {
+        auto array = array::from_af_array(*tss);
+        auto r = khiva::dimensionality::SAXBatch(array, *alphabet_size, *bins);
+        *result = array::increment_ref_count(r.get());
+        *error_code = 0;
+    } catch (af::exception &e) {
+        fill_error(__func__, e.what(), error_message);
+        *error_code = e.err();
+    } catch (...) {
+        fill_error(__func__, "Unknown error.", error_message);
+        *error_code = AF_ERR_UNKNOWN;
+    }
+}
+
 void visvalingam(const khiva_array *points, const int *num_points, khiva_array *res_points, int *error_code,
                  char *error_message) {
     try {
@@ -28,6 +28,88 @@ extern "C" {
 JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeans(JNIEnv *env, jobject, jlong ref_tss, jint k,
                                                                        jfloat tolerance, jint maxIterations);
 
+/**
+ * @brief Calculates the kMeans algorithm from several concurrent initialisations and keeps the solution with the
+ * lowest inertia.
+ *
+ * @param tss                   Expects an input array whose dimension zero is the length of the time series (all the
+ * same) and dimension one indicates the number of time series.
+ * @param k                     The number of means to be computed.
+ * @param restarts              The number of runs.
+ * @param tolerance             The error tolerance to stop the computation of the centroids.
+ * @param maxIterations         The maximum number of iterations allowed.
+ *
+ * @return An Array of arrays with the resulting centroids, labels and the statistics of every run.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansRestarts(JNIEnv *env, jobject,
+                                                                               jlong ref_tss, jint k, jint restarts,
+                                                                               jfloat tolerance, jint maxIterations);
+
+/**
+ * @brief Calculates the kMeans algorithm with Hamerly's acceleration, which gives the same result as kMeans.
+ *
+ * [1] G. Hamerly. 2010. Making k-means even faster. Proceedings of the 2010 SIAM International Conference on Data
+ * Mining, Pages 130-140.
+ *
+ * @param tss                   Expects an input array whose dimension zero is the length of the time series (all the
+ * same) and dimension one indicates the number of time series.
+ * @param k                     The number of means to be computed.
+ * @param tolerance             The error tolerance to stop the computation of the centroids.
+ * @param maxIterations         The maximum number of iterations allowed.
+ *
+ * @return An Array of arrays with the resulting centroids and labels.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansAccelerated(JNIEnv *env, jobject,
+                                                                                  jlong ref_tss, jint k,
+                                                                                  jfloat tolerance,
+                                                                                  jint maxIterations);
+
+/**
+ * @brief Labels new time series with the closest of the centroids computed by kMeans. Use createKMeansPredictor to
+ * label several batches with the same centroids.
+ *
+ * @param ref_tss               Expects an input array whose dimension zero is the length of the centroids and
+ * dimension one indicates the number of time series.
+ * @param ref_centroids         The centroids computed by kMeans.
+ *
+ * @return An Array of arrays with the resulting labels and the euclidean distances to the closest centroid.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansPredict(JNIEnv *env, jobject, jlong ref_tss,
+                                                                              jlong ref_centroids);
+
+/**
+ * @brief Creates a predictor that labels new time series with the centroids computed by KMeans. Its centroid data is
+ * prepared once, so every call to kMeansPredictorPredict only processes the new time series. It must be released
+ * with deleteKMeansPredictor.
+ *
+ * @param ref_centroids         The centroids computed by kMeans.
+ *
+ * @return The predictor reference.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_createKMeansPredictor(JNIEnv *env, jobject,
+                                                                                 jlong ref_centroids);
+
+/**
+ * @brief Labels new time series with a predictor created by createKMeansPredictor.
+ *
+ * @param ref_predictor         The predictor.
+ * @param ref_tss               Expects an input array whose dimension zero is the length of the centroids and
+ * dimension one indicates the number of time series.
+ *
+ * @return An Array of arrays with the resulting labels and the euclidean distances to the closest centroid.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansPredictorPredict(JNIEnv *env, jobject,
+                                                                                       jlong ref_predictor,
+                                                                                       jlong ref_tss);
+
+/**
+ * @brief Releases a predictor created by createKMeansPredictor.
+ *
+ * @param ref_predictor         The predictor to release.
+ */
+JNIEXPORT void JNICALL Java_io_shapelets_khiva_Clustering_deleteKMeansPredictor(JNIEnv *env, jobject,
+                                                                                jlong ref_predictor);
+
 /**
  * @brief Calculates the kShape algorithm.
  *
@@ -44,6 +126,131 @@ JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeans(JNIEnv *e
 JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShape(JNIEnv *env, jobject, jlong ref_tss, jint k,
                                                                        jfloat tolerance, jint maxIterations);
 
+/**
+ * @brief Calculates the kShape algorithm from several concurrent initialisations and keeps the solution with the
+ * lowest sum of shape-based distances.
+ *
+ * @param tss                   Expects an input array whose dimension zero is the length of the time series (all the
+ * same) and dimension one indicates the number of time series.
+ * @param k                     The number of means to be computed.
+ * @param restarts              The number of runs.
+ * @param tolerance             The error tolerance to stop the computation of the centroids.
+ * @param maxIterations         The maximum number of iterations allowed.
+ *
+ * @return An Array of arrays with the resulting centroids, labels and the statistics of every run.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShapeRestarts(JNIEnv *env, jobject,
+                                                                               jlong ref_tss, jint k, jint restarts,
+                                                                               jfloat tolerance, jint maxIterations);
+
+/**
+ * @brief Labels new time series with the centroid computed by kShape at the lowest shape-based distance. Use
+ * createKShapePredictor to label several batches with the same centroids.
+ *
+ * @param ref_tss               Expects an input array whose dimension zero is the length of the centroids and
+ * dimension one indicates the number of time series.
+ * @param ref_centroids         The centroids computed by kShape.
+ *
+ * @return An Array of arrays with the resulting labels and the shape-based distances to the closest centroid.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShapePredict(JNIEnv *env, jobject, jlong ref_tss,
+                                                                              jlong ref_centroids);
+
+/**
+ * @brief Creates a predictor that labels new time series with the centroids computed by KShape. Its centroid data is
+ * prepared once, so every call to kShapePredictorPredict only processes the new time series. It must be released
+ * with deleteKShapePredictor.
+ *
+ * @param ref_centroids         The centroids computed by kShape.
+ *
+ * @return The predictor reference.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_createKShapePredictor(JNIEnv *env, jobject,
+                                                                                 jlong ref_centroids);
+
+/**
+ * @brief Labels new time series with a predictor created by createKShapePredictor.
+ *
+ * @param ref_predictor         The predictor.
+ * @param ref_tss               Expects an input array whose dimension zero is the length of the centroids and
+ * dimension one indicates the number of time series.
+ *
+ * @return An Array of arrays with the resulting labels and the shape-based distances to the closest centroid.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShapePredictorPredict(JNIEnv *env, jobject,
+                                                                                       jlong ref_predictor,
+                                                                                       jlong ref_tss);
+
+/**
+ * @brief Releases a predictor created by createKShapePredictor.
+ *
+ * @param ref_predictor         The predictor to release.
+ */
+JNIEXPORT void JNICALL Java_io_shapelets_khiva_Clustering_deleteKShapePredictor(JNIEnv *env, jobject,
+                                                                                jlong ref_predictor);
+
+/**
+ * @brief Calculates the k-medoids clustering with FasterPAM over a distance matrix.
+ *
+ * [1] E. Schubert and P. J. Rousseeuw. 2021. Fast and eager k-medoids clustering: O(k) runtime improvement of the
+ * PAM, CLARA, and CLARANS algorithms. Information Systems, 101, 101804.
+ *
+ * @param ref_distances         The distances between the time series, either as a numOfTs x numOfTs matrix of which
+ * only the upper triangle is read or as a condensed vector.
+ * @param k                     The number of medoids to be computed.
+ * @param condensed             Whether the distances are a condensed vector.
+ * @param maxIterations         The maximum number of passes over the swap candidates.
+ *
+ * @return An Array of arrays with the resulting medoids and labels.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMedoids(JNIEnv *env, jobject, jlong ref_distances,
+                                                                         jint k, jboolean condensed,
+                                                                         jint maxIterations);
+
+/**
+ * @brief Calculates the hierarchical agglomerative clustering of the time series.
+ *
+ * [1] D. Müllner. 2011. Modern hierarchical, agglomerative clustering algorithms. arXiv:1109.2378.
+ *
+ * @param ref_distances         The distances between the time series, either as a numOfTs x numOfTs matrix of which
+ * only the upper triangle is read or as a condensed vector.
+ * @param method                The linkage method: 0 for single, 1 for complete, 2 for average and 3 for ward.
+ * @param condensed             Whether the distances are a condensed vector.
+ *
+ * @return The reference to the linkage matrix in the format of scipy.cluster.hierarchy.linkage.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_agglomerative(JNIEnv *env, jobject, jlong ref_distances,
+                                                                         jint method, jboolean condensed);
+
+/**
+ * @brief Calculates the DBSCAN clustering with range queries on a vantage-point tree.
+ *
+ * @param ref_tss               Expects an input array whose dimension zero is the length of the time series (all the
+ * same) and dimension one indicates the number of time series.
+ * @param epsilon               The radius of the neighbourhoods.
+ * @param minPoints             The minimum number of time series in the neighbourhood of a core point.
+ * @param metric                The metric: 0 for euclidean and 1 for z-normalised euclidean.
+ *
+ * @return The reference to the labels of the time series, or -1 for noise.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_dbscan(JNIEnv *env, jobject, jlong ref_tss, jdouble epsilon,
+                                                                  jint minPoints, jint metric);
+
+/**
+ * @brief Calculates the HDBSCAN clustering.
+ *
+ * @param ref_tss               Expects an input array whose dimension zero is the length of the time series (all the
+ * same) and dimension one indicates the number of time series.
+ * @param minClusterSize        The minimum number of time series of a cluster.
+ * @param minPoints             The number of neighbours defining the core distances, or a negative value to use
+ * minClusterSize.
+ * @param metric                The metric: 0 for euclidean and 1 for z-normalised euclidean.
+ *
+ * @return The reference to the labels of the time series, or -1 for noise.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_hdbscan(JNIEnv *env, jobject, jlong ref_tss,
+                                                                   jint minClusterSize, jint minPoints, jint metric);
+
 #ifdef __cplusplus
 }
 #endif
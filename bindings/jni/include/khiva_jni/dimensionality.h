@@ -13,6 +13,89 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Calculates the k coefficients of the discrete Fourier transform of every time series with the largest
+ * contribution to its energy.
+ *
+ * @param ref Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of coefficients kept, between 1 and n / 2 + 1.
+ *
+ * @return An Array of arrays with the complex coefficients and their frequencies, both k x numOfTs.
+ */
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Dimensionality_dftTopK(JNIEnv *env, jobject, jlong ref, jint k);
+
+/**
+ * @brief Reconstructs the time series from the coefficients of the discrete Fourier transform kept by dftTopK.
+ *
+ * @param ref_coefficients The complex coefficients, k x numOfTs.
+ * @param ref_indexes The frequencies of the coefficients, k x numOfTs.
+ * @param n The length of the time series.
+ *
+ * @return A reference to the reconstructed time series.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_inverseDftTopK(JNIEnv *env, jobject,
+                                                                              jlong ref_coefficients,
+                                                                              jlong ref_indexes, jint n);
+
+/**
+ * @brief Calculates the multi-level discrete wavelet transform of every time series with the lifting scheme.
+ *
+ * [1] I. Daubechies and W. Sweldens. 1998. Factoring wavelet transforms into lifting steps. Journal of Fourier
+ * Analysis and Applications, 4(3), 247-269.
+ *
+ * @param ref Expects an input array whose dimension zero is the length of the time series (all the same), a multiple
+ * of 2^levels, and dimension one indicates the number of time series.
+ * @param wavelet The wavelet: 0 for Haar and 1 for Daubechies D4.
+ * @param levels The number of levels.
+ *
+ * @return A reference to the coefficients of every time series.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_dwt(JNIEnv *env, jobject, jlong ref, jint wavelet,
+                                                                   jint levels);
+
+/**
+ * @brief Reconstructs the time series from the coefficients of their multi-level discrete wavelet transform.
+ *
+ * @param ref The coefficients computed by dwt, with one time series per column.
+ * @param wavelet The wavelet: 0 for Haar and 1 for Daubechies D4.
+ * @param levels The number of levels.
+ *
+ * @return A reference to the reconstructed time series.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_inverseDwt(JNIEnv *env, jobject, jlong ref,
+                                                                          jint wavelet, jint levels);
+
+/**
+ * @brief Largest-Triangle-Three-Buckets (LTTB) downsamples a time series to a fixed number of points for plotting,
+ * keeping from every bucket the point forming the largest triangle with its neighbours.
+ *
+ * [1] S. Steinarsson. 2013. Downsampling Time Series for Visual Representation. MSc thesis, University of Iceland.
+ *
+ * @param ref Expects an input array whose first column is the x coordinate and second column the y coordinate of the
+ * points. Dimension two indicates the number of time series.
+ * @param numPoints Sets the number of points returned, at least 3.
+ *
+ * @return A reference to the reduced points of every time series.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_lttb(JNIEnv *env, jobject, jlong ref,
+                                                                      jint numPoints);
+
+/**
+ * @brief M4 downsamples a time series for a plot with a fixed number of pixel columns, keeping the first, the minimum,
+ * the maximum and the last points of every bucket.
+ *
+ * [1] U. Jugel, Z. Jerzak, G. Hackenbroich and V. Markl. 2014. M4: A Visualization-Oriented Time Series Data
+ * Aggregation. Proceedings of the VLDB Endowment, 7(10), 797-808.
+ *
+ * @param ref Expects an input array whose first column is the x coordinate and second column the y coordinate of the
+ * points. Dimension two indicates the number of time series.
+ * @param buckets The number of buckets, usually the width of the plot in pixels.
+ *
+ * @return A reference to the reduced points of every time series, the shorter ones padded with NaN.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_m4(JNIEnv *env, jobject, jlong ref, jint buckets);
+
 /**
  * @brief Piecewise Aggregate Approximation (PAA) approximates a time series \f$X\f$ of length \f$n\f$ into vector
  * \f$\bar{X}=(\bar{x}_{1},…,\bar{x}_{M})\f$ of any arbitrary length \f$M \leq n\f$ where each of \f$\bar{x_{i}}\f$ is
@@ -115,6 +198,20 @@ JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_ramerDouglasPeuck
 JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_sax(JNIEnv *env, jobject, jlong ref,
                                                                         jint alphabetSize);
 
+/**
+ * @brief Symbolic Aggregate approXimation (SAX) of many time series at once, with the statistics of all of them
+ * computed in a single reduction and a binary search over the breakpoints on the device.
+ *
+ * @param ref Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param alphabetSize Number of element within the alphabet.
+ * @param bins Number of PAA segments of every time series, or zero to map every value.
+ *
+ * @return A reference to an array of symbols, with one column per time series.
+ */
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Dimensionality_saxBatch(JNIEnv *env, jobject, jlong ref,
+                                                                             jint alphabetSize, jint bins);
+
 /**
  * @brief Reduces a set of points by applying the Visvalingam method (minimun triangle area) until the number
  * of points is reduced to numPoints.
@@ -38,6 +38,167 @@ JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeans(JNIEnv *e
     return nullptr;
 }
 
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansRestarts(JNIEnv *env, jobject,
+                                                                               jlong ref_tss, jint k, jint restarts,
+                                                                               jfloat tolerance, jint maxIterations) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+
+        af::array primitive_labels;
+        af::array primitive_centroids;
+        af::array primitive_stats;
+        khiva::clustering::kMeans(arr, k, static_cast<int>(restarts), primitive_centroids, primitive_labels,
+                                  primitive_stats, tolerance, static_cast<int>(maxIterations));
+
+        auto centroids_result = new af::array(primitive_centroids);
+        auto labels_result = new af::array(primitive_labels);
+        auto stats_result = new af::array(primitive_stats);
+
+        constexpr auto output_size = 3;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(centroids_result);
+        output[1] = reinterpret_cast<jlong>(labels_result);
+        output[2] = reinterpret_cast<jlong>(stats_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kMeansRestarts. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansAccelerated(JNIEnv *env, jobject,
+                                                                                  jlong ref_tss, jint k,
+                                                                                  jfloat tolerance,
+                                                                                  jint maxIterations) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+
+        af::array primitive_labels;
+        af::array primitive_centroids;
+        khiva::clustering::kMeansAccelerated(arr, k, primitive_centroids, primitive_labels, tolerance,
+                                             static_cast<int>(maxIterations));
+
+        auto centroids_result = new af::array(primitive_centroids);
+        auto labels_result = new af::array(primitive_labels);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(centroids_result);
+        output[1] = reinterpret_cast<jlong>(labels_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kMeansAccelerated. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansPredict(JNIEnv *env, jobject, jlong ref_tss,
+                                                                              jlong ref_centroids) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+        auto centroids = *reinterpret_cast<af::array *>(ref_centroids);
+
+        af::array primitive_labels;
+        af::array primitive_distances;
+        khiva::clustering::kMeansPredict(arr, centroids, primitive_labels, primitive_distances);
+
+        auto labels_result = new af::array(primitive_labels);
+        auto distances_result = new af::array(primitive_distances);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(labels_result);
+        output[1] = reinterpret_cast<jlong>(distances_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kMeansPredict. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_createKMeansPredictor(JNIEnv *env, jobject,
+                                                                                 jlong ref_centroids) {
+    try {
+        auto centroids = *reinterpret_cast<af::array *>(ref_centroids);
+
+        auto predictor = new khiva::clustering::KMeansPredictor(centroids);
+        return reinterpret_cast<jlong>(predictor);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_createKMeansPredictor. Unknown reason");
+    }
+    return 0;
+}
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMeansPredictorPredict(JNIEnv *env, jobject,
+                                                                                       jlong ref_predictor,
+                                                                                       jlong ref_tss) {
+    try {
+        auto predictor = reinterpret_cast<khiva::clustering::KMeansPredictor *>(ref_predictor);
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+
+        af::array primitive_labels;
+        af::array primitive_distances;
+        predictor->predict(arr, primitive_labels, primitive_distances);
+
+        auto labels_result = new af::array(primitive_labels);
+        auto distances_result = new af::array(primitive_distances);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(labels_result);
+        output[1] = reinterpret_cast<jlong>(distances_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kMeansPredictorPredict. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL Java_io_shapelets_khiva_Clustering_deleteKMeansPredictor(JNIEnv *env, jobject,
+                                                                                jlong ref_predictor) {
+    try {
+        delete reinterpret_cast<khiva::clustering::KMeansPredictor *>(ref_predictor);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_deleteKMeansPredictor. Unknown reason");
+    }
+}
+
 JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShape(JNIEnv *env, jobject, jlong ref_tss, jint k,
                                                                        jfloat tolerance, jint maxIterations) {
     try {
@@ -67,3 +228,215 @@ JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShape(JNIEnv *e
     }
     return nullptr;
 }
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShapeRestarts(JNIEnv *env, jobject,
+                                                                               jlong ref_tss, jint k, jint restarts,
+                                                                               jfloat tolerance, jint maxIterations) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+
+        af::array primitive_labels;
+        af::array primitive_centroids;
+        af::array primitive_stats;
+        khiva::clustering::kShape(arr, k, static_cast<int>(restarts), primitive_centroids, primitive_labels,
+                                  primitive_stats, tolerance, static_cast<int>(maxIterations));
+
+        auto centroids_result = new af::array(primitive_centroids);
+        auto labels_result = new af::array(primitive_labels);
+        auto stats_result = new af::array(primitive_stats);
+
+        constexpr auto output_size = 3;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(centroids_result);
+        output[1] = reinterpret_cast<jlong>(labels_result);
+        output[2] = reinterpret_cast<jlong>(stats_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kShapeRestarts. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShapePredict(JNIEnv *env, jobject, jlong ref_tss,
+                                                                              jlong ref_centroids) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+        auto centroids = *reinterpret_cast<af::array *>(ref_centroids);
+
+        af::array primitive_labels;
+        af::array primitive_distances;
+        khiva::clustering::kShapePredict(arr, centroids, primitive_labels, primitive_distances);
+
+        auto labels_result = new af::array(primitive_labels);
+        auto distances_result = new af::array(primitive_distances);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(labels_result);
+        output[1] = reinterpret_cast<jlong>(distances_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kShapePredict. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_createKShapePredictor(JNIEnv *env, jobject,
+                                                                                 jlong ref_centroids) {
+    try {
+        auto centroids = *reinterpret_cast<af::array *>(ref_centroids);
+
+        auto predictor = new khiva::clustering::KShapePredictor(centroids);
+        return reinterpret_cast<jlong>(predictor);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_createKShapePredictor. Unknown reason");
+    }
+    return 0;
+}
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kShapePredictorPredict(JNIEnv *env, jobject,
+                                                                                       jlong ref_predictor,
+                                                                                       jlong ref_tss) {
+    try {
+        auto predictor = reinterpret_cast<khiva::clustering::KShapePredictor *>(ref_predictor);
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+
+        af::array primitive_labels;
+        af::array primitive_distances;
+        predictor->predict(arr, primitive_labels, primitive_distances);
+
+        auto labels_result = new af::array(primitive_labels);
+        auto distances_result = new af::array(primitive_distances);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(labels_result);
+        output[1] = reinterpret_cast<jlong>(distances_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kShapePredictorPredict. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL Java_io_shapelets_khiva_Clustering_deleteKShapePredictor(JNIEnv *env, jobject,
+                                                                                jlong ref_predictor) {
+    try {
+        delete reinterpret_cast<khiva::clustering::KShapePredictor *>(ref_predictor);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_deleteKShapePredictor. Unknown reason");
+    }
+}
+
+JNIEXPORT jlongArray JNICALL Java_io_shapelets_khiva_Clustering_kMedoids(JNIEnv *env, jobject, jlong ref_distances,
+                                                                         jint k, jboolean condensed,
+                                                                         jint maxIterations) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_distances);
+
+        af::array primitive_medoids;
+        af::array primitive_labels;
+        khiva::clustering::kMedoids(arr, k, primitive_medoids, primitive_labels, condensed == JNI_TRUE,
+                                    static_cast<int>(maxIterations));
+
+        auto medoids_result = new af::array(primitive_medoids);
+        auto labels_result = new af::array(primitive_labels);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(medoids_result);
+        output[1] = reinterpret_cast<jlong>(labels_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_kMedoids. Unknown reason");
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_agglomerative(JNIEnv *env, jobject, jlong ref_distances,
+                                                                         jint method, jboolean condensed) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_distances);
+        auto result = new af::array(khiva::clustering::agglomerative(
+            arr, static_cast<khiva::clustering::Linkage>(method), condensed == JNI_TRUE));
+        return reinterpret_cast<jlong>(result);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_agglomerative. Unknown reason");
+    }
+    return 0;
+}
+
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_dbscan(JNIEnv *env, jobject, jlong ref_tss, jdouble epsilon,
+                                                                  jint minPoints, jint metric) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+        auto result = new af::array(khiva::clustering::dbscan(arr, epsilon, static_cast<int>(minPoints),
+                                                              static_cast<khiva::search::Metric>(metric)));
+        return reinterpret_cast<jlong>(result);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_dbscan. Unknown reason");
+    }
+    return 0;
+}
+
+JNIEXPORT jlong JNICALL Java_io_shapelets_khiva_Clustering_hdbscan(JNIEnv *env, jobject, jlong ref_tss,
+                                                                   jint minClusterSize, jint minPoints, jint metric) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref_tss);
+        auto result =
+            new af::array(khiva::clustering::hdbscan(arr, static_cast<int>(minClusterSize), static_cast<int>(minPoints),
+                                                     static_cast<khiva::search::Metric>(metric)));
+        return reinterpret_cast<jlong>(result);
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Clustering_hdbscan. Unknown reason");
+    }
+    return 0;
+}
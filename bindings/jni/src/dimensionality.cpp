@@ -8,6 +8,72 @@
 #include <khiva_jni/dimensionality.h>
 #include <khiva_jni/internal/utils.h>
 
+#include <array>
+
+jlongArray JNICALL Java_io_shapelets_khiva_Dimensionality_dftTopK(JNIEnv *env, jobject, jlong ref, jint k) {
+    try {
+        auto arr = *reinterpret_cast<af::array *>(ref);
+
+        af::array primitive_coefficients;
+        af::array primitive_indexes;
+        khiva::dimensionality::DFTTopK(arr, k, primitive_coefficients, primitive_indexes);
+
+        auto coefficients_result = new af::array(primitive_coefficients);
+        auto indexes_result = new af::array(primitive_indexes);
+
+        constexpr auto output_size = 2;
+        std::array<jlong, output_size> output;
+        output[0] = reinterpret_cast<jlong>(coefficients_result);
+        output[1] = reinterpret_cast<jlong>(indexes_result);
+
+        auto pointers = env->NewLongArray(output_size);
+        env->SetLongArrayRegion(pointers, 0, output_size, output.data());
+        return pointers;
+    } catch (const std::exception &e) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, e.what());
+    } catch (...) {
+        jclass exceptionClass = env->FindClass("io/shapelets/khiva/KhivaException");
+        env->ThrowNew(exceptionClass, "Error in Dimensionality_dftTopK. Unknown reason");
+    }
+    return nullptr;
+}
+
+jlong JNICALL Java_io_shapelets_khiva_Dimensionality_inverseDftTopK(JNIEnv *env, jobject, jlong ref_coefficients,
+                                                                    jlong ref_indexes, jint n) {
+    return khiva::jni::KhivaCallTwoArrays(env, khiva::dimensionality::inverseDFTTopK, ref_coefficients, ref_indexes,
+                                          n);
+}
+
+jlong JNICALL Java_io_shapelets_khiva_Dimensionality_dwt(JNIEnv *env, jobject, jlong ref, jint wavelet, jint levels) {
+    return khiva::jni::KhivaCall(
+        env,
+        [](const af::array &a, int w, int l) {
+            return khiva::dimensionality::DWT(a, static_cast<khiva::dimensionality::Wavelet>(w), l);
+        },
+        ref, wavelet, levels);
+}
+
+jlong JNICALL Java_io_shapelets_khiva_Dimensionality_inverseDwt(JNIEnv *env, jobject, jlong ref, jint wavelet,
+                                                                jint levels) {
+    return khiva::jni::KhivaCall(
+        env,
+        [](const af::array &a, int w, int l) {
+            return khiva::dimensionality::inverseDWT(a, static_cast<khiva::dimensionality::Wavelet>(w), l);
+        },
+        ref, wavelet, levels);
+}
+
+jlong JNICALL Java_io_shapelets_khiva_Dimensionality_lttb(JNIEnv *env, jobject, jlong ref, jint numPoints) {
+    return khiva::jni::KhivaCall(
+        env, [](const af::array &a, int n) { return khiva::dimensionality::LTTB(a, n); }, ref, numPoints);
+}
+
+jlong JNICALL Java_io_shapelets_khiva_Dimensionality_m4(JNIEnv *env, jobject, jlong ref, jint buckets) {
+    return khiva::jni::KhivaCall(
+        env, [](const af::array &a, int n) { return khiva::dimensionality::M4(a, n); }, ref, buckets);
+}
+
 jlong JNICALL Java_io_shapelets_khiva_Dimensionality_paa(JNIEnv *env, jobject, jlong ref, jint bins) {
     return khiva::jni::KhivaCall(
         env, [](const af::array &a, int bins) { return khiva::dimensionality::PAA(a, bins); }, ref, bins);
@@ -39,6 +105,11 @@ jlong JNICALL Java_io_shapelets_khiva_Dimensionality_sax(JNIEnv *env, jobject, j
     return khiva::jni::KhivaCall(env, khiva::dimensionality::SAX, ref, alphabetSize);
 }
 
+jlong JNICALL Java_io_shapelets_khiva_Dimensionality_saxBatch(JNIEnv *env, jobject, jlong ref, jint alphabetSize,
+                                                              jint bins) {
+    return khiva::jni::KhivaCall(env, khiva::dimensionality::SAXBatch, ref, alphabetSize, bins);
+}
+
 jlong JNICALL Java_io_shapelets_khiva_Dimensionality_visvalingam(JNIEnv *env, jobject, jlong ref, jint numPoints) {
     return khiva::jni::KhivaCall(
         env, [](const af::array &a, int n) { return khiva::dimensionality::visvalingam(a, n); }, ref, numPoints);
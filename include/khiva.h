@@ -17,5 +17,6 @@
 #include <khiva/polynomial.h>
 #include <khiva/regression.h>
 #include <khiva/regularization.h>
+#include <khiva/search.h>
 #include <khiva/statistics.h>
 #include <khiva/version.h>
@@ -9,12 +9,27 @@
 
 #include <arrayfire.h>
 #include <khiva/defines.h>
+#include <khiva/search.h>
 
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 namespace khiva {
 namespace clustering {
 
+/**
+ * @brief Linkage methods of the agglomerative clustering, which define the distance between two clusters.
+ */
+typedef enum {
+    KHIVA_LINKAGE_SINGLE = 0,    ///< Distance between the closest observations of the clusters
+    KHIVA_LINKAGE_COMPLETE = 1,  ///< Distance between the farthest observations of the clusters
+    KHIVA_LINKAGE_AVERAGE = 2,   ///< Average distance between the observations of the clusters (UPGMA)
+    KHIVA_LINKAGE_WARD = 3,      ///< Increase of the within-cluster variance, for euclidean distances
+} khiva_linkage;
+
+typedef khiva_linkage Linkage;
+
 /**
  * @brief Calculates the k-means algorithm.
  *
@@ -32,6 +47,70 @@ namespace clustering {
 KHIVAAPI void kMeans(const af::array &tss, int k, af::array &centroids, af::array &labels,
                      float tolerance = 0.0000000001, int maxIterations = 100);
 
+/**
+ * @brief Calculates the k-means algorithm from several initialisations and keeps the solution with the lowest inertia,
+ * which is the sum of the squared distances of the time series to their centroids. The runs are independent and
+ * execute concurrently on the host threads, which share the backend and device of the caller.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of means to be computed.
+ * @param restarts The number of runs. The first one starts from the given centroids or labels, if any, and the rest
+ * from k-means++ seeds.
+ * @param centroids The resulting means or centroids of the best run.
+ * @param labels The resulting labels of each time series of the best run.
+ * @param stats Receives an array of 2 x restarts with the inertia and the number of iterations of every run.
+ * @param tolerance The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ */
+KHIVAAPI void kMeans(const af::array &tss, int k, int restarts, af::array &centroids, af::array &labels,
+                     af::array &stats, float tolerance = 0.0000000001, int maxIterations = 100);
+
+/**
+ * @brief Calculates the k-means algorithm with Hamerly's acceleration. Every time series keeps bounds of the distances
+ * to its centroid and to the rest of the centroids, which are updated with the movement of the centroids, and its
+ * distances are only computed when the bounds cannot prove that its label is unchanged. It performs the same iterations
+ * and gives the same result as kMeans, using multiple host threads. Both decide the time series whose two closest
+ * centroids are within the rounding error of the distances by computing them directly in double precision.
+ *
+ * [1] G. Hamerly. 2010. Making k-means even faster. Proceedings of the 2010 SIAM International Conference on Data
+ * Mining, Pages 130-140.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of means to be computed.
+ * @param centroids The resulting means or centroids.
+ * @param labels The resulting labels of each time series which is the closest centroid.
+ * @param tolerance The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ */
+KHIVAAPI void kMeansAccelerated(const af::array &tss, int k, af::array &centroids, af::array &labels,
+                                float tolerance = 0.0000000001, int maxIterations = 100);
+
+/**
+ * @brief Calculates the mini-batch k-means algorithm. The time series are read in batches from a callback, every
+ * batch is assigned to the closest centroids and every centroid moves towards its time series with a learning rate of
+ * one over the number of time series it has been assigned so far. Only one batch is resident at a time, and passing
+ * the centroids and counts of a previous call continues the clustering with new data.
+ *
+ * [1] D. Sculley. 2010. Web-scale k-means clustering. Proceedings of the 19th international conference on World Wide
+ * Web, Pages 1177-1178.
+ *
+ * @param nextBatch Callback returning the next batch of time series, whose dimension zero is the length of the time
+ * series and dimension one indicates the number of time series, or an empty array when there is no more data.
+ * @param k The number of means to be computed.
+ * @param centroids The centroids to start from, which receive the resulting centroids. If it is empty, they are
+ * seeded with k-means++ on the first batch.
+ * @param counts The number of time series assigned to every centroid so far as an array of 1 x k, which receives the
+ * updated counts. If it is empty, the counts start at zero.
+ * @param tolerance If positive, the computation stops after a batch moves the centroids no more than it. Otherwise,
+ * the batches are read until the callback returns an empty array or maxBatches is reached.
+ * @param maxBatches The maximum number of batches read. A negative value reads until the callback returns an empty
+ * array.
+ */
+KHIVAAPI void miniBatchKMeans(const std::function<af::array()> &nextBatch, int k, af::array &centroids,
+                              af::array &counts, float tolerance = 0.0f, int maxBatches = -1);
+
 /**
  * @brief Calculates the k-shape algorithm.
  *
@@ -49,6 +128,219 @@ KHIVAAPI void kMeans(const af::array &tss, int k, af::array &centroids, af::arra
 KHIVAAPI void kShape(const af::array &tss, int k, af::array &centroids, af::array &labels,
                      float tolerance = 0.0000000001, int maxIterations = 100);
 
+/**
+ * @brief Calculates the k-shape algorithm from several initialisations and keeps the solution with the lowest sum of
+ * shape-based distances of the time series to their centroids. The runs are independent and execute concurrently on
+ * the host threads, which share the backend and device of the caller, and the spectra of the time series are computed
+ * once for all of them.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of means to be computed.
+ * @param restarts The number of runs. The first one starts from the given centroids and labels, if any, and the rest
+ * from random labels.
+ * @param centroids The resulting means or centroids of the best run.
+ * @param labels The resulting labels of each time series of the best run.
+ * @param stats Receives an array of 2 x restarts with the sum of shape-based distances and the number of iterations of
+ * every run.
+ * @param tolerance The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ */
+KHIVAAPI void kShape(const af::array &tss, int k, int restarts, af::array &centroids, af::array &labels,
+                     af::array &stats, float tolerance = 0.0000000001, int maxIterations = 100);
+
+/**
+ * @brief Calculates the k-medoids clustering with FasterPAM over a distance matrix, so any measure of the distances
+ * module can be used. The medoids are time series of the input, and they are improved by swapping them with the rest
+ * of time series while the sum of the distances to the nearest medoid decreases. The swap candidates are evaluated
+ * concurrently on the host threads.
+ *
+ * [1] E. Schubert and P. J. Rousseeuw. 2021. Fast and eager k-medoids clustering: O(k) runtime improvement of the
+ * PAM, CLARA, and CLARANS algorithms. Information Systems, 101, 101804.
+ *
+ * @param distances The distances between the time series, either as a numOfTs x numOfTs matrix of which only the
+ * upper triangle is read, as returned by the distances module, or as a condensed vector.
+ * @param k The number of medoids to be computed.
+ * @param medoids The initial medoids as an array of k positions of time series, which receives the resulting medoids
+ * as an array of 1 x k. If it is empty, the initial medoids are chosen with k-means++ seeding.
+ * @param labels The resulting labels of each time series, which is the position of its closest medoid in medoids.
+ * @param condensed If true, distances is a condensed vector of numOfTs * (numOfTs - 1) / 2 elements in the layout
+ * used by scipy.spatial.distance.pdist.
+ * @param maxIterations The maximum number of passes over the swap candidates.
+ */
+KHIVAAPI void kMedoids(const af::array &distances, int k, af::array &medoids, af::array &labels,
+                       bool condensed = false, int maxIterations = 100);
+
+/**
+ * @brief Calculates the k-medoids clustering with FasterPAM over a distance function, which is called when a distance
+ * is needed instead of storing all of them. Only the distances to the current medoids are kept, in O(n * k) memory.
+ *
+ * [1] E. Schubert and P. J. Rousseeuw. 2021. Fast and eager k-medoids clustering: O(k) runtime improvement of the
+ * PAM, CLARA, and CLARANS algorithms. Information Systems, 101, 101804.
+ *
+ * @param n The number of time series.
+ * @param distance Function returning the distance between the time series i and j, with i < j. It is called from
+ * several threads at once.
+ * @param k The number of medoids to be computed.
+ * @param medoids The initial medoids as an array of k positions of time series, which receives the resulting medoids
+ * as an array of 1 x k. If it is empty, the initial medoids are chosen with k-means++ seeding.
+ * @param labels The resulting labels of each time series, which is the position of its closest medoid in medoids.
+ * @param maxIterations The maximum number of passes over the swap candidates.
+ */
+KHIVAAPI void kMedoids(int64_t n, const std::function<double(int64_t, int64_t)> &distance, int k,
+                       af::array &medoids, af::array &labels, int maxIterations = 100);
+
+/**
+ * @brief Calculates the hierarchical agglomerative clustering of the time series, which merges the two closest
+ * clusters until there is only one. Single linkage is computed from the minimum spanning tree and the rest of methods
+ * with the nearest-neighbour chain algorithm, all of them in O(n^2) time working on the condensed distances.
+ *
+ * [1] D. Müllner. 2011. Modern hierarchical, agglomerative clustering algorithms. arXiv:1109.2378.
+ *
+ * @param distances The distances between the time series, either as a numOfTs x numOfTs matrix of which only the
+ * upper triangle is read, as returned by the distances module, or as a condensed vector, which needs half the memory.
+ * @param method The linkage method.
+ * @param condensed If true, distances is a condensed vector of numOfTs * (numOfTs - 1) / 2 elements in the layout
+ * used by scipy.spatial.distance.pdist.
+ *
+ * @return The linkage matrix of (numOfTs - 1) x 4 in the format of scipy.cluster.hierarchy.linkage. Row i merges the
+ * clusters in columns 0 and 1 (the smaller first) at the distance in column 2, forming the cluster numOfTs + i with
+ * the number of time series in column 3. The clusters 0 to numOfTs - 1 are the time series.
+ */
+KHIVAAPI af::array agglomerative(const af::array &distances, Linkage method = KHIVA_LINKAGE_AVERAGE,
+                                 bool condensed = false);
+
+/**
+ * @brief Calculates the DBSCAN clustering. The time series with at least minPoints time series within a distance of
+ * epsilon, counting themselves, are core points, the core points within epsilon of each other form the clusters and
+ * the rest of time series join the cluster of their closest core point within epsilon or are labeled as noise. The
+ * neighbourhoods are found with range queries on a vantage-point tree, which run concurrently, so the distance matrix
+ * is never built.
+ *
+ * [1] M. Ester, H.-P. Kriegel, J. Sander and X. Xu. 1996. A density-based algorithm for discovering clusters in large
+ * spatial databases with noise. Proceedings of the Second International Conference on Knowledge Discovery and Data
+ * Mining, Pages 226-231.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param epsilon The radius of the neighbourhoods.
+ * @param minPoints The minimum number of time series in the neighbourhood of a core point.
+ * @param metric The metric used to compare the time series.
+ *
+ * @return An array of 1 x numOfTs with the label of every time series, numbered from zero in the order of their first
+ * time series, or -1 for noise.
+ */
+KHIVAAPI af::array dbscan(const af::array &tss, double epsilon, int minPoints,
+                          search::Metric metric = search::KHIVA_METRIC_EUCLIDEAN);
+
+/**
+ * @brief Calculates the HDBSCAN clustering, which finds clusters of varying densities without a radius. The core
+ * distance of every time series is the distance to its minPoints-th nearest neighbour, found with a vantage-point
+ * tree, and the single linkage tree of the mutual reachability distances max(core(a), core(b), d(a, b)) is built with
+ * a minimum spanning tree whose distances are computed when needed, by multiple threads once there are enough of them
+ * in a step. The tree is condensed to the splits with at least minClusterSize time series on both sides and the most
+ * stable clusters are selected.
+ *
+ * [1] R. J. G. B. Campello, D. Moulavi and J. Sander. 2013. Density-based clustering based on hierarchical density
+ * estimates. Advances in Knowledge Discovery and Data Mining, Pages 160-172.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param minClusterSize The minimum number of time series of a cluster.
+ * @param minPoints The number of neighbours defining the core distances. If it is negative, minClusterSize is used.
+ * @param metric The metric used to compare the time series.
+ *
+ * @return An array of 1 x numOfTs with the label of every time series, numbered from zero in the order of their first
+ * time series, or -1 for noise.
+ */
+KHIVAAPI af::array hdbscan(const af::array &tss, int minClusterSize, int minPoints = -1,
+                           search::Metric metric = search::KHIVA_METRIC_EUCLIDEAN);
+
+/**
+ * @brief Labels new time series with the closest of the centroids computed by kMeans. The squared norms of the
+ * centroids are computed once, so every call only takes a matrix multiplication and a reduction on the device. The
+ * time series within the rounding error of a tie are decided on the host in double precision, as kMeans does.
+ */
+class KHIVAAPI KMeansPredictor {
+   public:
+    /**
+     * @brief Prepares the predictor.
+     *
+     * @param centroids The centroids computed by kMeans.
+     */
+    explicit KMeansPredictor(const af::array &centroids);
+
+    /**
+     * @brief Labels a batch of time series.
+     *
+     * @param tss Expects an input array whose dimension zero is the length of the centroids and dimension one
+     * indicates the number of time series.
+     * @param labels Receives an array of 1 x numOfTs with the closest centroid of every time series, as kMeans.
+     * @param distances Receives an array of 1 x numOfTs with the euclidean distance to the closest centroid.
+     */
+    void predict(const af::array &tss, af::array &labels, af::array &distances) const;
+
+   private:
+    af::array centroids;
+    af::array centroidsNorms;
+};
+
+/**
+ * @brief Labels new time series with the centroid computed by kShape at the lowest shape-based distance. The spectra
+ * and norms of the centroids are computed once, so every call only transforms the new time series and computes their
+ * cross-correlations on the device.
+ */
+class KHIVAAPI KShapePredictor {
+   public:
+    /**
+     * @brief Prepares the predictor.
+     *
+     * @param centroids The centroids computed by kShape.
+     */
+    explicit KShapePredictor(const af::array &centroids);
+
+    /**
+     * @brief Labels a batch of time series.
+     *
+     * @param tss Expects an input array whose dimension zero is the length of the centroids and dimension one
+     * indicates the number of time series.
+     * @param labels Receives an array of numOfTs x 1 with the closest centroid of every time series, as kShape.
+     * @param distances Receives an array of numOfTs x 1 with the shape-based distance to the closest centroid.
+     */
+    void predict(const af::array &tss, af::array &labels, af::array &distances) const;
+
+   private:
+    dim_t length;
+    af::array centroidsSpectra;
+    af::array centroidsNorms;
+};
+
+/**
+ * @brief Labels new time series with the closest of the centroids computed by kMeans, without any iteration. Use
+ * KMeansPredictor to label several batches with the same centroids.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the centroids and dimension one indicates
+ * the number of time series.
+ * @param centroids The centroids computed by kMeans.
+ * @param labels Receives an array of 1 x numOfTs with the closest centroid of every time series.
+ * @param distances Receives an array of 1 x numOfTs with the euclidean distance to the closest centroid.
+ */
+KHIVAAPI void kMeansPredict(const af::array &tss, const af::array &centroids, af::array &labels,
+                            af::array &distances);
+
+/**
+ * @brief Labels new time series with the centroid computed by kShape at the lowest shape-based distance, without any
+ * iteration. Use KShapePredictor to label several batches with the same centroids.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the centroids and dimension one indicates
+ * the number of time series.
+ * @param centroids The centroids computed by kShape.
+ * @param labels Receives an array of numOfTs x 1 with the closest centroid of every time series.
+ * @param distances Receives an array of numOfTs x 1 with the shape-based distance to the closest centroid.
+ */
+KHIVAAPI void kShapePredict(const af::array &tss, const af::array &centroids, af::array &labels,
+                            af::array &distances);
+
 }  // namespace clustering
 }  // namespace khiva
 
@@ -10,6 +10,7 @@
 #include <arrayfire.h>
 #include <khiva/defines.h>
 
+#include <functional>
 #include <vector>
 
 namespace khiva {
@@ -20,6 +21,248 @@ using Point = std::pair<float, float>;
 
 using Segment = std::pair<int, int>;
 
+/**
+ * @brief Wavelets of the discrete wavelet transform.
+ */
+typedef enum {
+    KHIVA_WAVELET_HAAR = 0,         ///< Haar wavelet
+    KHIVA_WAVELET_DAUBECHIES4 = 1,  ///< Daubechies wavelet with four coefficients (D4)
+} khiva_wavelet;
+
+typedef khiva_wavelet Wavelet;
+
+/**
+ * @brief Calculates the k coefficients of the discrete Fourier transform of every time series with the largest
+ * contribution to its energy, which reduce the time series for indexing and compression. Only the non-redundant half
+ * of the spectrum of the real time series is considered, and the coefficients other than the mean and the Nyquist
+ * frequency weight twice as their conjugates are dropped with them. All the time series are computed at once.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param k The number of coefficients kept, between 1 and n / 2 + 1.
+ * @param coefficients The resulting complex coefficients, k x numOfTs, sorted by decreasing energy.
+ * @param indexes The resulting frequencies of the coefficients, k x numOfTs.
+ */
+KHIVAAPI void DFTTopK(const af::array &tss, int k, af::array &coefficients, af::array &indexes);
+
+/**
+ * @brief Reconstructs the time series from the coefficients of the discrete Fourier transform kept by DFTTopK, with
+ * the rest of them set to zero.
+ *
+ * @param coefficients The complex coefficients, k x numOfTs.
+ * @param indexes The frequencies of the coefficients, k x numOfTs.
+ * @param n The length of the time series.
+ *
+ * @return af::array The reconstructed time series, n x numOfTs.
+ */
+KHIVAAPI af::array inverseDFTTopK(const af::array &coefficients, const af::array &indexes, int n);
+
+/**
+ * @brief Calculates the multi-level discrete wavelet transform of every time series with the lifting scheme, which
+ * takes O(n) operations. Every level splits the approximation of the previous one into its even and odd elements, and
+ * the lifting steps are applied to all the time series at once. The boundaries are periodic and the transform is
+ * orthonormal, so the energy of the time series is kept.
+ *
+ * [1] I. Daubechies and W. Sweldens. 1998. Factoring wavelet transforms into lifting steps. Journal of Fourier
+ * Analysis and Applications, 4(3), 247-269.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same), a multiple
+ * of 2^levels, and dimension one indicates the number of time series.
+ * @param wavelet The wavelet.
+ * @param levels The number of levels.
+ *
+ * @return af::array The coefficients of every time series, with the approximation of the last level first and then
+ * the details from the last level to the first one.
+ */
+KHIVAAPI af::array DWT(const af::array &tss, Wavelet wavelet = KHIVA_WAVELET_HAAR, int levels = 1);
+
+/**
+ * @brief Reconstructs the time series from the coefficients of their multi-level discrete wavelet transform.
+ *
+ * @param coefficients The coefficients computed by DWT, with one time series per column.
+ * @param wavelet The wavelet.
+ * @param levels The number of levels.
+ *
+ * @return af::array The reconstructed time series.
+ */
+KHIVAAPI af::array inverseDWT(const af::array &coefficients, Wavelet wavelet = KHIVA_WAVELET_HAAR, int levels = 1);
+
+using PointCallback = std::function<void(const Point &point)>;
+
+/**
+ * @brief Largest-Triangle-Three-Buckets (LTTB) downsamples a time series to a fixed number of points for plotting.
+ * The first and the last points are kept, and the rest are split into numPoints - 2 buckets of the same number of
+ * points. From every bucket, the point forming the largest triangle with the point selected from the previous bucket
+ * and the average of the next bucket is selected. It runs in a single pass over the points.
+ *
+ * [1] S. Steinarsson. 2013. Downsampling Time Series for Visual Representation. MSc thesis, University of Iceland.
+ *
+ * @param ts Expects an input vector containing the set of points to be reduced, sorted by their first component.
+ * @param numPoints Sets the number of points returned, at least 3.
+ *
+ * @return std::vector Vector with the reduced number of points, or the input if it has no more than numPoints.
+ */
+KHIVAAPI std::vector<Point> LTTB(const std::vector<Point> &ts, int64_t numPoints);
+
+/**
+ * @brief Largest-Triangle-Three-Buckets (LTTB) downsamples a time series to a fixed number of points for plotting.
+ * The first and the last points are kept, and the rest are split into numPoints - 2 buckets of the same number of
+ * points. From every bucket, the point forming the largest triangle with the point selected from the previous bucket
+ * and the average of the next bucket is selected. It runs in a single pass over the points.
+ *
+ * [1] S. Steinarsson. 2013. Downsampling Time Series for Visual Representation. MSc thesis, University of Iceland.
+ *
+ * @param ts Expects an af::array containing the set of points to be reduced. The first component of the points in
+ * the first column and the second component of the points in the second column. Dimension two indicates the number
+ * of time series, which are processed in parallel.
+ * @param numPoints Sets the number of points returned, at least 3.
+ *
+ * @return af::array with the reduced number of points of every time series.
+ */
+KHIVAAPI af::array LTTB(const af::array &ts, int numPoints);
+
+/**
+ * @brief Streaming Largest-Triangle-Three-Buckets (LTTB). The length of the time series is known beforehand and its
+ * points are added one at a time or in chunks, every selected point is handed to a callback. Only the points of two
+ * buckets are held in memory. The points are the same as the ones of LTTB.
+ */
+class KHIVAAPI LTTBDownsampler {
+   public:
+    /**
+     * @brief Creates a downsampler.
+     *
+     * @param length The number of points of the time series.
+     * @param numPoints The number of points selected, at least 3.
+     * @param callback Function called with every selected point, in order.
+     */
+    LTTBDownsampler(int64_t length, int64_t numPoints, PointCallback callback);
+
+    /**
+     * @brief Adds the next point of the time series. A point is emitted once the bucket after its own is complete.
+     * After the last point, the downsampler is ready for a new time series.
+     *
+     * @param point The next point.
+     */
+    void add(const Point &point);
+
+    /**
+     * @brief Adds the next chunk of points of the time series.
+     *
+     * @param points The next points.
+     */
+    void add(const std::vector<Point> &points);
+
+   private:
+    int64_t bucketStart(int64_t bucket) const;
+
+    void select(double averageX, double averageY);
+
+    int64_t length;
+    int64_t numPoints;
+    PointCallback callback;
+    // number of points added, and bucket being filled with the end of its range
+    int64_t index = 0;
+    int64_t bucket = 0;
+    int64_t bucketEnd = 0;
+    // last selected point
+    Point previous;
+    // complete bucket waiting for the average of the one being filled, and the sums of the latter
+    std::vector<Point> candidates;
+    std::vector<Point> filling;
+    double sumX = 0.0;
+    double sumY = 0.0;
+};
+
+/**
+ * @brief M4 downsamples a time series for a plot with a fixed number of pixel columns. The range of the first
+ * component is split into buckets of the same width, and the first, the minimum, the maximum and the last points of
+ * every bucket are kept in their original order, so the rasterised line is the same as the one of the whole time
+ * series. It runs in a single pass over the points.
+ *
+ * [1] U. Jugel, Z. Jerzak, G. Hackenbroich and V. Markl. 2014. M4: A Visualization-Oriented Time Series Data
+ * Aggregation. Proceedings of the VLDB Endowment, 7(10), 797-808.
+ *
+ * @param ts Expects an input vector containing the set of points to be reduced, sorted by their first component.
+ * @param buckets The number of buckets, usually the width of the plot in pixels.
+ *
+ * @return std::vector Vector with at most 4 points per bucket.
+ */
+KHIVAAPI std::vector<Point> M4(const std::vector<Point> &ts, int64_t buckets);
+
+/**
+ * @brief M4 downsamples a time series for a plot with a fixed number of pixel columns. The range of the first
+ * component is split into buckets of the same width, and the first, the minimum, the maximum and the last points of
+ * every bucket are kept in their original order, so the rasterised line is the same as the one of the whole time
+ * series. It runs in a single pass over the points.
+ *
+ * [1] U. Jugel, Z. Jerzak, G. Hackenbroich and V. Markl. 2014. M4: A Visualization-Oriented Time Series Data
+ * Aggregation. Proceedings of the VLDB Endowment, 7(10), 797-808.
+ *
+ * @param ts Expects an af::array containing the set of points to be reduced. The first component of the points in
+ * the first column and the second component of the points in the second column. Dimension two indicates the number
+ * of time series, which are processed in parallel.
+ * @param buckets The number of buckets, usually the width of the plot in pixels.
+ *
+ * @return af::array with at most 4 points per bucket of every time series. The shorter ones are padded with NaN.
+ */
+KHIVAAPI af::array M4(const af::array &ts, int buckets);
+
+/**
+ * @brief Streaming M4. The range of the first component is known beforehand and the points are added one at a time
+ * or in chunks, the points kept from every bucket are handed to a callback as soon as the bucket is complete. Only
+ * four points are held in memory. The points are the same as the ones of M4 over the same range.
+ */
+class KHIVAAPI M4Downsampler {
+   public:
+    /**
+     * @brief Creates a downsampler.
+     *
+     * @param start The first component of the first point of the plot.
+     * @param end The first component of the last point of the plot.
+     * @param buckets The number of buckets, usually the width of the plot in pixels.
+     * @param callback Function called with every kept point, in order.
+     */
+    M4Downsampler(double start, double end, int64_t buckets, PointCallback callback);
+
+    /**
+     * @brief Adds the next point of the time series. The points out of the range go to the closest bucket.
+     *
+     * @param point The next point.
+     */
+    void add(const Point &point);
+
+    /**
+     * @brief Adds the next chunk of points of the time series.
+     *
+     * @param points The next points.
+     */
+    void add(const std::vector<Point> &points);
+
+    /**
+     * @brief Emits the points of the last bucket, and leaves the downsampler ready for a new time series.
+     */
+    void flush();
+
+   private:
+    int64_t bucketOf(float x) const;
+
+    void emit();
+
+    double start;
+    double end;
+    int64_t buckets;
+    PointCallback callback;
+    // number of points added, and bucket being filled with its number of points
+    int64_t index = 0;
+    int64_t bucket = 0;
+    int64_t count = 0;
+    // first, minimum, maximum and last points of the bucket with their positions
+    std::pair<int64_t, Point> first;
+    std::pair<int64_t, Point> minimum;
+    std::pair<int64_t, Point> maximum;
+    std::pair<int64_t, Point> last;
+};
+
 /**
  * @brief Piecewise Aggregate Approximation (PAA) approximates a time series \f$X\f$ of length \f$n\f$ into vector
  * \f$\bar{X}=(\bar{x}_{1},…,\bar{x}_{M})\f$ of any arbitrary length \f$M \leq n\f$ where each of \f$\bar{x_{i}}\f$ is
@@ -49,7 +292,11 @@ KHIVAAPI std::vector<Point> PAA(const std::vector<Point> &points, int bins);
  * time series into \f$M\f$ equally sized frames and secondly compute the mean values for each frame. The sequence
  * assembled from the mean values is the PAA approximation (i.e., transform) of the original time series.
  *
- * @param a Set of points.
+ * When \f$n\f$ is not a multiple of \f$M\f$, the elements at the boundaries of the frames are split between them
+ * with fractional weights. All the columns are computed at once on the device from prefix sums.
+ *
+ * @param a Set of points, with one time series per column. Any numeric type, integers are averaged in single
+ * precision.
  * @param bins Sets the total number of divisions.
  *
  * @return af::array An array of points with the reduced dimensionality.
@@ -62,10 +309,14 @@ KHIVAAPI af::array PAA(const af::array &a, int bins);
  * [1] Fu TC, Chung FL, Luk R, and Ng CM. Representing financial time series based on data point importance.
  * Engineering Applications of Artificial Intelligence, 21(2):277-300, 2008.
  *
- * @param ts Expects an input array whose dimension zero is the length of the time series.
+ * Every segment between two selected points keeps its farthest point in a heap, so each new point only requires a
+ * scan of the segment that it splits. Several time series are processed in parallel.
+ *
+ * @param ts Expects an input array whose dimension zero is the length of the time series, dimension one holds the
+ * x and y axes and dimension two indicates the number of time series.
  * @param numberIPs The number of points to be returned.
  *
- * @return af::array Array with the most Perceptually Important numPoints.
+ * @return af::array Array with the most Perceptually Important numPoints of every time series.
  */
 KHIVAAPI af::array PIP(const af::array &ts, int numberIPs);
 
@@ -88,11 +339,15 @@ KHIVAAPI std::vector<Point> PLABottomUp(const std::vector<Point> &ts, float maxE
  * [1] Zhu Y, Wu D, Li Sh (2007). A Piecewise Linear Representation Method of Time Series Based on Feature Points.
  * Knowledge-Based Intelligent Information and Engineering Systems 4693:1066-1072.
  *
+ * The merge costs are kept in an indexed heap and the error of every segment is computed in constant time from prefix
+ * sums, so only the neighbours of a merge are updated. Several time series are processed in parallel.
+ *
  * @param ts Expects an af::array containing the set of points to be reduced. The first component of the points in
- * the first column and the second component of the points in the second column.
+ * the first column and the second component of the points in the second column. Dimension two indicates the number
+ * of time series.
  * @param maxError The maximum approximation error allowed.
  *
- * @return af::array with the reduced number of points.
+ * @return af::array with the reduced number of points of every time series. The shorter ones are padded with NaN.
  */
 KHIVAAPI af::array PLABottomUp(const af::array &ts, float maxError);
 
@@ -116,13 +371,66 @@ KHIVAAPI std::vector<Point> PLASlidingWindow(const std::vector<Point> &ts, float
  * Knowledge-Based Intelligent Information and Engineering Systems 4693:1066-1072.
  *
  * @param ts Expects an af::array containing the set of points to be reduced. The first component of the points in
- * the first column and the second component of the points in the second column.
+ * the first column and the second component of the points in the second column. Dimension two indicates the number
+ * of time series, which are processed in parallel.
  * @param maxError The maximum approximation error allowed.
  *
- * @return af::array with the reduced number of points.
+ * @return af::array with the reduced number of points of every time series. The shorter ones are padded with NaN.
  */
 KHIVAAPI af::array PLASlidingWindow(const af::array &ts, float maxError);
 
+/**
+ * @brief Online Piecewise Linear Approximation (PLA Sliding Window). The points are added one at a time and every
+ * closed segment is handed to a callback, so the time series is never held in memory. The window keeps the running
+ * sums of x, y, x^2, xy and y^2 relative to its first point, so adding a point costs O(1). The segments are the same
+ * as the ones of PLASlidingWindow.
+ */
+class KHIVAAPI PLASegmenter {
+   public:
+    using SegmentCallback = std::function<void(const Point &start, const Point &end)>;
+
+    /**
+     * @brief Creates a segmenter.
+     *
+     * @param maxError The maximum approximation error allowed.
+     * @param callback Function called with the first and the last point of every closed segment.
+     */
+    PLASegmenter(float maxError, SegmentCallback callback);
+
+    /**
+     * @brief Adds the next point of the time series. A segment is emitted, at the latest, when the point after the
+     * one that closes it is added.
+     *
+     * @param point The next point.
+     */
+    void add(const Point &point);
+
+    /**
+     * @brief Emits the pending segments as the end of the time series, and leaves the segmenter ready for a new one.
+     */
+    void flush();
+
+   private:
+    void startWindow(const Point &point);
+
+    float maxError;
+    SegmentCallback callback;
+    // first and last point of the current window
+    Point anchor;
+    Point last;
+    // number of points and sums of the current window, shifted to the anchor
+    int64_t count = 0;
+    double sumX = 0.0;
+    double sumY = 0.0;
+    double sumXX = 0.0;
+    double sumXY = 0.0;
+    double sumYY = 0.0;
+    // segment closed by the last point, which is only known once it is not the end of the time series
+    bool closed = false;
+    Point closedStart;
+    Point closedEnd;
+};
+
 /**
  * @brief The Ramer–Douglas–Peucker algorithm (RDP) is an algorithm for reducing the number of points in a curve
  * that is approximated by a series of points. It reduces a set of points depending on the perpendicular distance of the
@@ -134,6 +442,8 @@ KHIVAAPI af::array PLASlidingWindow(const af::array &ts, float maxError);
  * [2] David Douglas & Thomas Peucker, "Algorithms for the reduction of the number of points required to represent a
  * digitized line or its caricature", The Canadian Cartographer 10(2), 112–122 (1973) doi:10.3138/FM57-6770-U75U-7727
  *
+ * The segments are split without recursion, and the farthest points of large segments are searched in parallel.
+ *
  * @param pointList Set of input points.
  * @param epsilon It acts as the threshold value to decide which points should be considered meaningful or not.
  *
@@ -152,10 +462,13 @@ KHIVAAPI std::vector<Point> ramerDouglasPeucker(const std::vector<Point> &pointL
  * [2] David Douglas & Thomas Peucker, "Algorithms for the reduction of the number of points required to represent a
  * digitized line or its caricature", The Canadian Cartographer 10(2), 112–122 (1973) doi:10.3138/FM57-6770-U75U-7727
  *
- * @param pointList Set of input points.
+ * Several time series are processed in parallel.
+ *
+ * @param pointList Set of input points, with the x coordinates in the first column and the y coordinates in the second
+ * one. Dimension two indicates the number of time series.
  * @param epsilon It acts as the threshold value to decide which points should be considered meaningful or not.
  *
- * @return af::array with the selected points.
+ * @return af::array with the selected points of every time series. The shorter ones are padded with NaN.
  */
 KHIVAAPI af::array ramerDouglasPeucker(const af::array &pointList, double epsilon);
 
@@ -178,6 +491,24 @@ KHIVAAPI af::array ramerDouglasPeucker(const af::array &pointList, double epsilo
  */
 KHIVAAPI af::array SAX(const af::array &a, int alphabetSize);
 
+/**
+ * @brief Symbolic Aggregate approXimation (SAX) of many time series at once. The mean and standard deviation of all
+ * the time series are computed in a single reduction, and the values are mapped to symbols with a binary search over
+ * the breakpoints of every time series on the device. The values can be reduced with PAA before being mapped.
+ *
+ * [1] Lin, J., Keogh, E., Lonardi, S. & Chiu, B. (2003) A Symbolic Representation of Time Series, with Implications for
+ * Streaming Algorithms. In proceedings of the 8th ACM SIGMOD Workshop on Research Issues in Data Mining and Knowledge
+ * Discovery. San Diego, CA. June 13.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param alphabetSize Number of element within the alphabet.
+ * @param bins Number of PAA segments of every time series, or zero to map every value.
+ *
+ * @return An array of s32 symbols, with one column per time series.
+ */
+KHIVAAPI af::array SAXBatch(const af::array &tss, int alphabetSize, int bins = 0);
+
 /**
  * @brief Reduces a set of points by applying the Visvalingam method (minimum triangle area) until the number
  * of points is reduced to numPoints.
@@ -201,11 +532,13 @@ KHIVAAPI std::vector<Point> visvalingam(const std::vector<Point> &pointList, int
  * [1] M. Visvalingam and J. D. Whyatt, Line generalisation by repeated elimination of points,
  * The Cartographic Journal, 1993.
  *
+ * Several time series are processed in parallel.
+ *
  * @param pointList Expects an input array formed by to columns where the first column is interpreted as the x cordinate
- * of a point and the second column as the y coordinate.
+ * of a point and the second column as the y coordinate. Dimension two indicates the number of time series.
  * @param numPoints Sets the number of points returned after the execution of the method.
  *
- * @return af::array where the number of points has been reduced to numPoints.
+ * @return af::array where the number of points of every time series has been reduced to numPoints.
  */
 KHIVAAPI af::array visvalingam(const af::array &pointList, int numPoints);
 
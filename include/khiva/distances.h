@@ -10,6 +10,11 @@
 #include <arrayfire.h>
 #include <khiva/defines.h>
 
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
 namespace khiva {
 
 namespace distances {
@@ -36,41 +41,189 @@ KHIVAAPI double dtw(const std::vector<double> &a, const std::vector<double> &b);
  */
 KHIVAAPI af::array dtw(const af::array &tss);
 
+/**
+ * @brief Calculates the Edit Distance with Real Penalty (ERP). Gaps are penalised with the distance to the constant g.
+ *
+ * @param a The first time series.
+ * @param b The second time series.
+ * @param g The value compared against the elements aligned to a gap.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). It is
+ * widened to the difference of lengths and a negative value explores the whole matrix.
+ * @param upperBound The computation is abandoned as soon as the distance is known to be greater than this value.
+ *
+ * @return The ERP distance between a and b, or infinity if it is greater than upperBound.
+ */
+KHIVAAPI double erp(const std::vector<double> &a, const std::vector<double> &b, double g = 0.0, int band = -1,
+                    double upperBound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Calculates the Edit Distance with Real Penalty (ERP). Gaps are penalised with the distance to the constant g.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param g The value compared against the elements aligned to a gap.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). A
+ * negative value explores the whole matrix.
+ *
+ * @return af::array An upper triangular matrix where each position corresponds to the distance between
+ * two time series. Diagonal elements will be zero. The pairs are computed in parallel.
+ */
+KHIVAAPI af::array erp(const af::array &tss, double g = 0.0, int band = -1);
+
 /**
  * @brief Calculates euclidean distances between time series.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
  * dimension one indicates the number of time series.
+ * @param condensed If true, the distances are returned as a condensed vector of numOfTs * (numOfTs - 1) / 2
+ * elements instead of a numOfTs x numOfTs matrix. The distance between time series i and j (i < j) is stored at
+ * position numOfTs * i - i * (i + 1) / 2 + j - i - 1, which is the layout used by scipy.spatial.distance.pdist.
  *
  * @return af::array An upper triangular matrix where each position corresponds to the distance between two
  * time series. Diagonal elements will be zero. For example: Position row 0 column 1 records the distance
- * between time series 0 and time series 1.
+ * between time series 0 and time series 1. Or the condensed vector of distances if condensed is true.
  */
-KHIVAAPI af::array euclidean(const af::array &tss);
+KHIVAAPI af::array euclidean(const af::array &tss, bool condensed = false);
+
+/**
+ * @brief Calculates an approximation of the Dynamic Time Warping Distance with FastDTW. Both time series are halved
+ * with dimensionality::PAA until they are shorter than radius + 2, the DTW of the coarsest level is computed completely
+ * and, at every finer level, only the cells around the warping path of the previous level projected and expanded by
+ * radius are explored. It runs in linear time and memory.
+ *
+ * [1] Salvador S, Chan P (2007). Toward accurate dynamic time warping in linear time and space. Intelligent Data
+ * Analysis 11(5):561-580.
+ *
+ * @param a The input time series of reference.
+ * @param b The input query.
+ * @param radius The number of cells explored around the projected warping path. Larger values give more accurate
+ * distances.
+ *
+ * @return The approximated DTW distance between a and b.
+ */
+KHIVAAPI double fastDtw(const std::vector<double> &a, const std::vector<double> &b, int radius = 1);
+
+/**
+ * @brief Calculates an approximation of the Dynamic Time Warping Distance with FastDTW and its warping path.
+ *
+ * @param a The input time series of reference.
+ * @param b The input query.
+ * @param radius The number of cells explored around the projected warping path. Larger values give more accurate
+ * distances.
+ * @param path Receives the warping path as pairs of positions of a and b, from (0, 0) to (a.size() - 1, b.size() - 1).
+ *
+ * @return The approximated DTW distance between a and b.
+ */
+KHIVAAPI double fastDtw(const std::vector<double> &a, const std::vector<double> &b, int radius,
+                        std::vector<std::pair<int64_t, int64_t>> &path);
+
+/**
+ * @brief Calculates an approximation of the Dynamic Time Warping Distance with FastDTW between every pair of time
+ * series. The pairs are computed in parallel.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param radius The number of cells explored around the projected warping path. Larger values give more accurate
+ * distances.
+ *
+ * @return af::array An upper triangular matrix where each position corresponds to the distance between
+ * two time series. Diagonal elements will be zero.
+ */
+KHIVAAPI af::array fastDtw(const af::array &tss, int radius = 1);
 
 /**
  * @brief Calculates hamming distances between time series.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
  * dimension one indicates the number of time series.
+ * @param condensed If true, the distances are returned as a condensed vector of numOfTs * (numOfTs - 1) / 2
+ * elements instead of a numOfTs x numOfTs matrix. The distance between time series i and j (i < j) is stored at
+ * position numOfTs * i - i * (i + 1) / 2 + j - i - 1, which is the layout used by scipy.spatial.distance.pdist.
  *
  * @return af::array An upper triangular matrix where each position corresponds to the distance between two
  * time series. Diagonal elements will be zero. For example: Position row 0 column 1 records the distance
- * between time series 0 and time series 1.
+ * between time series 0 and time series 1. Or the condensed vector of distances if condensed is true.
  */
-KHIVAAPI af::array hamming(const af::array &tss);
+KHIVAAPI af::array hamming(const af::array &tss, bool condensed = false);
+
+/**
+ * @brief Calculates the Longest Common Subsequence (LCSS) distance, defined as 1 minus the length of the longest common
+ * subsequence divided by the length of the shortest time series. Two elements match when they are closer than
+ * epsilon.
+ *
+ * @param a The first time series.
+ * @param b The second time series.
+ * @param epsilon The matching threshold.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). It is
+ * widened to the difference of lengths and a negative value explores the whole matrix.
+ * @param upperBound The computation is abandoned as soon as the distance is known to be greater than this value.
+ *
+ * @return The LCSS distance between a and b, in [0, 1], or infinity if it is greater than upperBound.
+ */
+KHIVAAPI double lcss(const std::vector<double> &a, const std::vector<double> &b, double epsilon, int band = -1,
+                     double upperBound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Calculates the Longest Common Subsequence (LCSS) distance, defined as 1 minus the length of the longest common
+ * subsequence divided by the length of the shortest time series. Two elements match when they are closer than
+ * epsilon.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param epsilon The matching threshold.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). A
+ * negative value explores the whole matrix.
+ *
+ * @return af::array An upper triangular matrix where each position corresponds to the distance between
+ * two time series. Diagonal elements will be zero. The pairs are computed in parallel.
+ */
+KHIVAAPI af::array lcss(const af::array &tss, double epsilon, int band = -1);
 
 /**
  * @brief Calculates manhattan distances between time series.
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
  * dimension one indicates the number of time series.
+ * @param condensed If true, the distances are returned as a condensed vector of numOfTs * (numOfTs - 1) / 2
+ * elements instead of a numOfTs x numOfTs matrix. The distance between time series i and j (i < j) is stored at
+ * position numOfTs * i - i * (i + 1) / 2 + j - i - 1, which is the layout used by scipy.spatial.distance.pdist.
  *
  * @return af::array An upper triangular matrix where each position corresponds to the distance between two
  * time series. Diagonal elements will be zero. For example: Position row 0 column 1 records the distance
- * between time series 0 and time series 1.
+ * between time series 0 and time series 1. Or the condensed vector of distances if condensed is true.
+ */
+KHIVAAPI af::array manhattan(const af::array &tss, bool condensed = false);
+
+/**
+ * @brief Calculates the Move-Split-Merge (MSM) distance. Matched elements cost their absolute difference and every
+ * split or merge costs c, plus the distance to the closest neighbour when the element is not between them.
+ *
+ * @param a The first time series.
+ * @param b The second time series.
+ * @param c The cost of split and merge operations.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). It is
+ * widened to the difference of lengths and a negative value explores the whole matrix.
+ * @param upperBound The computation is abandoned as soon as the distance is known to be greater than this value.
+ *
+ * @return The MSM distance between a and b, or infinity if it is greater than upperBound.
+ */
+KHIVAAPI double msm(const std::vector<double> &a, const std::vector<double> &b, double c = 1.0, int band = -1,
+                    double upperBound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Calculates the Move-Split-Merge (MSM) distance. Matched elements cost their absolute difference and every
+ * split or merge costs c, plus the distance to the closest neighbour when the element is not between them.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param c The cost of split and merge operations.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). A
+ * negative value explores the whole matrix.
+ *
+ * @return af::array An upper triangular matrix where each position corresponds to the distance between
+ * two time series. Diagonal elements will be zero. The pairs are computed in parallel.
  */
-KHIVAAPI af::array manhattan(const af::array &tss);
+KHIVAAPI af::array msm(const af::array &tss, double c = 1.0, int band = -1);
 
 /**
  * @brief Calculates the Shape-Based distance (SBD). It computes the normalized cross-correlation and it returns 1.0
@@ -90,12 +243,46 @@ KHIVAAPI af::array sbd(const af::array &tss);
  *
  * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
  * dimension one indicates the number of time series.
+ * @param condensed If true, the distances are returned as a condensed vector of numOfTs * (numOfTs - 1) / 2
+ * elements instead of a numOfTs x numOfTs matrix. The distance between time series i and j (i < j) is stored at
+ * position numOfTs * i - i * (i + 1) / 2 + j - i - 1, which is the layout used by scipy.spatial.distance.pdist.
  *
  * @return array An upper triangular matrix where each position corresponds to the distance between two time series.
  * Diagonal elements will be zero. For example: Position row 0 column 1 records the distance between time series 0
- * and time series 1.
+ * and time series 1. Or the condensed vector of distances if condensed is true.
+ */
+KHIVAAPI af::array squaredEuclidean(const af::array &tss, bool condensed = false);
+
+/**
+ * @brief Calculates the Time Warp Edit (TWE) distance, using the positions of the elements as time stamps.
+ *
+ * @param a The first time series.
+ * @param b The second time series.
+ * @param nu The stiffness, which penalises the difference of time stamps.
+ * @param lambda The penalty of deletions.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). It is
+ * widened to the difference of lengths and a negative value explores the whole matrix.
+ * @param upperBound The computation is abandoned as soon as the distance is known to be greater than this value.
+ *
+ * @return The TWE distance between a and b, or infinity if it is greater than upperBound.
+ */
+KHIVAAPI double twe(const std::vector<double> &a, const std::vector<double> &b, double nu = 0.001, double lambda = 1.0,
+                    int band = -1, double upperBound = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Calculates the Time Warp Edit (TWE) distance, using the positions of the elements as time stamps.
+ *
+ * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+ * dimension one indicates the number of time series.
+ * @param nu The stiffness, which penalises the difference of time stamps.
+ * @param lambda The penalty of deletions.
+ * @param band Maximum distance to the diagonal of the cells of the cost matrix explored (Sakoe-Chiba band). A
+ * negative value explores the whole matrix.
+ *
+ * @return af::array An upper triangular matrix where each position corresponds to the distance between
+ * two time series. Diagonal elements will be zero. The pairs are computed in parallel.
  */
-KHIVAAPI af::array squaredEuclidean(const af::array &tss);
+KHIVAAPI af::array twe(const af::array &tss, double nu = 0.001, double lambda = 1.0, int band = -1);
 
 }  // namespace distances
 }  // namespace khiva
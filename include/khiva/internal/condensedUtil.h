@@ -0,0 +1,80 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef KHIVA_CORE_CONDENSED_UTIL_H
+#define KHIVA_CORE_CONDENSED_UTIL_H
+
+#ifndef BUILDING_KHIVA
+#error Internal headers cannot be included from user code
+#endif
+
+#include <cmath>
+#include <cstdint>
+
+namespace khiva {
+namespace condensedutil {
+
+/**
+ * @brief Number of elements of the condensed form of a symmetric distance matrix between n observations.
+ *
+ * @param n The number of observations.
+ *
+ * @return n * (n - 1) / 2.
+ */
+inline int64_t condensedSize(int64_t n) { return n * (n - 1) / 2; }
+
+/**
+ * @brief Position of the distance between observations i and j (i < j) in the condensed form of a symmetric
+ * distance matrix between n observations. This is the same layout used by scipy.spatial.distance.pdist.
+ *
+ * @param n The number of observations.
+ * @param i The first observation.
+ * @param j The second observation, it must be greater than i.
+ *
+ * @return The position in the condensed vector.
+ */
+inline int64_t condensedIndex(int64_t n, int64_t i, int64_t j) { return n * i - i * (i + 1) / 2 + (j - i - 1); }
+
+/**
+ * @brief Observations i and j (i < j) whose distance is at a position of the condensed form of a symmetric distance
+ * matrix between n observations. This is the inverse of condensedIndex.
+ *
+ * @param n The number of observations.
+ * @param index The position in the condensed vector.
+ * @param i Receives the first observation.
+ * @param j Receives the second observation.
+ */
+inline void condensedPair(int64_t n, int64_t index, int64_t &i, int64_t &j) {
+    // the rows from i onwards hold condensedSize(n - i) elements, the fewest rows holding the remaining ones
+    auto remaining = condensedSize(n) - index;
+    auto estimate = (1.0 + std::sqrt(1.0 + 8.0 * static_cast<double>(remaining))) / 2.0;
+    auto rows = static_cast<int64_t>(std::ceil(estimate));
+    while (condensedSize(rows) < remaining) {
+        rows++;
+    }
+    while (condensedSize(rows - 1) >= remaining) {
+        rows--;
+    }
+    i = n - rows;
+    j = index - condensedIndex(n, i, i + 1) + i + 1;
+}
+
+/**
+ * @brief Number of observations of a condensed distance matrix with the given number of elements.
+ *
+ * @param size The number of elements of the condensed distance matrix.
+ *
+ * @return The number of observations or -1 if size is not a valid condensed size.
+ */
+inline int64_t condensedObservations(int64_t size) {
+    auto n = static_cast<int64_t>(std::llround((1.0 + std::sqrt(1.0 + 8.0 * static_cast<double>(size))) / 2.0));
+    return (condensedSize(n) == size) ? n : -1;
+}
+
+}  // namespace condensedutil
+}  // namespace khiva
+
+#endif
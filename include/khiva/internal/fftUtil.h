@@ -0,0 +1,129 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef KHIVA_CORE_FFT_UTIL_H
+#define KHIVA_CORE_FFT_UTIL_H
+
+#ifndef BUILDING_KHIVA
+#error Internal headers cannot be included from user code
+#endif
+
+#include <arrayfire.h>
+#include <khiva/internal/libraryInternal.h>
+
+#include <algorithm>
+
+namespace khiva {
+namespace fftutil {
+
+// Number of complex elements of the spectrum products computed at once with the default device memory.
+constexpr long SPECTRUM_BATCH_ELEMENTS = 1L << 25;
+
+/**
+ * @brief Returns the smallest length greater or equal than n whose only prime factors are 2, 3 and 5, for which the
+ * FFT is fast.
+ *
+ * @param n The minimum length.
+ *
+ * @return The fast FFT length.
+ */
+inline dim_t nextFastLength(dim_t n) {
+    if (n <= 1) {
+        return 1;
+    }
+    while (true) {
+        dim_t m = n;
+        while (m % 2 == 0) m /= 2;
+        while (m % 3 == 0) m /= 3;
+        while (m % 5 == 0) m /= 5;
+        if (m == 1) {
+            return n;
+        }
+        n++;
+    }
+}
+
+/**
+ * @brief Returns the FFT length used to compute the full cross-correlation of time series of length n.
+ *
+ * @param n The length of the time series.
+ *
+ * @return The fast FFT length not smaller than 2n - 1.
+ */
+inline dim_t crossCorrelationLength(dim_t n) { return nextFastLength(2 * n - 1); }
+
+/**
+ * @brief Returns the real type corresponding to the given complex type.
+ */
+inline af::dtype realType(af::dtype type) { return (type == af::dtype::c64) ? af::dtype::f64 : af::dtype::f32; }
+
+/**
+ * @brief Computes the full cross-correlation of the time series x and y given their spectra, which must have the
+ * same dimensions. The result is the same as af::convolve(x, af::flip(y, 0), AF_CONV_EXPAND), so row k holds the lag
+ * k - (n - 1). It works on batches of time series along the dimensions one to three.
+ *
+ * @param fx The spectra of x, with a length of crossCorrelationLength(n).
+ * @param fy The spectra of y, with a length of crossCorrelationLength(n).
+ * @param n The length of the time series.
+ *
+ * @return The (2n - 1) lags of the cross-correlation.
+ */
+inline af::array crossCorrelation(const af::array &fx, const af::array &fy, dim_t n) {
+    auto fftLength = fx.dims(0);
+    af::array r = af::real(af::ifft(fx * af::conjg(fy)));
+    if (n == 1) {
+        return r(af::seq(0, 0), af::span, af::span, af::span);
+    }
+    return af::join(0, r(af::seq(static_cast<double>(fftLength - n + 1), static_cast<double>(fftLength - 1)),
+                         af::span, af::span, af::span),
+                    r(af::seq(0, static_cast<double>(n - 1)), af::span, af::span, af::span));
+}
+
+/**
+ * @brief Number of columns of fx that can be correlated at once against ny columns of length fftLength.
+ */
+inline dim_t spectrumBatchSize(dim_t fftLength, dim_t ny) {
+    auto budget = khiva::library::internal::getValueScaledToMemoryDevice(
+        SPECTRUM_BATCH_ELEMENTS, khiva::library::internal::Complexity::LINEAR);
+    return std::max<dim_t>(1, static_cast<dim_t>(budget) / std::max<dim_t>(1, fftLength * ny));
+}
+
+/**
+ * @brief Computes the maximum of the cross-correlation between every column of x and every column of y, given their
+ * spectra. Blocks of columns of x are correlated against all columns of y with a single batched spectrum product and
+ * inverse FFT.
+ *
+ * @param fx The spectra of x, with a length of crossCorrelationLength(n).
+ * @param fy The spectra of y, with a length of crossCorrelationLength(n).
+ * @param n The length of the time series.
+ *
+ * @return An array of fx.dims(1) x fy.dims(1) where position (i, j) holds the maximum cross-correlation between the
+ * i-th column of x and the j-th column of y.
+ */
+inline af::array maxCrossCorrelation(const af::array &fx, const af::array &fy, dim_t n) {
+    auto nx = fx.dims(1);
+    auto ny = fy.dims(1);
+    auto batchSize = spectrumBatchSize(fx.dims(0), ny);
+    af::array result = af::constant(0, nx, ny, realType(fx.type()));
+
+    for (dim_t start = 0; start < nx; start += batchSize) {
+        auto end = std::min(start + batchSize, nx);
+        auto blockSize = static_cast<unsigned int>(end - start);
+        af::array block =
+            af::reorder(fx(af::span, af::seq(static_cast<double>(start), static_cast<double>(end - 1))), 0, 2, 1);
+        af::array cc = crossCorrelation(af::tile(block, 1, static_cast<unsigned int>(ny)),
+                                        af::tile(fy, 1, 1, blockSize), n);
+        result(af::seq(static_cast<double>(start), static_cast<double>(end - 1)), af::span) =
+            af::reorder(af::max(cc, 0), 2, 1, 0);
+    }
+
+    return result;
+}
+
+}  // namespace fftutil
+}  // namespace khiva
+
+#endif
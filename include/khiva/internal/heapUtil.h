@@ -0,0 +1,155 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef KHIVA_CORE_HEAP_UTIL_H
+#define KHIVA_CORE_HEAP_UTIL_H
+
+#ifndef BUILDING_KHIVA
+#error Internal headers cannot be included from user code
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace khiva {
+namespace heaputil {
+
+/**
+ * @brief Binary min-heap over the identifiers [0, capacity), stored in flat arrays. The position of every identifier
+ * in the heap is tracked, so the key of any identifier can be changed or removed in O(log n) without leaving stale
+ * entries behind.
+ *
+ * @tparam Key The type of the keys.
+ * @tparam Compare Strict weak ordering of the keys, the smallest key is on top.
+ */
+template <typename Key, typename Compare = std::less<Key>>
+class IndexedMinHeap {
+   public:
+    /**
+     * @brief Creates an empty heap.
+     *
+     * @param capacity The number of identifiers.
+     * @param compare The ordering of the keys.
+     */
+    explicit IndexedMinHeap(int64_t capacity, Compare compare = Compare())
+        : keys(static_cast<size_t>(capacity)), positions(static_cast<size_t>(capacity), -1), compare(compare) {
+        heap.reserve(static_cast<size_t>(capacity));
+    }
+
+    bool empty() const { return heap.empty(); }
+
+    int64_t size() const { return static_cast<int64_t>(heap.size()); }
+
+    bool contains(int64_t id) const { return positions[id] >= 0; }
+
+    /**
+     * @brief The identifier with the smallest key.
+     */
+    int64_t top() const { return heap.front(); }
+
+    /**
+     * @brief The key of the identifier, which must be in the heap.
+     */
+    const Key &key(int64_t id) const { return keys[id]; }
+
+    /**
+     * @brief Inserts the identifier with the given key, or changes its key if it is already in the heap.
+     */
+    void push(int64_t id, const Key &key) {
+        if (contains(id)) {
+            update(id, key);
+            return;
+        }
+        keys[id] = key;
+        positions[id] = size();
+        heap.push_back(id);
+        siftUp(positions[id]);
+    }
+
+    /**
+     * @brief Changes the key of an identifier of the heap.
+     */
+    void update(int64_t id, const Key &key) {
+        keys[id] = key;
+        siftUp(positions[id]);
+        siftDown(positions[id]);
+    }
+
+    /**
+     * @brief Removes the identifier from the heap, if it is in it.
+     */
+    void erase(int64_t id) {
+        auto position = positions[id];
+        if (position < 0) {
+            return;
+        }
+        swapNodes(position, size() - 1);
+        heap.pop_back();
+        positions[id] = -1;
+        if (position < size()) {
+            siftUp(position);
+            siftDown(position);
+        }
+    }
+
+    /**
+     * @brief Removes the identifier with the smallest key.
+     */
+    void pop() { erase(top()); }
+
+   private:
+    bool less(int64_t a, int64_t b) const { return compare(keys[heap[a]], keys[heap[b]]); }
+
+    void swapNodes(int64_t a, int64_t b) {
+        std::swap(heap[a], heap[b]);
+        positions[heap[a]] = a;
+        positions[heap[b]] = b;
+    }
+
+    void siftUp(int64_t position) {
+        while (position > 0) {
+            auto parent = (position - 1) / 2;
+            if (!less(position, parent)) {
+                break;
+            }
+            swapNodes(position, parent);
+            position = parent;
+        }
+    }
+
+    void siftDown(int64_t position) {
+        auto n = size();
+        while (true) {
+            auto smallest = position;
+            auto left = 2 * position + 1;
+            auto right = left + 1;
+            if (left < n && less(left, smallest)) {
+                smallest = left;
+            }
+            if (right < n && less(right, smallest)) {
+                smallest = right;
+            }
+            if (smallest == position) {
+                break;
+            }
+            swapNodes(position, smallest);
+            position = smallest;
+        }
+    }
+
+    std::vector<int64_t> heap;
+    std::vector<Key> keys;
+    std::vector<int64_t> positions;
+    Compare compare;
+};
+
+}  // namespace heaputil
+}  // namespace khiva
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef KHIVA_CORE_PARALLEL_UTIL_H
+#define KHIVA_CORE_PARALLEL_UTIL_H
+
+#ifndef BUILDING_KHIVA
+#error Internal headers cannot be included from user code
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace khiva {
+namespace parallelutil {
+
+/**
+ * @brief Returns the number of host threads used by the multi-threaded kernels.
+ *
+ * @return The number of hardware threads, at least one.
+ */
+inline unsigned int numWorkers() {
+    auto workers = std::thread::hardware_concurrency();
+    return (workers == 0) ? 1 : workers;
+}
+
+/**
+ * @brief Calls fn(i) for every i in [begin, end) using all the host threads. Indices are handed out dynamically in
+ * chunks of grain consecutive iterations, so iterations with an uneven cost are balanced across the threads. The
+ * first exception thrown by fn is rethrown in the calling thread once all the threads have finished.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param fn Function to be called with each index.
+ * @param grain Number of consecutive indices taken by a thread at once.
+ */
+template <typename Function>
+void parallelFor(int64_t begin, int64_t end, Function fn, int64_t grain = 1) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<int64_t>(grain, 1);
+    auto chunks = (end - begin + grain - 1) / grain;
+    auto workers = std::min<int64_t>(numWorkers(), chunks);
+
+    if (workers <= 1) {
+        for (auto i = begin; i < end; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<int64_t> next(begin);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto work = [&]() {
+        try {
+            for (auto start = next.fetch_add(grain); start < end; start = next.fetch_add(grain)) {
+                auto stop = std::min(start + grain, end);
+                for (auto i = start; i < stop; i++) {
+                    fn(i);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            // Stop handing out work to the rest of the threads
+            next.store(end);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<size_t>(workers - 1));
+    for (int64_t w = 1; w < workers; w++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace parallelutil
+}  // namespace khiva
+
+#endif
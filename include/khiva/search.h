@@ -0,0 +1,279 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef KHIVA_CORE_SEARCH_H
+#define KHIVA_CORE_SEARCH_H
+
+#include <arrayfire.h>
+#include <khiva/defines.h>
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace khiva {
+
+namespace search {
+
+/**
+ * @brief Metrics supported by the indexes.
+ */
+typedef enum {
+    KHIVA_METRIC_EUCLIDEAN = 0,        ///< Euclidean distance
+    KHIVA_METRIC_ZNORM_EUCLIDEAN = 1,  ///< Euclidean distance between the z-normalised time series
+} khiva_metric;
+
+typedef khiva_metric Metric;
+
+/**
+ * @brief A neighbour found by a query: the position of the time series in the indexed array and its distance to the
+ * query.
+ */
+using Neighbour = std::pair<int64_t, double>;
+
+/**
+ * @brief Vantage-point tree over the columns of an array. Every node picks a vantage point and splits the rest of its
+ * time series by the median of their distances to it, so the triangle inequality lets the queries discard whole
+ * subtrees and they take logarithmic time instead of a scan of all the time series.
+ *
+ * [1] Yianilos PN (1993). Data structures and algorithms for nearest neighbor search in general metric spaces.
+ * Proceedings of the fourth annual ACM-SIAM Symposium on Discrete algorithms, 311-321.
+ */
+class KHIVAAPI VPTree {
+   public:
+    /**
+     * @brief Builds the tree.
+     *
+     * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+     * dimension one indicates the number of time series, at most 2^32 - 1 so they fit in the returned indexes.
+     * @param metric The metric used to compare the time series.
+     * @param leafSize The maximum number of time series in the leaves, which are scanned sequentially.
+     */
+    explicit VPTree(const af::array &tss, Metric metric = KHIVA_METRIC_EUCLIDEAN, int leafSize = 16);
+
+    /**
+     * @brief Finds the k nearest neighbours of every query. The queries are processed in parallel.
+     *
+     * @param queries Array whose dimension zero is the length of the indexed time series and dimension one indicates
+     * the number of queries.
+     * @param k The number of neighbours.
+     * @param distances Receives an array of k x numQueries with the distances to the neighbours in ascending order,
+     * of type f64 for f64 time series and f32 otherwise.
+     * @param indexes Receives an array of k x numQueries with the positions of the neighbours in the indexed array.
+     */
+    void knn(const af::array &queries, int k, af::array &distances, af::array &indexes) const;
+
+    /**
+     * @brief Finds all the time series closer than radius to every query. The queries are processed in parallel.
+     *
+     * @param queries Array whose dimension zero is the length of the indexed time series and dimension one indicates
+     * the number of queries.
+     * @param radius The maximum distance to the queries.
+     *
+     * @return A vector per query with the neighbours found, in ascending order of distance.
+     */
+    std::vector<std::vector<Neighbour>> range(const af::array &queries, double radius) const;
+
+    /**
+     * @brief Writes the tree to a binary stream.
+     *
+     * @param os The output stream.
+     */
+    void save(std::ostream &os) const;
+
+    /**
+     * @brief Reads a tree written by save.
+     *
+     * @param is The input stream.
+     *
+     * @return The tree.
+     */
+    static VPTree load(std::istream &is);
+
+    /**
+     * @brief Returns the metric of the tree.
+     */
+    Metric getMetric() const { return metric; }
+
+    /**
+     * @brief Returns the length of the indexed time series.
+     */
+    int64_t getLength() const { return length; }
+
+    /**
+     * @brief Returns the number of indexed time series.
+     */
+    int64_t getNumberOfTimeSeries() const { return static_cast<int64_t>(order.size()); }
+
+   private:
+    struct Node {
+        int64_t begin;
+        int64_t end;
+        double mu;
+        int64_t inside;
+        int64_t outside;
+    };
+
+    VPTree() = default;
+
+    int64_t build(int64_t begin, int64_t end, uint64_t seed);
+
+    std::vector<double> prepareQueries(const af::array &queries) const;
+
+    double distance(const double *query, int64_t position, double bound) const;
+
+    void knnSearch(const double *query, int64_t node, size_t k, std::vector<Neighbour> &heap) const;
+
+    void rangeSearch(const double *query, int64_t node, double radius, std::vector<Neighbour> &result) const;
+
+    Metric metric = KHIVA_METRIC_EUCLIDEAN;
+    int leafSize = 16;
+    int64_t length = 0;
+    // the type of the distances returned by knn
+    af::dtype type = af::dtype::f64;
+    // the time series in the order of the tree, transformed according to the metric
+    std::vector<double> data;
+    // position in the indexed array of every time series stored in data
+    std::vector<int64_t> order;
+    std::vector<Node> nodes;
+};
+
+/**
+ * @brief iSAX index over z-normalised time series. Every time series is summarised by its SAX word with a cardinality
+ * of 256 symbols per segment, and the tree groups the words by their prefixes: the root splits them by the first bit
+ * of every segment and the rest of the nodes split in two by the next bit of the segment that divides them most evenly,
+ * until the leaves hold at most leafSize time series. The MINDIST between the PAA of a query and the iSAX word of a
+ * node is a lower bound of the z-normalised euclidean distance to all its time series, so the exact queries only scan
+ * the leaves that could improve the current neighbours. The leaves can be kept in memory or in a file, which is read
+ * on demand.
+ *
+ * [1] Shieh J, Keogh E (2008). iSAX: indexing and mining terabyte sized time series. Proceedings of the 14th ACM
+ * SIGKDD international conference on Knowledge discovery and data mining, 623-631.
+ */
+class KHIVAAPI ISAXIndex {
+   public:
+    /**
+     * @brief Builds the index over whole time series.
+     *
+     * @param tss Expects an input array whose dimension zero is the length of the time series (all the same) and
+     * dimension one indicates the number of time series.
+     * @param segments The number of PAA segments of the SAX words, between 1 and 16.
+     * @param leafSize The maximum number of time series in the leaves, unless their words cannot be split further.
+     * @param leavesFile The file where the leaves are written, or an empty string to keep them in memory.
+     */
+    explicit ISAXIndex(const af::array &tss, int segments = 8, int leafSize = 256,
+                       const std::string &leavesFile = std::string());
+
+    /**
+     * @brief Builds the index over all the subsequences of a time series. The subsequences are z-normalised on the fly
+     * from the time series, so they are never held in memory at once.
+     *
+     * @param ts Expects an input array with a single time series.
+     * @param window The length of the subsequences.
+     * @param segments The number of PAA segments of the SAX words, between 1 and 16.
+     * @param leafSize The maximum number of subsequences in the leaves, unless their words cannot be split further.
+     * @param leavesFile The file where the leaves are written, or an empty string to keep them in memory.
+     *
+     * @return The index, whose indexes are the starting positions of the subsequences.
+     */
+    static ISAXIndex subsequences(const af::array &ts, int64_t window, int segments = 8, int leafSize = 256,
+                                  const std::string &leavesFile = std::string());
+
+    /**
+     * @brief Finds the k nearest neighbours of every query under the z-normalised euclidean distance. The queries are
+     * processed in parallel.
+     *
+     * @param queries Expects an input array whose dimension zero is the length of the indexed time series and
+     * dimension one indicates the number of queries.
+     * @param k The number of neighbours.
+     * @param distances Receives an array of k x numQueries with the distances to the neighbours in ascending order,
+     * of type f64 for f64 time series and f32 otherwise.
+     * @param indexes Receives an array of k x numQueries with the positions of the neighbours.
+     * @param exact Whether to find the exact neighbours, or the approximate ones in the leaves closest to the query.
+     */
+    void knn(const af::array &queries, int k, af::array &distances, af::array &indexes, bool exact = true) const;
+
+    /**
+     * @brief Writes the index to a binary stream. The leaves kept in a file are not copied, only its name.
+     *
+     * @param os The output stream.
+     */
+    void save(std::ostream &os) const;
+
+    /**
+     * @brief Reads an index written by save.
+     *
+     * @param is The input stream.
+     *
+     * @return The index.
+     */
+    static ISAXIndex load(std::istream &is);
+
+    /**
+     * @brief Returns the length of the indexed time series.
+     */
+    int64_t getLength() const { return length; }
+
+    /**
+     * @brief Returns the number of indexed time series.
+     */
+    int64_t getNumberOfTimeSeries() const { return static_cast<int64_t>(order.size()); }
+
+    /**
+     * @brief Returns the number of PAA segments of the SAX words.
+     */
+    int getSegments() const { return segments; }
+
+   private:
+    struct Node {
+        int64_t begin;
+        int64_t end;
+        int64_t firstChild;
+        int32_t numChildren;
+        int32_t splitSegment;
+    };
+
+    ISAXIndex() = default;
+
+    void build(int64_t numOfTs);
+
+    void normalise(int64_t id, double *result) const;
+
+    void split(int64_t node, const std::vector<uint8_t> &words);
+
+    void addNode(int64_t begin, int64_t end, const uint8_t *bits, const uint8_t *symbols);
+
+    void paa(const double *ts, double *result) const;
+
+    double minDistance(const double *paa, int64_t node) const;
+
+    int segments = 8;
+    int leafSize = 256;
+    int64_t length = 0;
+    // the type of the distances returned by knn
+    af::dtype type = af::dtype::f64;
+    std::string leavesFile;
+    // the indexed values, where the time series id starts at id * step, which are z-normalised on read with the
+    // mean and standard deviation of every time series; they are dropped once the leaves are written to a file
+    int64_t step = 0;
+    std::vector<double> values;
+    std::vector<double> means;
+    std::vector<double> stdevs;
+    // position in the indexed array of every time series in the order of the tree
+    std::vector<int64_t> order;
+    std::vector<Node> nodes;
+    // number of bits and symbol of every segment of the iSAX word of every node
+    std::vector<uint8_t> nodeBits;
+    std::vector<uint8_t> nodeSymbols;
+};
+
+}  // namespace search
+}  // namespace khiva
+
+#endif
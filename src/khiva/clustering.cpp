@@ -5,32 +5,162 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 #include <arrayfire.h>
 #include <khiva/clustering.h>
+#include <khiva/internal/condensedUtil.h>
+#include <khiva/internal/fftUtil.h>
+#include <khiva/internal/parallelUtil.h>
 #include <khiva/internal/scopedHostPtr.h>
 #include <khiva/normalization.h>
+#include <khiva/search.h>
 
-#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <numeric>
 #include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace {
+
+// Maximum number of iterations of the power method used to extract the shapes of the kShape centroids.
+constexpr int POWER_ITERATIONS = 1000;
+
+// Number of iterations of the power method between its convergence checks, which have to wait for the device.
+constexpr int POWER_CHECK_INTERVAL = 16;
+
+// Number of swap candidates of kMedoids evaluated concurrently before the best one of them is swapped.
+constexpr int64_t SWAP_CANDIDATES_BLOCK = 64;
+
+// Number of range queries of DBSCAN whose neighbours are kept in memory at once.
+constexpr int64_t RANGE_QUERIES_BLOCK = 4096;
+
+// Number of elements of a dense distance matrix copied to the host at once when it is read as a condensed vector.
+constexpr int64_t CONDENSED_BLOCK_ELEMENTS = 1 << 22;
+
+// Minimum number of elements compared by a step of Prim's algorithm, over all its distances, to run it concurrently.
+constexpr int64_t PRIM_PARALLEL_WORK = 1 << 18;
+
 /**
- * Computes initial k means or centroids.
+ * Computes the squared euclidean distance between every centroid and every time series with a single matrix
+ * multiplication, as ||c||^2 + ||x||^2 - 2 * c^T * x.
  *
- * @param tts       The time series.
- * @param k         The number of centroids.
- * @return          The new centroids.
+ * @param tss           The time series.
+ * @param means         The centroids.
+ * @param meansNorms    The squared 2-norms of the centroids as a k x 1 array.
+ * @return              A k x nSeries array with the squared distances.
  */
-af::array calculateInitialMeans(const af::array &tss, int k) { return af::constant(0, tss.dims(0), k, tss.type()); }
+af::array squaredDistances(const af::array &tss, const af::array &means, const af::array &meansNorms) {
+    af::array tssNorms = af::sum(tss * tss, 0);
+    af::array distances = af::matmul(means, tss, AF_MAT_TRANS, AF_MAT_NONE) * (-2.0);
+    distances += af::tile(meansNorms, 1, static_cast<unsigned int>(tss.dims(1)));
+    distances += af::tile(tssNorms, static_cast<unsigned int>(means.dims(1)));
+    // cancellation can give tiny negative values
+    return af::max(distances, 0.0);
+}
 
 /**
- * Computes The euclidean distance for a tiled time series agains k-means.
+ * Computes the squared euclidean distance between every centroid and every time series.
  *
- * @param tts       The tiled time series.
+ * @param tss       The time series.
  * @param means     The centroids.
- * @return          The distance from a time series to all k-means.
+ * @return          A k x nSeries array with the squared distances.
+ */
+af::array squaredDistances(const af::array &tss, const af::array &means) {
+    return squaredDistances(tss, means, af::sum(means * means, 0).T());
+}
+
+/**
+ * Computes the squared euclidean distance between two vectors.
+ */
+double squaredDistance(const double *a, const double *b, int64_t length) {
+    double acc = 0.0;
+    for (int64_t i = 0; i < length; i++) {
+        double d = a[i] - b[i];
+        acc += d * d;
+    }
+    return acc;
+}
+
+/**
+ * Finds the closest and the second closest centroid of a time series, computing all the distances. Ties are resolved
+ * in favour of the centroid with the lowest id, as af::min does.
+ *
+ * @param ts        The time series.
+ * @param means     The centroids, one after the other.
+ * @param length    The length of the time series.
+ * @param k         The number of centroids.
+ * @param label     The id of the closest centroid.
+ * @param upper     The distance to the closest centroid.
+ * @param lower     The distance to the second closest centroid.
  */
-af::array kEuclideanDistance(const af::array &tts, const af::array &means) {
-    return af::reorder(af::sqrt(af::sum(af::pow((tts - means), 2), 0)), 1, 0);
+void closestTwo(const double *ts, const std::vector<double> &means, int64_t length, int64_t k, unsigned int &label,
+                double &upper, double &lower) {
+    double best = std::numeric_limits<double>::infinity();
+    double second = std::numeric_limits<double>::infinity();
+    for (int64_t j = 0; j < k; j++) {
+        double d = squaredDistance(ts, means.data() + j * length, length);
+        if (d < best) {
+            second = best;
+            best = d;
+            label = static_cast<unsigned int>(j);
+        } else if (d < second) {
+            second = d;
+        }
+    }
+    upper = std::sqrt(best);
+    lower = std::sqrt(second);
+}
+
+/**
+ * Finds the closest centroid of every time series with the distances expanded by squaredDistances. The expansion
+ * rounds with an error of about the machine epsilon of the type times the squared norms, so the time series whose two
+ * closest centroids are not further apart than that error are decided again on the host by closestTwo, which is what
+ * Hamerly's k-means uses. The labels are then the ones of the distances computed directly in double precision.
+ *
+ * @param tss           The time series.
+ * @param means         The centroids.
+ * @param meansNorms    The squared 2-norms of the centroids as a k x 1 array.
+ * @param minDistance   The squared distance of every time series to its closest centroid.
+ * @param idxs          The id of the closest centroid of every time series.
+ */
+void closestMeans(const af::array &tss, const af::array &means, const af::array &meansNorms, af::array &minDistance,
+                  af::array &idxs) {
+    auto k = static_cast<unsigned int>(means.dims(1));
+    af::array distances = squaredDistances(tss, means, meansNorms);
+    af::min(minDistance, idxs, distances, 0);
+    if (k < 2) {
+        return;
+    }
+
+    af::array others = af::select(af::range(distances.dims(), 0, af::dtype::u32) == af::tile(idxs, k),
+                                  std::numeric_limits<double>::infinity(), distances);
+    af::array second = af::min(others, 0);
+    auto epsilon = (tss.type() == af::dtype::f64) ? std::numeric_limits<double>::epsilon()
+                                                  : static_cast<double>(std::numeric_limits<float>::epsilon());
+    auto length = static_cast<int64_t>(tss.dims(0));
+    af::array error =
+        (4.0 * static_cast<double>(length + 2) * epsilon) * (af::sum(tss * tss, 0) + af::max<double>(meansNorms));
+    af::array ambiguous = af::where(second - minDistance <= 2.0 * error);
+    if (ambiguous.isempty()) {
+        return;
+    }
+
+    auto count = static_cast<int64_t>(ambiguous.elements());
+    std::vector<double> data(static_cast<size_t>(length * count));
+    tss(af::span, ambiguous).as(af::dtype::f64).host(data.data());
+    std::vector<double> hostMeans(static_cast<size_t>(length * k));
+    means.as(af::dtype::f64).host(hostMeans.data());
+    std::vector<unsigned int> labels(static_cast<size_t>(count));
+    std::vector<double> closest(static_cast<size_t>(count));
+    khiva::parallelutil::parallelFor(0, count, [&](int64_t i) {
+        double lower;
+        closestTwo(data.data() + i * length, hostMeans, length, k, labels[i], closest[i], lower);
+        closest[i] *= closest[i];
+    });
+    idxs(ambiguous) = af::array(count, labels.data());
+    minDistance(ambiguous) = af::array(count, closest.data()).as(minDistance.type());
 }
 
 /***
@@ -42,43 +172,91 @@ af::array kEuclideanDistance(const af::array &tts, const af::array &means) {
  * @param labels        The ids of the closes mean for all time series.
  */
 void euclideanDistance(const af::array &tss, const af::array &means, af::array &minDistance, af::array &idxs) {
-    auto nSeries = tss.dims(1);
-    af::array kDistances = af::constant(0.0, means.dims(1), nSeries, tss.type());
+    closestMeans(tss, means, af::sum(means * means, 0).T(), minDistance, idxs);
+    minDistance = af::sqrt(minDistance);
+}
 
-    // This for loop could be parallel, not parallelized to keep memory footprint low
-    for (int i = 0; i < nSeries; i++) {
-        af::array tiledSeries = af::tile(tss.col(i), 1, means.dims(1));
-        kDistances(af::span, i) = kEuclideanDistance(tiledSeries, means);
+/**
+ * Computes initial k means or centroids with k-means++. The first centroid is a random time series and every next
+ * one is a time series chosen with a probability proportional to its squared distance to the closest centroid
+ * already chosen.
+ *
+ * [1] D. Arthur and S. Vassilvitskii. 2007. k-means++: the advantages of careful seeding. Proceedings of the
+ * eighteenth annual ACM-SIAM symposium on Discrete algorithms, Pages 1027-1035.
+ *
+ * @param tss       The time series.
+ * @param k         The number of centroids.
+ * @return          The new centroids.
+ */
+af::array calculateInitialMeans(const af::array &tss, int k) {
+    auto nSeries = tss.dims(1);
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    af::array means = af::constant(0, tss.dims(0), k, tss.type());
+    auto first = std::uniform_int_distribution<dim_t>(0, nSeries - 1)(rng);
+    means(af::span, 0) = tss(af::span, first);
+    af::array closest = squaredDistances(tss, means(af::span, 0));
+
+    for (int i = 1; i < k; i++) {
+        af::array cumulative = af::accum(closest.as(af::dtype::f64), 1);
+        auto total = af::sum<double>(closest.as(af::dtype::f64));
+        dim_t next;
+        if (total > 0) {
+            // first time series whose cumulative weight reaches the random threshold
+            af::array candidates = af::where(cumulative >= uniform(rng) * total);
+            next = candidates.isempty() ? nSeries - 1 : static_cast<dim_t>(candidates(0).scalar<unsigned int>());
+        } else {
+            // all the time series are already centroids
+            next = std::uniform_int_distribution<dim_t>(0, nSeries - 1)(rng);
+        }
+        means(af::span, i) = tss(af::span, next);
+        closest = af::min(closest, squaredDistances(tss, means(af::span, i)));
     }
-    af::min(minDistance, idxs, kDistances, 0);
+
+    return means;
 }
 
 /**
- * Compute the new means for the i-th iteration.
+ * Computes the one-hot encoding of the labels.
+ *
+ * @param labels    The ids for each time series which indicates the closest mean.
+ * @param n         The number of time series.
+ * @param k         The number of means.
+ * @param type      The type of the result.
+ * @return          An n x k array with a one in the column of the label of every time series.
+ */
+af::array oneHotLabels(const af::array &labels, dim_t n, dim_t k, af::dtype type) {
+    return (af::tile(af::flat(labels).as(af::dtype::s32), 1, static_cast<unsigned int>(k)) ==
+            af::range(af::dim4(n, k), 1, af::dtype::s32))
+        .as(type);
+}
+
+/**
+ * Compute the new means for the i-th iteration. The sums of the time series of every centroid are computed with a
+ * single matrix multiplication by the one-hot encoding of the labels. Centroids without time series are kept.
  *
  * @param tss       The time series.
  * @param labels    The ids for each time series which indicates the closest mean.
- * @param k         Number of means.
+ * @param means     The current means.
  * @return          The new means.
  */
-af::array computeNewMeans(const af::array &tss, const af::array &labels, int k) {
-    af::array labelsTiled = af::tile(labels, tss.dims(0));
-    af::array newMeans = af::constant(0.0, tss.dims(0), k, tss.type());
-
-    gfor(af::seq ii, k) {
-        newMeans(af::span, ii) = af::sum(tss * (labelsTiled == ii), 1) / (af::sum(af::sum((labels == ii), 3), 1));
-    }
-    return newMeans;
+af::array computeNewMeans(const af::array &tss, const af::array &labels, const af::array &means) {
+    af::array oneHot = oneHotLabels(labels, tss.dims(1), means.dims(1), tss.type());
+    af::array sums = af::matmul(tss, oneHot);
+    af::array counts = af::sum(oneHot, 0);
+    af::array empty = af::tile(counts == 0, static_cast<unsigned int>(tss.dims(0)));
+    return af::select(empty, means, sums / af::tile(af::max(counts, 1.0), static_cast<unsigned int>(tss.dims(0))));
 }
 
 /**
- *  This function generates random labels for n time series.
+ *  This function generates uniform labels for n time series.
  *
  * @param nTimeSeries   Number of time series to be labeled.
  * @param k             The number of groups.
  * @return              The random labels.
  */
-af::array generateRandomLabels(int nTimeSeries, int k) {
+af::array generateUniformLabels(int nTimeSeries, int k) {
     std::vector<int> idx(nTimeSeries, 0);
 
     // Fill with sequential data
@@ -86,25 +264,23 @@ af::array generateRandomLabels(int nTimeSeries, int k) {
         idx[i] = i % k;
     }
 
-    // Randomize
-    std::shuffle(idx.begin(), idx.end(), std::mt19937(std::random_device()()));
     return af::array(nTimeSeries, 1, idx.data());
 }
 
 /**
- *  This function generates uniform labels for n time series.
+ * This function generates uniform labels for n time series in a random order.
  *
  * @param nTimeSeries   Number of time series to be labeled.
  * @param k             The number of groups.
  * @return              The random labels.
  */
-af::array generateUniformLabels(int nTimeSeries, int k) {
+af::array generateShuffledLabels(int nTimeSeries, int k) {
     std::vector<int> idx(nTimeSeries, 0);
-
-    // Fill with sequential data
     for (int i = 0; i < nTimeSeries; i++) {
         idx[i] = i % k;
     }
+    std::mt19937 rng(std::random_device{}());
+    std::shuffle(idx.begin(), idx.end(), rng);
 
     return af::array(nTimeSeries, 1, idx.data());
 }
@@ -131,245 +307,1373 @@ float computeError(const af::array &means, const af::array &newMeans) {
 af::array matrixNorm(const af::array &tss) { return af::sqrt(af::sum(af::pow(tss, 2))); }
 
 /**
- * This function returns a subset of time series from tss, where all time series belong to the centroid's
- * given by centroidId.
+ * Computes the maximum of the normalized crosscorrelation for all time series and all centroids given their spectra,
+ * so all the cross-correlations are computed as batched spectrum products and inverse FFTs.
+ *
+ * @param tssSpectra        The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param tssNorms          The 2-norm of every time series.
+ * @param centroidsSpectra  The spectra of the centroids, with the same length.
+ * @param centroidsNorms    The 2-norm of every centroid.
+ * @param nElements         The length of the time series.
+ * @return                  A k x nSeries array with the maximum normalized crosscorrelation.
+ */
+af::array maxNcc(const af::array &tssSpectra, const af::array &tssNorms, const af::array &centroidsSpectra,
+                 const af::array &centroidsNorms, dim_t nElements) {
+    // Combination of all pairs of norms
+    af::array den = af::matmul(centroidsNorms.T(), tssNorms);
+    den(den == 0) = af::Inf;
+
+    return khiva::fftutil::maxCrossCorrelation(centroidsSpectra, tssSpectra, nElements) / den;
+}
+
+/**
+ * Computes the maximum of the normalized crosscorrelation for all time series and all centroids. The spectra of the
+ * time series are computed once per run and the ones of the centroids once per call.
+ *
+ * @param tssSpectra    The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param tssNorms      The 2-norm of every time series.
+ * @param centroids     The set of centroids.
+ * @return              A k x nSeries array with the maximum normalized crosscorrelation.
+ */
+af::array maxNcc(const af::array &tssSpectra, const af::array &tssNorms, const af::array &centroids) {
+    return maxNcc(tssSpectra, tssNorms, af::fft(centroids, tssSpectra.dims(0)), matrixNorm(centroids),
+                  centroids.dims(0));
+}
+
+/**
+ * Shifts every time series to the lag of maximum crosscorrelation with the centroid of its cluster, filling with
+ * zeros. The crosscorrelations of all the time series are computed at once from their spectra, in blocks that fit in
+ * the device memory, and the shifts are applied by indexing. Time series whose centroid is all zeros are not shifted.
  *
  * @param tss           The set of time series in columnar mode.
- * @param labels        The centroid id where each time series belongs to.
- * @param centroidId    The given centroid ID.
- * @return              A subset of time series.
+ * @param tssSpectra    The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param centroids     The set of centroids in columnar mode.
+ * @param labels        The set of labels.
+ * @return              The shifted time series.
  */
-af::array selectSubset(const af::array &tss, const af::array &labels, int centroidId) {
-    return af::lookup(tss, af::where((labels == centroidId)), 1);
+af::array alignToCentroids(const af::array &tss, const af::array &tssSpectra, const af::array &centroids,
+                           const af::array &labels) {
+    auto nElements = tss.dims(0);
+    auto nTimeSeries = tss.dims(1);
+    af::array flatLabels = af::flat(labels).as(af::dtype::u32).T();
+    af::array centroidsSpectra = af::fft(centroids, tssSpectra.dims(0));
+
+    af::array index = af::constant(0, 1, nTimeSeries, af::dtype::s64);
+    auto batchSize = khiva::fftutil::spectrumBatchSize(tssSpectra.dims(0), 1);
+    for (dim_t start = 0; start < nTimeSeries; start += batchSize) {
+        af::seq block(static_cast<double>(start), static_cast<double>(std::min(start + batchSize, nTimeSeries) - 1));
+        af::array cc = khiva::fftutil::crossCorrelation(af::lookup(centroidsSpectra, flatLabels(0, block), 1),
+                                                        tssSpectra(af::span, block), nElements);
+        af::array maxCC;
+        af::array maxIndex;
+        af::max(maxCC, maxIndex, cc, 0);
+        index(0, block) = maxIndex.as(af::dtype::s64);
+    }
+
+    af::array shift = index - (nElements - 1);
+    af::array zeroCentroid = af::lookup(af::allTrue(af::iszero(centroids), 0), flatLabels, 1);
+    shift = af::select(zeroCentroid, 0, shift);
+
+    // the element t of a shifted time series is the element t - shift of the original one
+    af::array source = af::range(af::dim4(nElements, nTimeSeries), 0, af::dtype::s64) -
+                       af::tile(shift, static_cast<unsigned int>(nElements));
+    af::array valid = (source >= 0) && (source < nElements);
+    af::array columns = af::range(af::dim4(nElements, nTimeSeries), 1, af::dtype::s64);
+    af::array position = af::select(valid, source, 0) + columns * static_cast<long long>(nElements);
+    af::array shifted = af::moddims(af::lookup(af::flat(tss), af::flat(position)), nElements, nTimeSeries);
+
+    return af::select(valid, shifted, 0.0);
 }
 
 /**
- * This function computes the first EigenVector of a matrix.
+ * Subtracts the mean of every column, which is the product by the centering matrix Q = I - 1/n.
  *
  * @param m     The input matrix.
- * @return      The first Eigen vector.
+ * @return      The centered matrix.
+ */
+af::array centerColumns(const af::array &m) {
+    return m - af::tile(af::mean(m, 0), static_cast<unsigned int>(m.dims(0)));
+}
+
+/**
+ * This function returns the updated shapes of all the centroids, which are the first eigenvectors of the matrices
+ * M = Q^T S Q, with S the sum of the outer products of the aligned time series of every cluster. M is never built:
+ * all the centroids are refined at once with a power iteration, where the product by M is computed as
+ * Q X (onehot .* (X^T Q v)), warm-started from the previous centroids.
+ *
+ * @param tss           The aligned and z-normalized time series in columnar mode.
+ * @param oneHot        The one-hot encoding of the labels.
+ * @param centroids     The current centroids.
+ * @return              The updated shapes of the centroids.
  */
-af::array getFirstEigenVector(const af::array &m) {
-    af::array eigenValues;
-    af::array eigenVectors;
+af::array shapeExtraction(const af::array &tss, const af::array &oneHot, const af::array &centroids) {
+    auto nElements = static_cast<unsigned int>(tss.dims(0));
+    auto nCentroids = static_cast<unsigned int>(centroids.dims(1));
+    double tolerance = (tss.type() == af::dtype::f64) ? 1e-12 : 1e-6;
+
+    // the first time series of every cluster, which fixes the sign of the eigenvector
+    af::array rows = af::range(oneHot.dims(), 0, af::dtype::u32);
+    af::array first = af::min(af::select(oneHot > 0, rows, static_cast<double>(tss.dims(1) - 1)), 0);
+    af::array firstTss = af::lookup(tss, first, 1);
+
+    // the previous centroid is the starting vector, or the first time series of its cluster when it is all zeros
+    af::array start = centerColumns(centroids);
+    start = af::select(af::tile(matrixNorm(start) == 0, nElements), centerColumns(firstTss), start);
+    af::array fallback = af::tile(centerColumns(af::range(af::dim4(nElements), 0, tss.type())), 1, nCentroids);
+    start = af::select(af::tile(matrixNorm(start) == 0, nElements), fallback, start);
+    af::array v = start / af::tile(matrixNorm(start), nElements);
+
+    for (int iter = 0; iter < POWER_ITERATIONS; iter++) {
+        af::array next = centerColumns(af::matmul(tss, af::matmul(tss, v, AF_MAT_TRANS, AF_MAT_NONE) * oneHot));
+        af::array norms = matrixNorm(next);
+        next = af::select(af::tile(norms == 0, nElements), v, next / af::tile(norms, nElements));
+        // a single reduction over all the clusters, and only every few iterations
+        bool converged = ((iter + 1) % POWER_CHECK_INTERVAL == 0) && af::max<double>(af::abs(next - v)) < tolerance;
+        v = next;
+        if (converged) {
+            break;
+        }
+    }
 
-    if (m.type() == af::dtype::f64) {
-        auto matHost = khiva::utils::makeScopedHostPtr(m.host<double>());
-        Eigen::MatrixXd mat = Eigen::Map<Eigen::MatrixXd>(matHost.get(), m.dims(0), m.dims(1));
+    af::array condition = matrixNorm(firstTss - v) >= matrixNorm(firstTss + v);
+    v = af::select(af::tile(condition, nElements), -v, v);
 
-        // Compute Eigen Values.
-        Eigen::VectorXcd eivals = mat.eigenvalues();
-        Eigen::VectorXd reEIVals = eivals.real();
-        eigenValues = af::array(m.dims(0), reEIVals.data());
+    return khiva::normalization::znorm(v);
+}
 
-        // Compute Eigen Vectors.
-        Eigen::EigenSolver<Eigen::MatrixXd> solution(mat);
-        Eigen::MatrixXd reEIVectors = solution.eigenvectors().real();
-        eigenVectors = af::array(m.dims(0), m.dims(1), reEIVectors.data());
-    } else if (m.type() == af::dtype::f32) {
-        auto matHost = khiva::utils::makeScopedHostPtr(m.host<float>());
-        Eigen::MatrixXf mat = Eigen::Map<Eigen::MatrixXf>(matHost.get(), m.dims(0), m.dims(1));
+/**
+ * This function performs the refinement step. All the time series are aligned to their centroids at once and all the
+ * centroids are refined concurrently.
+ *
+ * @param tss           The set of time series in columnar manner.
+ * @param tssSpectra    The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param centroids     The set of centroids in columnar mode.
+ * @param labels        The set of labels.
+ * @return              The new centroids.
+ */
+af::array refinementStep(const af::array &tss, const af::array &tssSpectra, const af::array &centroids,
+                         const af::array &labels) {
+    af::array aligned = khiva::normalization::znorm(alignToCentroids(tss, tssSpectra, centroids, labels));
+    af::array oneHot = oneHotLabels(labels, tss.dims(1), centroids.dims(1), tss.type());
+    af::array shapes = shapeExtraction(aligned, oneHot, centroids);
+
+    // centroids without time series are kept
+    af::array empty = af::tile(af::sum(oneHot, 0) == 0, static_cast<unsigned int>(tss.dims(0)));
+    return af::select(empty, centroids, shapes);
+}
 
-        // Compute Eigen Values.
-        Eigen::VectorXcf eivals = mat.eigenvalues();
-        Eigen::VectorXf reEIVals = eivals.real();
-        eigenValues = af::array(m.dims(0), reEIVals.data());
+/**
+ * This function computes the assignment step. It is the update of time series labels w.r.t. the dinamics of the
+ * centroids.
+ *
+ * @param tssSpectra    The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param tssNorms      The 2-norm of every time series.
+ * @param centroids     The set of centroids in columnar mode.
+ * @return              The new set of labels.
+ */
+af::array assignmentStep(const af::array &tssSpectra, const af::array &tssNorms, const af::array &centroids) {
+    af::array min;
+    af::array labels;
+    af::array distances = 1 - maxNcc(tssSpectra, tssNorms, centroids);
+    af::min(min, labels, distances, 0);
+
+    return labels.T();
+}
 
-        // Compute Eigen Vectors.
-        Eigen::EigenSolver<Eigen::MatrixXf> solution(mat);
-        Eigen::MatrixXf reEIVectors = solution.eigenvectors().real();
-        eigenVectors = af::array(m.dims(0), m.dims(1), reEIVectors.data());
+/**
+ * Runs Hamerly's k-means. Every time series keeps an upper bound of the distance to its centroid and a lower bound of
+ * the distance to any other centroid, and its distances are only computed on the host when the bounds, shifted by the
+ * movement of the centroids, do not prove that its label is unchanged. The bounds are only trusted when they prove it
+ * by more than the rounding error of the distances, and the labels are otherwise decided by closestTwo as closestMeans
+ * does. The new means and the convergence are computed by computeNewMeans and computeError, so it performs the same
+ * iterations and gives the same result as Lloyd's algorithm.
+ *
+ * [1] G. Hamerly. 2010. Making k-means even faster. Proceedings of the 2010 SIAM International Conference on Data
+ * Mining, Pages 130-140.
+ *
+ * @param tss           The time series.
+ * @param centroids     The initial centroids, which receive the resulting ones.
+ * @param labels        Receives the labels of the time series.
+ * @param tolerance     The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ */
+void hamerly(const af::array &tss, af::array &centroids, af::array &labels, float tolerance, int maxIterations) {
+    auto length = static_cast<int64_t>(tss.dims(0));
+    auto n = static_cast<int64_t>(tss.dims(1));
+    auto k = static_cast<int64_t>(centroids.dims(1));
+    std::vector<double> data(static_cast<size_t>(length * n));
+    tss.as(af::dtype::f64).host(data.data());
+    std::vector<double> means(static_cast<size_t>(length * k));
+    centroids.as(af::dtype::f64).host(means.data());
+    std::vector<double> newMeans(means.size());
+
+    std::vector<double> upper(static_cast<size_t>(n));
+    std::vector<double> lower(static_cast<size_t>(n));
+    std::vector<double> halfGap(static_cast<size_t>(k));
+    std::vector<double> shifts(static_cast<size_t>(k));
+    std::vector<unsigned int> hostLabels(static_cast<size_t>(n), 0);
+
+    // The bounds accumulate the rounding errors of the distances and the shifts, which are relative to the norms of
+    // the time series and the centroids, and the means never have a larger norm than the largest of them.
+    std::vector<double> margin(static_cast<size_t>(n));
+    auto slack = 4.0 * static_cast<double>(length + maxIterations + 2) * std::numeric_limits<double>::epsilon();
+    double largestNorm = af::max<double>(matrixNorm(centroids.as(af::dtype::f64)));
+    khiva::parallelutil::parallelFor(0, n, [&](int64_t i) {
+        const double *ts = data.data() + i * length;
+        margin[i] = std::sqrt(std::inner_product(ts, ts + length, ts, 0.0));
+    });
+    largestNorm = std::max(largestNorm, *std::max_element(margin.begin(), margin.end()));
+    for (auto &m : margin) {
+        m = slack * (m + largestNorm);
     }
 
-    // Get maximum Eigen Value
-    af::array maxEigenValue;
-    af::array indMaxEigenValue;
-    af::max(maxEigenValue, indMaxEigenValue, eigenValues, 0);
+    float error = std::numeric_limits<float>::max();
+    int iter = 0;
+    while ((error > tolerance) && (iter < maxIterations)) {
+        // 1. Assignment. Half of the distance from every centroid to its closest one.
+        for (int64_t j = 0; j < k; j++) {
+            double closest = std::numeric_limits<double>::infinity();
+            for (int64_t other = 0; other < k; other++) {
+                if (other != j) {
+                    closest = std::min(closest, squaredDistance(means.data() + j * length,
+                                                                means.data() + other * length, length));
+                }
+            }
+            halfGap[j] = std::sqrt(closest) / 2.0;
+        }
 
-    // Extract first EigenVector
-    return af::lookup(eigenVectors, indMaxEigenValue, 1);
+        auto first = (iter == 0);
+        khiva::parallelutil::parallelFor(
+            0, n,
+            [&](int64_t i) {
+                const double *ts = data.data() + i * length;
+                if (first) {
+                    closestTwo(ts, means, length, k, hostLabels[i], upper[i], lower[i]);
+                    return;
+                }
+                // the label can only change when the upper bound is not strictly below both bounds
+                auto bound = std::max(halfGap[hostLabels[i]], lower[i]) - margin[i];
+                if (upper[i] < bound) {
+                    return;
+                }
+                upper[i] = std::sqrt(squaredDistance(ts, means.data() + hostLabels[i] * length, length));
+                if (upper[i] < bound) {
+                    return;
+                }
+                closestTwo(ts, means, length, k, hostLabels[i], upper[i], lower[i]);
+            },
+            1024);
+
+        // 2. Compute new means
+        labels = af::array(1, n, hostLabels.data());
+        af::array next = computeNewMeans(tss, labels, centroids);
+
+        // 3. Compute convergence
+        error = computeError(centroids, next);
+
+        // 4. Update means and move the bounds with them
+        centroids = next;
+        centroids.as(af::dtype::f64).host(newMeans.data());
+        for (int64_t j = 0; j < k; j++) {
+            shifts[j] = std::sqrt(squaredDistance(means.data() + j * length, newMeans.data() + j * length, length));
+        }
+        means.swap(newMeans);
+
+        auto largest = std::max_element(shifts.begin(), shifts.end()) - shifts.begin();
+        double secondLargest = 0.0;
+        for (int64_t j = 0; j < k; j++) {
+            if (j != largest) {
+                secondLargest = std::max(secondLargest, shifts[j]);
+            }
+        }
+        khiva::parallelutil::parallelFor(
+            0, n,
+            [&](int64_t i) {
+                upper[i] += shifts[hostLabels[i]];
+                lower[i] -= (hostLabels[i] == largest) ? secondLargest : shifts[largest];
+            },
+            4096);
+
+        iter++;
+    }
 }
 
 /**
- * This function computes the Normalized Crosscorrelation between ts and the reference centroid.
+ * Computes the initial centroids of kMeans when they are not given.
  *
- * @param ts        The time series.
- * @param centroid  The reference centroid.
- * @return          The normalized crosscorrelation.
+ * @param tss       The time series.
+ * @param k         The number of centroids.
+ * @param centroids The given centroids, if not empty they are kept.
+ * @param labels    The given labels.
  */
-af::array ncc(const af::array &ts, const af::array &centroid) {
-    dim_t nElements = ts.dims(0);
+void initialMeans(const af::array &tss, int k, af::array &centroids, const af::array &labels) {
+    if (k < 1 || k > tss.dims(1)) {
+        throw std::invalid_argument("The number of centroids must be between one and the number of time series.");
+    }
+
+    if (centroids.isempty()) {
+        if (labels.isempty()) {
+            // initial guess of means with k-means++ seeding
+            centroids = calculateInitialMeans(tss, k);
+        } else {
+            // the initial means are the ones of the given labels
+            centroids = computeNewMeans(tss, labels, af::constant(0, tss.dims(0), k, tss.type()));
+        }
+    }
+}
+
+/**
+ * Runs Lloyd's iterations from the given centroids.
+ *
+ * @param tss           The time series.
+ * @param centroids     The initial centroids, which receive the resulting ones.
+ * @param labels        Receives the labels of the time series.
+ * @param tolerance     The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ * @return              The number of iterations performed.
+ */
+int lloyd(const af::array &tss, af::array &centroids, af::array &labels, float tolerance, int maxIterations) {
+    float error = std::numeric_limits<float>::max();
+
+    af::array distances = af::constant(0, tss.dims(1), tss.type());
+    af::array newMeans;
+    int iter = 0;
+
+    // Stop updating after convergence is reached.
+    while ((error > tolerance) && (iter < maxIterations)) {
+        // 1. Compute distances to current means
+        euclideanDistance(tss, centroids, distances, labels);
 
-    af::array tsNorm = af::sqrt(af::sum(af::pow(ts, 2)));
-    af::array centroidNorm = af::sqrt(af::sum(af::pow(centroid, 2)));
+        // 2. Compute new means
+        newMeans = computeNewMeans(tss, labels, centroids);
+
+        // 3. Compute convergence
+        error = computeError(centroids, newMeans);
 
-    return af::convolve(centroid, af::flip(ts, 0), AF_CONV_EXPAND) / af::tile(centroidNorm * tsNorm, nElements * 2 - 1);
+        // 4. Update Means
+        centroids = newMeans;
+        iter++;
+    }
+
+    return iter;
 }
 
 /**
- * Computes the normalized crosscorrelation for all time series and all centroids.
+ * Computes the k-means objective, which is the sum of the squared distances of the time series to their centroids.
  *
- * @param tss       The set of time series.
- * @param centroids The set of centroids.
- * @return          The computed normalized CrossCorrelation.
+ * @param tss       The time series.
+ * @param centroids The centroids.
+ * @param labels    The labels of the time series.
+ * @return          The inertia.
  */
-af::array ncc3Dim(const af::array &tss, const af::array &centroids) {
-    // Combination of all pairs of norms
-    af::array den = af::matmul(matrixNorm(centroids).T(), matrixNorm(tss));
-    den(den == 0) = af::Inf;
-    auto distanceSize = centroids.dims(0) * 2 - 1;
+double inertia(const af::array &tss, const af::array &centroids, const af::array &labels) {
+    af::array oneHot = oneHotLabels(labels, tss.dims(1), centroids.dims(1), tss.type());
+    return af::sum<double>(af::max(squaredDistances(tss, centroids), 0.0) * oneHot.T());
+}
+
+/**
+ * Runs the kShape iterations from the given centroids and labels.
+ *
+ * @param normTSS       The z-normalized time series.
+ * @param tssSpectra    The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param tssNorms      The 2-norm of every time series.
+ * @param centroids     The initial centroids, which receive the resulting ones.
+ * @param labels        The initial labels, which receive the resulting ones.
+ * @param tolerance     The error tolerance to stop the computation of the centroids.
+ * @param maxIterations The maximum number of iterations allowed.
+ * @return              The number of iterations performed.
+ */
+int kShapeIterations(const af::array &normTSS, const af::array &tssSpectra, const af::array &tssNorms,
+                     af::array &centroids, af::array &labels, float tolerance, int maxIterations) {
+    af::array newCentroids;
+    float error = std::numeric_limits<float>::max();
+    int iter = 0;
+
+    // Stop Criteria: Stop updating after convergence or maximum number iterations is reached.
+    while ((error > tolerance) && (iter < maxIterations)) {
+        // 1. Refinement step. New centroids computation.
+        newCentroids = refinementStep(normTSS, tssSpectra, centroids, labels);
+
+        // 2. Assignment step. New labels computation.
+        labels = assignmentStep(tssSpectra, tssNorms, newCentroids);
+
+        // 3. Compute convergence
+        error = computeError(centroids, newCentroids);
+
+        // 4. Update Centroids
+        centroids = newCentroids;
+
+        iter++;
+    }
+
+    return iter;
+}
+
+/**
+ * Computes the kShape objective, which is the sum of the shape-based distances of the time series to their
+ * centroids.
+ *
+ * @param tssSpectra    The spectra of the time series, with a length of fftutil::crossCorrelationLength.
+ * @param tssNorms      The 2-norm of every time series.
+ * @param centroids     The centroids.
+ * @param labels        The labels of the time series.
+ * @return              The sum of the shape-based distances.
+ */
+double sbdObjective(const af::array &tssSpectra, const af::array &tssNorms, const af::array &centroids,
+                    const af::array &labels) {
+    af::array oneHot = oneHotLabels(labels, tssNorms.dims(1), centroids.dims(1), tssNorms.type());
+    return af::sum<double>((1 - maxNcc(tssSpectra, tssNorms, centroids)) * oneHot.T());
+}
+
+/**
+ * Runs fn(r) for every restart r on the host threads. The threads use the backend and device of the caller, so the
+ * work of the restarts is interleaved on the same device.
+ *
+ * @param restarts  The number of restarts.
+ * @param fn        The function running a restart.
+ */
+template <typename Function>
+void forEachRestart(int restarts, Function fn) {
+    auto backend = af::getActiveBackend();
+    auto device = af::getDevice();
+    khiva::parallelutil::parallelFor(0, restarts, [&](int64_t r) {
+        if (af::getActiveBackend() != backend) {
+            af::setBackend(backend);
+        }
+        if (af::getDevice() != device) {
+            af::setDevice(device);
+        }
+        fn(static_cast<int>(r));
+    });
+}
+
+/**
+ * Keeps the run with the lowest objective and builds the statistics of all the runs.
+ *
+ * @param runCentroids  The centroids of every run.
+ * @param runLabels     The labels of every run.
+ * @param objectives    The objective of every run.
+ * @param iterations    The number of iterations of every run.
+ * @param centroids     Receives the centroids of the best run.
+ * @param labels        Receives the labels of the best run.
+ * @param stats         Receives an array of 2 x restarts with the objective and the number of iterations of every
+ *                      run.
+ */
+void selectBestRun(const std::vector<af::array> &runCentroids, const std::vector<af::array> &runLabels,
+                   const std::vector<double> &objectives, const std::vector<double> &iterations, af::array &centroids,
+                   af::array &labels, af::array &stats) {
+    auto best = std::min_element(objectives.begin(), objectives.end()) - objectives.begin();
+    centroids = runCentroids[best];
+    labels = runLabels[best];
+
+    std::vector<double> hostStats;
+    for (size_t r = 0; r < objectives.size(); r++) {
+        hostStats.push_back(objectives[r]);
+        hostStats.push_back(iterations[r]);
+    }
+    stats = af::array(2, static_cast<dim_t>(objectives.size()), hostStats.data());
+}
+
+/**
+ * Distances read from a condensed distance matrix.
+ */
+class CondensedDistances {
+   public:
+    CondensedDistances(std::vector<double> data, int64_t n) : data(std::move(data)), n(n) {}
+
+    double operator()(int64_t i, int64_t j) const {
+        if (i == j) {
+            return 0.0;
+        }
+        return (i < j) ? data[khiva::condensedutil::condensedIndex(n, i, j)]
+                       : data[khiva::condensedutil::condensedIndex(n, j, i)];
+    }
+
+   private:
+    std::vector<double> data;
+    int64_t n;
+};
+
+/**
+ * Distances computed by a function every time they are needed, which is called with the lowest observation first.
+ */
+class FunctionDistances {
+   public:
+    explicit FunctionDistances(std::function<double(int64_t, int64_t)> distance) : distance(std::move(distance)) {}
+
+    double operator()(int64_t i, int64_t j) const {
+        if (i == j) {
+            return 0.0;
+        }
+        return (i < j) ? distance(i, j) : distance(j, i);
+    }
+
+   private:
+    std::function<double(int64_t, int64_t)> distance;
+};
+
+/**
+ * The distances to the medoids and the nearest and second nearest medoids of every observation.
+ */
+struct MedoidAssignment {
+    // the distances from every medoid to every observation, so they are only computed when a medoid changes
+    std::vector<std::vector<double>> medoidDistances;
+    std::vector<unsigned int> nearest;
+    std::vector<unsigned int> second;
+    std::vector<double> nearestDistance;
+    std::vector<double> secondDistance;
+};
+
+/**
+ * Finds the nearest and second nearest medoids of an observation from the distances to the medoids. On ties, the
+ * first medoid wins.
+ *
+ * @param assignment    The distances to the medoids, which receives the nearest and second nearest of them.
+ * @param o             The observation.
+ */
+void rankMedoids(MedoidAssignment &assignment, int64_t o) {
+    auto best = std::numeric_limits<double>::infinity();
+    auto second = std::numeric_limits<double>::infinity();
+    unsigned int bestLabel = 0;
+    unsigned int secondLabel = 0;
+    for (size_t i = 0; i < assignment.medoidDistances.size(); i++) {
+        auto d = assignment.medoidDistances[i][o];
+        if (d < best) {
+            second = best;
+            secondLabel = bestLabel;
+            best = d;
+            bestLabel = static_cast<unsigned int>(i);
+        } else if (d < second) {
+            second = d;
+            secondLabel = static_cast<unsigned int>(i);
+        }
+    }
+    assignment.nearest[o] = bestLabel;
+    assignment.second[o] = secondLabel;
+    assignment.nearestDistance[o] = best;
+    assignment.secondDistance[o] = second;
+}
+
+/**
+ * Computes the distances to the medoids and the nearest and second nearest medoids of every observation.
+ *
+ * @param distance  The distance between two observations.
+ * @param n         The number of observations.
+ * @param medoids   The observations which are medoids.
+ * @param assignment Receives the distances to the medoids and the nearest and second nearest of them.
+ */
+template <typename Distance>
+void assignToMedoids(const Distance &distance, int64_t n, const std::vector<int64_t> &medoids,
+                     MedoidAssignment &assignment) {
+    assignment.medoidDistances.assign(medoids.size(), std::vector<double>(static_cast<size_t>(n)));
+    assignment.nearest.resize(static_cast<size_t>(n));
+    assignment.second.resize(static_cast<size_t>(n));
+    assignment.nearestDistance.resize(static_cast<size_t>(n));
+    assignment.secondDistance.resize(static_cast<size_t>(n));
+    khiva::parallelutil::parallelFor(
+        0, n,
+        [&](int64_t o) {
+            for (size_t i = 0; i < medoids.size(); i++) {
+                assignment.medoidDistances[i][o] = distance(o, medoids[i]);
+            }
+            rankMedoids(assignment, o);
+        },
+        256);
+}
+
+/**
+ * Updates the assignment after the medoid in a position is replaced. Only the distances to the new medoid are
+ * computed, and only the observations whose nearest or second nearest medoid was replaced are ranked again from all
+ * the medoids, in O(n + k * changed) time instead of O(n * k).
+ *
+ * @param distance  The distance between two observations.
+ * @param n         The number of observations.
+ * @param medoids   The observations which are medoids, already with the new one.
+ * @param position  The position of the medoid replaced.
+ * @param assignment The assignment to the previous medoids, which receives the one to the new medoids.
+ */
+template <typename Distance>
+void updateAssignment(const Distance &distance, int64_t n, const std::vector<int64_t> &medoids, unsigned int position,
+                      MedoidAssignment &assignment) {
+    auto &row = assignment.medoidDistances[position];
+    khiva::parallelutil::parallelFor(
+        0, n,
+        [&](int64_t o) {
+            row[o] = distance(o, medoids[position]);
+            if (assignment.nearest[o] == position || assignment.second[o] == position) {
+                rankMedoids(assignment, o);
+                return;
+            }
+            // the rest of the medoids keep their order, so the new one is only compared with the two nearest of them
+            auto d = row[o];
+            if (d < assignment.nearestDistance[o] ||
+                (d == assignment.nearestDistance[o] && position < assignment.nearest[o])) {
+                assignment.second[o] = assignment.nearest[o];
+                assignment.secondDistance[o] = assignment.nearestDistance[o];
+                assignment.nearest[o] = position;
+                assignment.nearestDistance[o] = d;
+            } else if (d < assignment.secondDistance[o] ||
+                       (d == assignment.secondDistance[o] && position < assignment.second[o])) {
+                assignment.second[o] = position;
+                assignment.secondDistance[o] = d;
+            }
+        },
+        256);
+}
 
-    af::array cc = af::constant(0, centroids.dims(1), tss.dims(1), distanceSize, tss.type());
-    for (dim_t i = 0; i < centroids.dims(1); ++i) {
-        for (dim_t j = 0; j < tss.dims(1); ++j) {
-            cc(i, j, af::span) = af::convolve(tss.col(j), af::flip(centroids.col(i), 0), AF_CONV_EXPAND);
+/**
+ * Chooses k initial medoids with k-means++ seeding: the first medoid is a random observation and every next one is an
+ * observation chosen with a probability proportional to its squared distance to the closest medoid already chosen.
+ *
+ * @param distance  The distance between two observations.
+ * @param n         The number of observations.
+ * @param k         The number of medoids.
+ * @return          The observations which are medoids.
+ */
+template <typename Distance>
+std::vector<int64_t> initialMedoids(const Distance &distance, int64_t n, int k) {
+    std::mt19937 rng(std::random_device{}());
+    std::vector<int64_t> medoids;
+    medoids.push_back(std::uniform_int_distribution<int64_t>(0, n - 1)(rng));
+    std::vector<double> closest(static_cast<size_t>(n));
+    khiva::parallelutil::parallelFor(0, n, [&](int64_t o) { closest[o] = distance(o, medoids[0]); }, 256);
+
+    while (static_cast<int>(medoids.size()) < k) {
+        double total = 0.0;
+        for (auto d : closest) {
+            total += d * d;
+        }
+        int64_t next = -1;
+        if (total > 0) {
+            // first observation whose cumulative weight reaches the random threshold
+            auto threshold = std::uniform_real_distribution<double>(0.0, 1.0)(rng) * total;
+            double cumulative = 0.0;
+            for (int64_t o = 0; o < n && next < 0; o++) {
+                cumulative += closest[o] * closest[o];
+                if (closest[o] > 0 && cumulative >= threshold) {
+                    next = o;
+                }
+            }
+        }
+        if (next < 0) {
+            // all the observations are at distance zero of a medoid, so the first one which is not a medoid is taken
+            for (int64_t o = 0; o < n && next < 0; o++) {
+                if (std::find(medoids.begin(), medoids.end(), o) == medoids.end()) {
+                    next = o;
+                }
+            }
         }
+        medoids.push_back(next);
+        khiva::parallelutil::parallelFor(0, n, [&](int64_t o) { closest[o] = std::min(closest[o], distance(o, next)); },
+                                         256);
     }
 
-    den = af::tile(den, 1, 1, static_cast<unsigned int>(distanceSize));
-    return (cc / den);
+    return medoids;
 }
 
 /**
- * This function computes the Shape based distance.
+ * Computes the change of the total deviation when the candidate replaces every medoid, and returns the best one.
  *
- * @param ts            The target time series.
- * @param centroid      The centroid acting as reference.
- * @return              The resulting shift over the original time series that gets the maximum correlation with
- * centroid.
+ * @param distance      The distance between two observations.
+ * @param n             The number of observations.
+ * @param k             The number of medoids.
+ * @param assignment    The nearest and second nearest medoids of every observation.
+ * @param removalLoss   The increase of the total deviation when every medoid is removed.
+ * @param candidate     The observation which would become a medoid.
+ * @param delta         Scratch buffer which receives the change of the total deviation for every medoid replaced.
+ * @param medoid        Receives the position of the medoid to replace.
+ * @return              The change of the total deviation.
  */
-af::array SBDShifted(const af::array &ts, const af::array &centroid) {
-    unsigned int index;
-    float correlation;
-    af::array shiftedTS;
-    af::array normCrossCorr = ncc(ts, centroid);
-    af::max(&correlation, &index, normCrossCorr);
+template <typename Distance>
+double swapDelta(const Distance &distance, int64_t n, int k, const MedoidAssignment &assignment,
+                 const std::vector<double> &removalLoss, int64_t candidate, std::vector<double> &delta, int &medoid) {
+    delta.assign(removalLoss.begin(), removalLoss.end());
+    double added = 0.0;
+    for (int64_t o = 0; o < n; o++) {
+        auto d = distance(o, candidate);
+        auto nearest = assignment.nearest[o];
+        if (d < assignment.nearestDistance[o]) {
+            // the observation moves to the candidate, which it also does if its medoid is removed
+            added += d - assignment.nearestDistance[o];
+            if (k > 1) {
+                delta[nearest] += assignment.nearestDistance[o] - assignment.secondDistance[o];
+            }
+        } else if (k > 1 && d < assignment.secondDistance[o]) {
+            // the observation moves to the candidate instead of to its second medoid when its medoid is removed
+            delta[nearest] += d - assignment.secondDistance[o];
+        } else if (k == 1) {
+            delta[nearest] += d - assignment.nearestDistance[o];
+        }
+    }
 
-    auto tsLength = ts.dims(0);
-    auto shift = index - tsLength + 1;
+    medoid = static_cast<int>(std::min_element(delta.begin(), delta.end()) - delta.begin());
+    return delta[medoid] + added;
+}
 
-    if (shift >= 0) {
-        shiftedTS = af::join(0, af::constant(0, shift, ts.type()), ts(af::range(tsLength - shift), 0));
-    } else {
-        shiftedTS = af::join(0, ts(af::range(tsLength + shift) - shift, 0), af::constant(0, -shift, ts.type()));
+/**
+ * Computes the increase of the total deviation when every medoid is removed, which is the sum of the differences
+ * between the distances to the second and to the nearest medoid of its observations.
+ *
+ * @param n             The number of observations.
+ * @param k             The number of medoids.
+ * @param assignment    The nearest and second nearest medoids of every observation.
+ * @return              The removal loss of every medoid.
+ */
+std::vector<double> removalLosses(int64_t n, int k, const MedoidAssignment &assignment) {
+    std::vector<double> loss(static_cast<size_t>(k), 0.0);
+    if (k > 1) {
+        for (int64_t o = 0; o < n; o++) {
+            loss[assignment.nearest[o]] += assignment.secondDistance[o] - assignment.nearestDistance[o];
+        }
     }
+    return loss;
+}
+
+/**
+ * Runs FasterPAM. The candidates are visited in order and swapped eagerly as soon as they improve the total deviation.
+ * Blocks of SWAP_CANDIDATES_BLOCK candidates are evaluated concurrently and the best one of the block is swapped, after
+ * which the search continues with the candidate next to it.
+ *
+ * @param distance      The distance between two observations.
+ * @param n             The number of observations.
+ * @param k             The number of medoids.
+ * @param medoids       The initial medoids, which receive the resulting ones.
+ * @param assignment    Receives the distances to the medoids and the nearest and second nearest of them.
+ * @param maxIterations The maximum number of passes over the candidates.
+ */
+template <typename Distance>
+void fasterPam(const Distance &distance, int64_t n, int k, std::vector<int64_t> &medoids,
+               MedoidAssignment &assignment, int maxIterations) {
+    assignToMedoids(distance, n, medoids, assignment);
+    std::vector<double> removalLoss = removalLosses(n, k, assignment);
+    std::vector<char> isMedoid(static_cast<size_t>(n), 0);
+    for (auto m : medoids) {
+        isMedoid[m] = 1;
+    }
+    auto totalDeviation = std::accumulate(assignment.nearestDistance.begin(), assignment.nearestDistance.end(), 0.0);
+
+    int64_t next = 0;
+    int64_t sinceLastSwap = 0;
+    int64_t visited = 0;
+    auto maxVisited = static_cast<int64_t>(std::max(maxIterations, 0)) * n;
+    std::vector<int64_t> block;
+    std::vector<int64_t> positions;
+    std::vector<double> deltas;
+    std::vector<int> replaced;
+    // every candidate of a block evaluates its swaps in its own buffer, which is reused by the next blocks
+    std::vector<std::vector<double>> scratch(static_cast<size_t>(SWAP_CANDIDATES_BLOCK));
+
+    // stop after a whole pass over the candidates without any swap
+    while (sinceLastSwap < n && visited < maxVisited) {
+        block.clear();
+        positions.clear();
+        for (int64_t scanned = 0; static_cast<int64_t>(block.size()) < SWAP_CANDIDATES_BLOCK &&
+                                  sinceLastSwap + scanned < n && visited + scanned < maxVisited;
+             scanned++) {
+            auto candidate = (next + scanned) % n;
+            if (!isMedoid[candidate]) {
+                block.push_back(candidate);
+                positions.push_back(scanned);
+            }
+        }
+        auto scanned = std::min(n - sinceLastSwap, maxVisited - visited);
+        if (!positions.empty() && static_cast<int64_t>(block.size()) == SWAP_CANDIDATES_BLOCK) {
+            scanned = positions.back() + 1;
+        }
 
-    return shiftedTS;
+        deltas.resize(block.size());
+        replaced.resize(block.size());
+        khiva::parallelutil::parallelFor(0, static_cast<int64_t>(block.size()), [&](int64_t b) {
+            deltas[b] = swapDelta(distance, n, k, assignment, removalLoss, block[b], scratch[b], replaced[b]);
+        });
+
+        auto best = std::min_element(deltas.begin(), deltas.end()) - deltas.begin();
+        if (!block.empty() && deltas[best] < -std::numeric_limits<double>::epsilon() * totalDeviation) {
+            isMedoid[medoids[replaced[best]]] = 0;
+            medoids[replaced[best]] = block[best];
+            isMedoid[block[best]] = 1;
+            updateAssignment(distance, n, medoids, static_cast<unsigned int>(replaced[best]), assignment);
+            removalLoss = removalLosses(n, k, assignment);
+            totalDeviation =
+                std::accumulate(assignment.nearestDistance.begin(), assignment.nearestDistance.end(), 0.0);
+
+            // continue with the candidate next to the swapped one
+            next = (next + positions[best] + 1) % n;
+            visited += positions[best] + 1;
+            sinceLastSwap = 0;
+        } else {
+            next = (next + scanned) % n;
+            visited += scanned;
+            sinceLastSwap += scanned;
+        }
+    }
 }
 
 /**
- * This function returns an updated shape of the centroid passed as argument w.r.t. the tss.
+ * Reads the initial medoids given by the user, or chooses them with k-means++ seeding if they are empty.
  *
- * @param tss       The subset of time series acting on the centroid.
- * @param centroid  The given centroid.
- * @return          The updated shape of the centroid.
+ * @param distance  The distance between two observations.
+ * @param n         The number of observations.
+ * @param k         The number of medoids.
+ * @param medoids   The given medoids.
+ * @return          The initial medoids.
  */
-af::array shapeExtraction(const af::array &tss, const af::array &centroid) {
-    int ntss = tss.dims(1);
-    int nelements = tss.dims(0);
-    af::array shiftedTSS = af::constant(0, tss.dims(0), tss.dims(1), tss.type());
-    af::array shiftedTSi = af::constant(0, tss.dims(0), 1, tss.type());
-    af::array dist;
+template <typename Distance>
+std::vector<int64_t> startingMedoids(const Distance &distance, int64_t n, int k, const af::array &medoids) {
+    if (k < 1 || k > n) {
+        throw std::invalid_argument("The number of medoids must be between one and the number of time series.");
+    }
+    if (medoids.isempty()) {
+        return initialMedoids(distance, n, k);
+    }
+    if (medoids.elements() != k) {
+        throw std::invalid_argument("The number of initial medoids must be k.");
+    }
 
-    for (int i = 0; i < ntss; i++) {
-        af::array condition = af::tile(af::allTrue(af::iszero(centroid)), nelements, 1);
-        shiftedTSi = af::select(condition, tss.col(i), SBDShifted(tss.col(i), centroid));
-        shiftedTSS(af::span, i) = shiftedTSi;
+    std::vector<int64_t> result(static_cast<size_t>(k));
+    af::flat(medoids).as(af::dtype::s64).host(result.data());
+    auto sorted = result;
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.front() < 0 || sorted.back() >= n || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        throw std::invalid_argument("The initial medoids must be distinct time series.");
     }
+    return result;
+}
 
-    shiftedTSS = khiva::normalization::znorm(shiftedTSS);
-    af::array s = af::matmul(shiftedTSS, shiftedTSS.T());
-    af::array q =
-        af::identity(nelements, nelements) - (af::constant(1.0, nelements, nelements, tss.type()) / nelements);
-    af::array m = af::matmul(q.T(), s, q);
+/**
+ * Runs FasterPAM and returns its result as arrays.
+ *
+ * @param distance      The distance between two observations.
+ * @param n             The number of observations.
+ * @param k             The number of medoids.
+ * @param medoids       The initial medoids, which receive the resulting ones.
+ * @param labels        Receives the labels of the observations.
+ * @param maxIterations The maximum number of passes over the candidates.
+ */
+template <typename Distance>
+void kMedoidsInternal(const Distance &distance, int64_t n, int k, af::array &medoids, af::array &labels,
+                      int maxIterations) {
+    std::vector<int64_t> hostMedoids = startingMedoids(distance, n, k, medoids);
+    MedoidAssignment assignment;
+    fasterPam(distance, n, k, hostMedoids, assignment, maxIterations);
+
+    std::vector<unsigned int> medoidIndexes(hostMedoids.begin(), hostMedoids.end());
+    medoids = af::array(1, k, medoidIndexes.data());
+    labels = af::array(1, n, assignment.nearest.data());
+}
 
-    af::array first = getFirstEigenVector(m);
+/**
+ * Reads a distance matrix as a condensed vector.
+ *
+ * @param distances The distances, either as a square matrix of which only the upper triangle is read or as a
+ *                  condensed vector.
+ * @param condensed Whether distances is a condensed vector.
+ * @param n         Receives the number of observations.
+ * @return          The condensed distances.
+ */
+std::vector<double> toCondensed(const af::array &distances, bool condensed, int64_t &n) {
+    if (condensed) {
+        n = khiva::condensedutil::condensedObservations(distances.elements());
+        if (n < 0 || (distances.dims(0) != 1 && distances.dims(1) != 1)) {
+            throw std::invalid_argument("The condensed distances must be a vector of n * (n - 1) / 2 elements.");
+        }
+        std::vector<double> result(static_cast<size_t>(distances.elements()));
+        distances.as(af::dtype::f64).host(result.data());
+        return result;
+    }
 
-    af::array findDistance1 = af::sqrt(af::sum(af::pow((shiftedTSS(af::span, 0) - first), 2)));
-    af::array findDistance2 = af::sqrt(af::sum(af::pow((shiftedTSS(af::span, 0) + first), 2)));
+    n = distances.dims(0);
+    if (distances.dims(1) != n || distances.dims(2) != 1 || distances.dims(3) != 1) {
+        throw std::invalid_argument("The distances must be a square matrix.");
+    }
+    // The upper triangle is copied in blocks of columns, so only the condensed distances and one block are resident
+    std::vector<double> result(static_cast<size_t>(khiva::condensedutil::condensedSize(n)));
+    auto width = std::max<int64_t>(1, CONDENSED_BLOCK_ELEMENTS / std::max<int64_t>(n, 1));
+    std::vector<double> block;
+    for (int64_t begin = 1; begin < n; begin += width) {
+        auto end = std::min(begin + width, n);
+        // rows above the diagonal of the last column of the block
+        auto rows = end - 1;
+        block.resize(static_cast<size_t>(rows * (end - begin)));
+        af::seq rowSeq(0, static_cast<double>(rows - 1));
+        af::seq columnSeq(static_cast<double>(begin), static_cast<double>(end - 1));
+        distances(rowSeq, columnSeq).as(af::dtype::f64).host(block.data());
+        for (int64_t j = begin; j < end; j++) {
+            for (int64_t i = 0; i < j; i++) {
+                result[khiva::condensedutil::condensedIndex(n, i, j)] = block[i + (j - begin) * rows];
+            }
+        }
+    }
+    return result;
+}
 
-    af::array condition = findDistance1 >= findDistance2;
-    first = af::select(af::tile(condition, first.dims(0), 1), khiva::normalization::znorm(first * (-1)),
-                       khiva::normalization::znorm(first));
+/**
+ * A merge of two clusters, identified by any of their observations.
+ */
+struct Merge {
+    int64_t first;
+    int64_t second;
+    double distance;
+};
+
+/**
+ * Computes the single linkage merges with Prim's algorithm for the minimum spanning tree, in O(n^2) time and O(n)
+ * additional memory. The observations outside the tree are kept packed, so every step relaxes their distances to the
+ * new node of the tree and finds the closest of them in a single pass. When the distances of a step are expensive
+ * enough to pay for starting threads, the pass is split in blocks whose closest observations are reduced afterwards.
+ *
+ * @param distance  The distance between two observations.
+ * @param n         The number of observations.
+ * @param cost      The number of elements compared by every distance.
+ * @return          The merges in the order they are found.
+ */
+template <typename Distance>
+std::vector<Merge> singleLinkage(const Distance &distance, int64_t n, int64_t cost = 1) {
+    std::vector<Merge> merges;
+    std::vector<int64_t> remaining(static_cast<size_t>(n - 1));
+    std::vector<double> closest(static_cast<size_t>(n - 1), std::numeric_limits<double>::infinity());
+    for (int64_t i = 1; i < n; i++) {
+        remaining[i - 1] = i;
+    }
+    int64_t current = 0;
+
+    // the packing reorders the observations, so ties go to the lowest one as in a scan by position
+    auto closer = [&](size_t a, size_t b) {
+        return closest[a] < closest[b] || (closest[a] == closest[b] && remaining[a] < remaining[b]);
+    };
+    auto relax = [&](size_t begin, size_t end) {
+        size_t next = begin;
+        for (size_t r = begin; r < end; r++) {
+            closest[r] = std::min(closest[r], distance(current, remaining[r]));
+            if (closer(r, next)) {
+                next = r;
+            }
+        }
+        return next;
+    };
+    auto workers = static_cast<int64_t>(khiva::parallelutil::numWorkers());
+    std::vector<size_t> partial(static_cast<size_t>(workers));
+
+    while (!remaining.empty()) {
+        auto size = remaining.size();
+        size_t next;
+        if (workers > 1 && static_cast<int64_t>(size) * cost >= PRIM_PARALLEL_WORK) {
+            auto blockSize = (size + static_cast<size_t>(workers) - 1) / static_cast<size_t>(workers);
+            khiva::parallelutil::parallelFor(0, workers, [&](int64_t w) {
+                auto begin = std::min(size, static_cast<size_t>(w) * blockSize);
+                auto end = std::min(size, begin + blockSize);
+                partial[w] = (begin < end) ? relax(begin, end) : size;
+            });
+            next = partial[0];
+            for (int64_t w = 1; w < workers; w++) {
+                if (partial[w] < size && closer(partial[w], next)) {
+                    next = partial[w];
+                }
+            }
+        } else {
+            next = relax(0, size);
+        }
+        merges.push_back({current, remaining[next], closest[next]});
+        current = remaining[next];
+        remaining[next] = remaining.back();
+        closest[next] = closest[size - 1];
+        remaining.pop_back();
+    }
 
-    return first;
+    return merges;
 }
 
 /**
- * This function performs the refinement step.
+ * Computes the distance between the cluster k and the union of the clusters i and j with the Lance-Williams formula
+ * of the linkage method.
+ */
+double lanceWilliams(khiva::clustering::Linkage method, double dki, double dkj, double dij, double ni, double nj,
+                     double nk) {
+    switch (method) {
+        case khiva::clustering::KHIVA_LINKAGE_COMPLETE:
+            return std::max(dki, dkj);
+        case khiva::clustering::KHIVA_LINKAGE_AVERAGE:
+            return (ni * dki + nj * dkj) / (ni + nj);
+        case khiva::clustering::KHIVA_LINKAGE_WARD:
+            return std::sqrt(
+                std::max(0.0, ((ni + nk) * dki * dki + (nj + nk) * dkj * dkj - nk * dij * dij) / (ni + nj + nk)));
+        default:
+            return std::min(dki, dkj);
+    }
+}
+
+/**
+ * Computes the merges of a reducible linkage method with the nearest-neighbour chain algorithm in O(n^2) time. The
+ * chain follows nearest neighbours until two clusters are reciprocal nearest neighbours, which are merged. The
+ * distances to the merged cluster are updated in place with the Lance-Williams formula.
  *
- * @param tss       The set of time series in columnar manner.
- * @param centroids The set of centroids in columnar mode.
- * @param labels    The set of labels.
- * @return          The new centroids.
+ * [1] D. Müllner. 2011. Modern hierarchical, agglomerative clustering algorithms. arXiv:1109.2378.
+ *
+ * @param distances The condensed distances, which are overwritten.
+ * @param n         The number of observations.
+ * @param method    The linkage method.
+ * @return          The merges in the order they are found.
  */
-af::array refinementStep(const af::array &tss, const af::array &centroids, const af::array &labels) {
-    auto ncentroids = centroids.dims(1);
-    af::array subset;
-    af::array result = centroids;
+std::vector<Merge> nearestNeighbourChain(std::vector<double> &distances, int64_t n, khiva::clustering::Linkage method) {
+    auto distance = [&](int64_t i, int64_t j) -> double & {
+        return distances[khiva::condensedutil::condensedIndex(n, std::min(i, j), std::max(i, j))];
+    };
+    std::vector<Merge> merges;
+    std::vector<double> size(static_cast<size_t>(n), 1.0);
+    std::vector<int64_t> active(static_cast<size_t>(n));
+    std::iota(active.begin(), active.end(), 0);
+    std::vector<int64_t> chain;
+
+    for (int64_t step = 0; step < n - 1; step++) {
+        if (chain.empty()) {
+            chain.push_back(active.front());
+        }
+
+        // follow the chain of nearest neighbours until two clusters are reciprocal nearest neighbours
+        int64_t x;
+        int64_t y;
+        double current;
+        while (true) {
+            x = chain.back();
+            y = (chain.size() > 1) ? chain[chain.size() - 2] : -1;
+            current = (y >= 0) ? distance(x, y) : std::numeric_limits<double>::infinity();
+            for (auto i : active) {
+                if (i != x && (y < 0 || distance(x, i) < current)) {
+                    y = i;
+                    current = distance(x, i);
+                }
+            }
+            if (chain.size() > 1 && y == chain[chain.size() - 2]) {
+                break;
+            }
+            chain.push_back(y);
+        }
+        chain.pop_back();
+        chain.pop_back();
+
+        // the merged cluster takes the place of the greater one
+        if (x > y) {
+            std::swap(x, y);
+        }
+        merges.push_back({x, y, current});
+        for (auto k : active) {
+            if (k != x && k != y) {
+                distance(k, y) = lanceWilliams(method, distance(k, x), distance(k, y), current, size[x], size[y],
+                                               size[k]);
+            }
+        }
+        size[y] += size[x];
+        active.erase(std::find(active.begin(), active.end(), x));
+    }
+
+    return merges;
+}
 
-    for (dim_t j = 0; j < ncentroids; j++) {
-        subset = selectSubset(tss, labels, j);
-        // if centroid j has at least one labeled time series.
-        if (!subset.isempty()) {
-            result(af::span, j) = shapeExtraction(subset, centroids.col(j));
+/**
+ * Sorts the merges by distance and numbers the clusters as scipy does: the observations are the clusters 0 to n - 1,
+ * and the cluster formed by the i-th merge is n + i.
+ *
+ * @param merges    The merges.
+ * @param n         The number of observations.
+ * @return          The (n - 1) x 4 linkage matrix in column-major order.
+ */
+std::vector<double> linkageRows(std::vector<Merge> merges, int64_t n) {
+    std::stable_sort(merges.begin(), merges.end(),
+                     [](const Merge &a, const Merge &b) { return a.distance < b.distance; });
+
+    // union-find over the clusters, where every cluster points to the one it was merged into
+    std::vector<int64_t> parent(static_cast<size_t>(2 * n - 1));
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<double> size(static_cast<size_t>(2 * n - 1), 1.0);
+    auto find = [&](int64_t x) {
+        auto root = x;
+        while (parent[root] != root) {
+            root = parent[root];
         }
+        while (parent[x] != root) {
+            auto next = parent[x];
+            parent[x] = root;
+            x = next;
+        }
+        return root;
+    };
+
+    auto rows = static_cast<int64_t>(merges.size());
+    std::vector<double> result(static_cast<size_t>(rows * 4));
+    for (int64_t i = 0; i < rows; i++) {
+        auto a = find(merges[i].first);
+        auto b = find(merges[i].second);
+        auto cluster = n + i;
+        parent[a] = cluster;
+        parent[b] = cluster;
+        size[cluster] = size[a] + size[b];
+        result[i] = static_cast<double>(std::min(a, b));
+        result[i + rows] = static_cast<double>(std::max(a, b));
+        result[i + 2 * rows] = merges[i].distance;
+        result[i + 3 * rows] = size[cluster];
     }
 
     return result;
 }
 
 /**
- * This function computes the assignment step. It is the update of time series labels w.r.t. the dinamics of the
- * centroids.
+ * Disjoint sets of observations with path compression.
+ */
+class DisjointSets {
+   public:
+    explicit DisjointSets(int64_t n) : parent(static_cast<size_t>(n)) { std::iota(parent.begin(), parent.end(), 0); }
+
+    int64_t find(int64_t x) {
+        auto root = x;
+        while (parent[root] != root) {
+            root = parent[root];
+        }
+        while (parent[x] != root) {
+            auto next = parent[x];
+            parent[x] = root;
+            x = next;
+        }
+        return root;
+    }
+
+    void unite(int64_t x, int64_t y) {
+        x = find(x);
+        y = find(y);
+        if (x != y) {
+            parent[std::max(x, y)] = std::min(x, y);
+        }
+    }
+
+   private:
+    std::vector<int64_t> parent;
+};
+
+/**
+ * Calls fn(i, neighbours) with the neighbours within radius of every time series. The range queries are run on the
+ * tree in blocks of RANGE_QUERIES_BLOCK time series, so only the neighbours of one block are kept in memory.
  *
- * @param tss       The set of time series in columnar manner.
- * @param centroids The set of centroids in columnar mode.
- * @param labels    The set of labels.
- * @return          The new set of labels.
+ * @param tree      The index of the time series.
+ * @param tss       The time series.
+ * @param radius    The radius of the queries.
+ * @param fn        The function receiving the neighbours of every time series.
  */
-af::array assignmentStep(const af::array &tss, const af::array &centroids, af::array labels) {
-    af::array min = af::constant(std::numeric_limits<float>::max(), tss.dims(1), tss.type());
-    af::array distances = 1 - af::max(ncc3Dim(tss, centroids), 2);
-    af::min(min, labels, distances, 0);
-    labels = labels.T();
+template <typename Function>
+void forEachNeighbourhood(const khiva::search::VPTree &tree, const af::array &tss, double radius, Function fn) {
+    auto n = static_cast<int64_t>(tss.dims(1));
+    for (int64_t start = 0; start < n; start += RANGE_QUERIES_BLOCK) {
+        auto end = std::min(start + RANGE_QUERIES_BLOCK, n);
+        auto neighbours =
+            tree.range(tss(af::span, af::seq(static_cast<double>(start), static_cast<double>(end - 1))), radius);
+        for (int64_t q = 0; q < end - start; q++) {
+            fn(start + q, neighbours[q]);
+        }
+    }
+}
 
+/**
+ * Extracts the flat clustering of HDBSCAN from the single linkage tree of the mutual reachability distances. The tree
+ * is condensed so that a split only creates new clusters when both sides have at least minClusterSize time series,
+ * and the clusters with the greatest excess of mass (stability) which do not overlap are selected.
+ *
+ * @param linkage           The linkage matrix, in column-major order.
+ * @param n                 The number of time series.
+ * @param minClusterSize    The minimum number of time series of a cluster.
+ * @return                  The label of every time series, -1 for noise.
+ */
+std::vector<int> excessOfMassLabels(const std::vector<double> &linkage, int64_t n, int64_t minClusterSize) {
+    auto rows = n - 1;
+    auto child = [&](int64_t node, int64_t side) { return static_cast<int64_t>(linkage[node - n + side * rows]); };
+    auto size = [&](int64_t node) { return (node < n) ? 1.0 : linkage[node - n + 3 * rows]; };
+
+    // cluster of every node of the single linkage tree, the root being the cluster 0 and -1 for the nodes whose time
+    // series have already left their cluster
+    std::vector<int64_t> clusterOf(static_cast<size_t>(2 * n - 1), -1);
+    std::vector<int64_t> clusterParent = {-1};
+    std::vector<double> birth = {0.0};
+    std::vector<double> stability = {0.0};
+    std::vector<int64_t> pointCluster(static_cast<size_t>(n), 0);
+    clusterOf[2 * n - 2] = 0;
+
+    // every time series below node leaves the cluster at lambda
+    auto fallOut = [&](int64_t node, int64_t cluster, double lambda) {
+        std::vector<int64_t> pending = {node};
+        while (!pending.empty()) {
+            auto current = pending.back();
+            pending.pop_back();
+            if (current < n) {
+                pointCluster[current] = cluster;
+                stability[cluster] += lambda - birth[cluster];
+            } else {
+                pending.push_back(child(current, 0));
+                pending.push_back(child(current, 1));
+            }
+        }
+    };
+
+    // the parents of the single linkage tree have greater ids than their children
+    for (auto node = 2 * n - 2; node >= n; node--) {
+        auto cluster = clusterOf[node];
+        if (cluster < 0) {
+            continue;
+        }
+        auto distance = linkage[node - n + 2 * rows];
+        auto lambda = (distance > 0) ? 1.0 / distance : std::numeric_limits<double>::max();
+        int64_t sides[] = {child(node, 0), child(node, 1)};
+        bool big[] = {size(sides[0]) >= minClusterSize, size(sides[1]) >= minClusterSize};
+
+        for (int s = 0; s < 2; s++) {
+            if (big[s] && big[1 - s]) {
+                // a true split, which creates a new cluster
+                clusterOf[sides[s]] = static_cast<int64_t>(clusterParent.size());
+                clusterParent.push_back(cluster);
+                birth.push_back(lambda);
+                stability.push_back(0.0);
+                stability[cluster] += (lambda - birth[cluster]) * size(sides[s]);
+            } else if (big[s]) {
+                // the cluster continues in the big side
+                clusterOf[sides[s]] = cluster;
+            } else {
+                fallOut(sides[s], cluster, lambda);
+            }
+        }
+    }
+
+    // the children of a cluster have greater ids than their parent, so the clusters are visited bottom-up and every
+    // one is kept if it is more stable than its selected descendants
+    auto numClusters = static_cast<int64_t>(clusterParent.size());
+    std::vector<char> selected(static_cast<size_t>(numClusters), 1);
+    std::vector<double> childrenStability(static_cast<size_t>(numClusters), 0.0);
+    selected[0] = 0;
+    for (auto c = numClusters - 1; c > 0; c--) {
+        if (childrenStability[c] > stability[c]) {
+            selected[c] = 0;
+            stability[c] = childrenStability[c];
+        }
+        childrenStability[clusterParent[c]] += stability[c];
+    }
+
+    // top-down, the selected clusters take the time series of their descendants
+    std::vector<int64_t> owner(static_cast<size_t>(numClusters), -1);
+    for (int64_t c = 1; c < numClusters; c++) {
+        auto parentOwner = owner[clusterParent[c]];
+        if (parentOwner >= 0) {
+            owner[c] = parentOwner;
+        } else if (selected[c]) {
+            owner[c] = c;
+        }
+    }
+    std::vector<int> label(static_cast<size_t>(numClusters), -1);
+
+    // the clusters are numbered in the order of their first time series
+    std::vector<int> labels(static_cast<size_t>(n), -1);
+    int numLabels = 0;
+    for (int64_t p = 0; p < n; p++) {
+        auto c = owner[pointCluster[p]];
+        if (c >= 0) {
+            if (label[c] < 0) {
+                label[c] = numLabels++;
+            }
+            labels[p] = label[c];
+        }
+    }
     return labels;
 }
 }  // namespace
 
 void khiva::clustering::kMeans(const af::array &tss, int k, af::array &centroids, af::array &labels, float tolerance,
                                int maxIterations) {
-    float error = std::numeric_limits<float>::max();
+    initialMeans(tss, k, centroids, labels);
+    lloyd(tss, centroids, labels, tolerance, maxIterations);
+}
 
-    if (centroids.isempty()) {
-        // initial guess of means, select k random time series
-        centroids = calculateInitialMeans(tss, k);
+void khiva::clustering::kMeans(const af::array &tss, int k, int restarts, af::array &centroids, af::array &labels,
+                               af::array &stats, float tolerance, int maxIterations) {
+    if (restarts < 1) {
+        throw std::invalid_argument("The number of restarts must be at least one.");
     }
 
-    if (labels.isempty()) {
-        // assigns a random centroid to every time series
-        labels = generateRandomLabels(tss.dims(1), k);
+    // the first run starts from the given centroids or labels and the rest from k-means++ seeds
+    std::vector<af::array> runCentroids(restarts);
+    std::vector<af::array> runLabels(restarts);
+    runCentroids[0] = centroids;
+    runLabels[0] = labels;
+    std::vector<double> objectives(restarts);
+    std::vector<double> iterations(restarts);
+
+    forEachRestart(restarts, [&](int r) {
+        initialMeans(tss, k, runCentroids[r], runLabels[r]);
+        iterations[r] = lloyd(tss, runCentroids[r], runLabels[r], tolerance, maxIterations);
+        if (runLabels[r].isempty()) {
+            af::array distances;
+            euclideanDistance(tss, runCentroids[r], distances, runLabels[r]);
+        }
+        objectives[r] = inertia(tss, runCentroids[r], runLabels[r]);
+    });
+
+    selectBestRun(runCentroids, runLabels, objectives, iterations, centroids, labels, stats);
+}
+
+void khiva::clustering::kMeansAccelerated(const af::array &tss, int k, af::array &centroids, af::array &labels,
+                                          float tolerance, int maxIterations) {
+    initialMeans(tss, k, centroids, labels);
+    if (maxIterations <= 0) {
+        return;
     }
 
-    af::array distances = af::constant(0, tss.dims(1), tss.type());
-    af::array newMeans;
-    int iter = 0;
+    hamerly(tss, centroids, labels, tolerance, maxIterations);
+}
 
-    // Stop updating after convergence is reached.
-    while ((error > tolerance) && (iter < maxIterations)) {
-        // 1. Compute distances to current means
-        euclideanDistance(tss, centroids, distances, labels);
+void khiva::clustering::miniBatchKMeans(const std::function<af::array()> &nextBatch, int k, af::array &centroids,
+                                        af::array &counts, float tolerance, int maxBatches) {
+    if (!centroids.isempty() && centroids.dims(1) != k) {
+        throw std::invalid_argument("The number of centroids must be k.");
+    }
+    if (!counts.isempty() && counts.elements() != k) {
+        throw std::invalid_argument("The counts must have exactly k entries.");
+    }
 
-        // 2. Compute new means
-        newMeans = computeNewMeans(tss, labels, k);
+    int batches = 0;
+    while (maxBatches < 0 || batches < maxBatches) {
+        af::array batch = nextBatch();
+        if (batch.isempty()) {
+            break;
+        }
 
-        // 3. Compute convergence
-        error = computeError(centroids, newMeans);
+        if (centroids.isempty()) {
+            // the first batch seeds the centroids with k-means++
+            af::array noLabels;
+            initialMeans(batch, k, centroids, noLabels);
+        } else if (batch.dims(0) != centroids.dims(0)) {
+            throw std::invalid_argument("The time series of the batch must have the same length as the centroids.");
+        }
+        if (counts.isempty()) {
+            counts = af::constant(0, 1, centroids.dims(1), af::dtype::s64);
+        }
 
-        // 4. Update Means
-        centroids = newMeans;
-        iter++;
+        // 1. Assign the batch to the closest centroids
+        af::array minDistances;
+        af::array labels;
+        euclideanDistance(batch, centroids, minDistances, labels);
+
+        // 2. Move every centroid towards its time series with a learning rate of one over its number of time series,
+        // which keeps it as the running mean of all the time series it has been assigned
+        af::array oneHot = oneHotLabels(labels, batch.dims(1), centroids.dims(1), batch.type());
+        af::array sums = af::matmul(batch, oneHot);
+        af::array batchCounts = af::sum(oneHot, 0);
+        counts += batchCounts.as(af::dtype::s64);
+        auto length = static_cast<unsigned int>(centroids.dims(0));
+        af::array rates = af::tile(1.0 / af::max(counts, 1).as(batch.type()), length);
+        af::array newCentroids = centroids + (sums - centroids * af::tile(batchCounts, length)) * rates;
+
+        // 3. Compute convergence, which only stops the computation if a positive tolerance is given
+        float error = computeError(centroids, newCentroids);
+
+        // 4. Update Centroids
+        centroids = newCentroids;
+        batches++;
+        if (tolerance > 0 && error <= tolerance) {
+            break;
+        }
     }
 }
 
@@ -387,26 +1691,231 @@ void khiva::clustering::kShape(const af::array &tss, int k, af::array &centroids
     }
 
     af::array normTSS = khiva::normalization::znorm(tss);
-    af::array distances = af::constant(0, nTimeseries, k, tss.type());
-    af::array newCentroids;
+    // the time series do not change, so they are transformed only once
+    af::array tssSpectra = af::fft(normTSS, khiva::fftutil::crossCorrelationLength(nElements));
+    af::array tssNorms = matrixNorm(normTSS);
 
-    float error = std::numeric_limits<float>::max();
-    int iter = 0;
+    kShapeIterations(normTSS, tssSpectra, tssNorms, centroids, labels, tolerance, maxIterations);
+}
 
-    // Stop Criteria: Stop updating after convergence or maximum number iterations is reached.
-    while ((error > tolerance) && (iter < maxIterations)) {
-        // 1. Refinement step. New centroids computation.
-        newCentroids = refinementStep(normTSS, centroids, labels);
+void khiva::clustering::kShape(const af::array &tss, int k, int restarts, af::array &centroids, af::array &labels,
+                               af::array &stats, float tolerance, int maxIterations) {
+    if (restarts < 1) {
+        throw std::invalid_argument("The number of restarts must be at least one.");
+    }
+    auto nTimeseries = static_cast<unsigned int>(tss.dims(1));
+    auto nElements = static_cast<unsigned int>(tss.dims(0));
 
-        // 2. Assignment step. New labels computation.
-        labels = assignmentStep(normTSS, newCentroids, labels);
+    af::array normTSS = khiva::normalization::znorm(tss);
+    // the time series and their spectra are shared by all the runs
+    af::array tssSpectra = af::fft(normTSS, khiva::fftutil::crossCorrelationLength(nElements));
+    af::array tssNorms = matrixNorm(normTSS);
+
+    // the first run starts from the given centroids or labels and the rest from random labels
+    std::vector<af::array> runCentroids(restarts);
+    std::vector<af::array> runLabels(restarts);
+    runCentroids[0] = centroids;
+    runLabels[0] = labels.isempty() ? generateUniformLabels(nTimeseries, k) : labels;
+    std::vector<double> objectives(restarts);
+    std::vector<double> iterations(restarts);
+
+    forEachRestart(restarts, [&](int r) {
+        if (runCentroids[r].isempty()) {
+            runCentroids[r] = af::constant(0, nElements, k, tss.type());
+        }
+        if (runLabels[r].isempty()) {
+            runLabels[r] = generateShuffledLabels(nTimeseries, k);
+        }
+        iterations[r] =
+            kShapeIterations(normTSS, tssSpectra, tssNorms, runCentroids[r], runLabels[r], tolerance, maxIterations);
+        objectives[r] = sbdObjective(tssSpectra, tssNorms, runCentroids[r], runLabels[r]);
+    });
 
-        // 3. Compute convergence
-        error = computeError(centroids, newCentroids);
+    selectBestRun(runCentroids, runLabels, objectives, iterations, centroids, labels, stats);
+}
 
-        // 4. Update Centroids
-        centroids = newCentroids;
+void khiva::clustering::kMedoids(const af::array &distances, int k, af::array &medoids, af::array &labels,
+                                 bool condensed, int maxIterations) {
+    int64_t n;
+    std::vector<double> hostDistances = toCondensed(distances, condensed, n);
+    kMedoidsInternal(CondensedDistances(std::move(hostDistances), n), n, k, medoids, labels, maxIterations);
+}
 
-        iter++;
+void khiva::clustering::kMedoids(int64_t n, const std::function<double(int64_t, int64_t)> &distance, int k,
+                                 af::array &medoids, af::array &labels, int maxIterations) {
+    if (n < 1) {
+        throw std::invalid_argument("The number of time series must be positive.");
+    }
+    kMedoidsInternal(FunctionDistances(distance), n, k, medoids, labels, maxIterations);
+}
+
+af::array khiva::clustering::agglomerative(const af::array &distances, Linkage method, bool condensed) {
+    int64_t n;
+    std::vector<double> hostDistances = toCondensed(distances, condensed, n);
+    if (n < 2) {
+        throw std::invalid_argument("At least two time series are needed.");
+    }
+
+    std::vector<Merge> merges;
+    switch (method) {
+        case KHIVA_LINKAGE_SINGLE:
+            merges = singleLinkage(CondensedDistances(std::move(hostDistances), n), n);
+            break;
+        case KHIVA_LINKAGE_COMPLETE:
+        case KHIVA_LINKAGE_AVERAGE:
+        case KHIVA_LINKAGE_WARD:
+            merges = nearestNeighbourChain(hostDistances, n, method);
+            break;
+        default:
+            throw std::invalid_argument("Unknown linkage method.");
+    }
+
+    std::vector<double> rows = linkageRows(std::move(merges), n);
+    return af::array(n - 1, 4, rows.data());
+}
+
+af::array khiva::clustering::dbscan(const af::array &tss, double epsilon, int minPoints, search::Metric metric) {
+    if (epsilon < 0) {
+        throw std::invalid_argument("The radius of the neighbourhoods must be non-negative.");
+    }
+    if (minPoints < 1) {
+        throw std::invalid_argument("The minimum number of points must be positive.");
+    }
+    auto n = static_cast<int64_t>(tss.dims(1));
+    search::VPTree tree(tss, metric);
+
+    // 1. The core points have at least minPoints time series in their neighbourhood, counting themselves
+    std::vector<char> core(static_cast<size_t>(n));
+    forEachNeighbourhood(tree, tss, epsilon, [&](int64_t i, const std::vector<search::Neighbour> &neighbours) {
+        core[i] = static_cast<int64_t>(neighbours.size()) >= minPoints;
+    });
+
+    // 2. The core points in the neighbourhood of each other form the clusters, and the rest of points join the
+    // cluster of their closest core point
+    DisjointSets clusters(n);
+    std::vector<int64_t> border(static_cast<size_t>(n), -1);
+    forEachNeighbourhood(tree, tss, epsilon, [&](int64_t i, const std::vector<search::Neighbour> &neighbours) {
+        for (const auto &neighbour : neighbours) {
+            if (!core[neighbour.first]) {
+                continue;
+            }
+            if (core[i]) {
+                clusters.unite(i, neighbour.first);
+            } else {
+                border[i] = neighbour.first;
+                break;
+            }
+        }
+    });
+
+    // 3. The clusters are numbered in the order of their first time series, and the rest of points are noise
+    std::vector<int> labels(static_cast<size_t>(n), -1);
+    std::vector<int> rootLabel(static_cast<size_t>(n), -1);
+    int numLabels = 0;
+    for (int64_t i = 0; i < n; i++) {
+        auto point = core[i] ? i : border[i];
+        if (point < 0) {
+            continue;
+        }
+        auto root = clusters.find(point);
+        if (rootLabel[root] < 0) {
+            rootLabel[root] = numLabels++;
+        }
+        labels[i] = rootLabel[root];
+    }
+
+    return af::array(1, n, labels.data());
+}
+
+af::array khiva::clustering::hdbscan(const af::array &tss, int minClusterSize, int minPoints,
+                                     search::Metric metric) {
+    if (minClusterSize < 2) {
+        throw std::invalid_argument("The minimum cluster size must be at least two.");
+    }
+    if (minPoints < 0) {
+        minPoints = minClusterSize;
+    }
+    auto n = static_cast<int64_t>(tss.dims(1));
+    auto length = static_cast<int64_t>(tss.dims(0));
+    if (minPoints < 1 || minPoints > n) {
+        throw std::invalid_argument("The minimum number of points must be between one and the number of time series.");
+    }
+    if (n < 2) {
+        return af::constant(-1, 1, n, af::dtype::s32);
+    }
+
+    // 1. The core distance of every time series is the distance to its minPoints-th nearest neighbour, itself included
+    af::array data = tss.as(af::dtype::f64);
+    search::VPTree tree(data, metric);
+    af::array knnDistances;
+    af::array knnIndexes;
+    tree.knn(data, minPoints, knnDistances, knnIndexes);
+    std::vector<double> coreDistance(static_cast<size_t>(n));
+    knnDistances.row(minPoints - 1).host(coreDistance.data());
+
+    // 2. Single linkage tree of the mutual reachability distances, computed when needed by the minimum spanning tree
+    if (metric == search::KHIVA_METRIC_ZNORM_EUCLIDEAN) {
+        data = khiva::normalization::znorm(data);
     }
+    std::vector<double> hostData(static_cast<size_t>(length * n));
+    data.host(hostData.data());
+    auto mutualReachability = [&](int64_t i, int64_t j) {
+        auto d = std::sqrt(squaredDistance(hostData.data() + i * length, hostData.data() + j * length, length));
+        return std::max(d, std::max(coreDistance[i], coreDistance[j]));
+    };
+    std::vector<double> linkage = linkageRows(singleLinkage(mutualReachability, n, length), n);
+
+    // 3. Flat clustering with the most stable clusters
+    std::vector<int> labels = excessOfMassLabels(linkage, n, minClusterSize);
+    return af::array(1, n, labels.data());
+}
+
+khiva::clustering::KMeansPredictor::KMeansPredictor(const af::array &centroids)
+    : centroids(centroids), centroidsNorms(af::sum(centroids * centroids, 0).T()) {
+    if (centroids.isempty()) {
+        throw std::invalid_argument("The centroids cannot be empty.");
+    }
+}
+
+void khiva::clustering::KMeansPredictor::predict(const af::array &tss, af::array &labels,
+                                                 af::array &distances) const {
+    if (tss.dims(0) != centroids.dims(0)) {
+        throw std::invalid_argument("The time series must have the same length as the centroids.");
+    }
+    af::array minDistances;
+    closestMeans(tss.as(centroids.type()), centroids, centroidsNorms, minDistances, labels);
+    distances = af::sqrt(minDistances);
+}
+
+khiva::clustering::KShapePredictor::KShapePredictor(const af::array &centroids)
+    : length(centroids.dims(0)),
+      centroidsSpectra(af::fft(centroids, khiva::fftutil::crossCorrelationLength(centroids.dims(0)))),
+      centroidsNorms(matrixNorm(centroids)) {
+    if (centroids.isempty()) {
+        throw std::invalid_argument("The centroids cannot be empty.");
+    }
+}
+
+void khiva::clustering::KShapePredictor::predict(const af::array &tss, af::array &labels,
+                                                 af::array &distances) const {
+    if (tss.dims(0) != length) {
+        throw std::invalid_argument("The time series must have the same length as the centroids.");
+    }
+    af::array normTSS = khiva::normalization::znorm(tss.as(khiva::fftutil::realType(centroidsSpectra.type())));
+    af::array tssSpectra = af::fft(normTSS, centroidsSpectra.dims(0));
+    af::array minDistances;
+    af::min(minDistances, labels,
+            1 - maxNcc(tssSpectra, matrixNorm(normTSS), centroidsSpectra, centroidsNorms, length), 0);
+    labels = labels.T();
+    distances = minDistances.T();
+}
+
+void khiva::clustering::kMeansPredict(const af::array &tss, const af::array &centroids, af::array &labels,
+                                      af::array &distances) {
+    KMeansPredictor(centroids).predict(tss, labels, distances);
+}
+
+void khiva::clustering::kShapePredict(const af::array &tss, const af::array &centroids, af::array &labels,
+                                      af::array &distances) {
+    KShapePredictor(centroids).predict(tss, labels, distances);
 }
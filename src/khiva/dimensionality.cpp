@@ -5,16 +5,15 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <khiva/dimensionality.h>
+#include <khiva/internal/heapUtil.h>
+#include <khiva/internal/parallelUtil.h>
 #include <khiva/internal/scopedHostPtr.h>
 
 #include <algorithm>
 #include <boost/math/distributions/normal.hpp>
 #include <cmath>
-#include <iterator>
 #include <limits>
-#include <map>
-#include <numeric>
-#include <set>
+#include <queue>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -23,57 +22,187 @@ using namespace khiva::dimensionality;
 
 namespace {
 
-struct VisvalingamSummaryPoint {
-    float x;
-    float y;
-    int64_t area;
-};
+// Number of points searched in a level of RDP above which the search is split across threads, and number of points
+// searched by every thread at once.
+constexpr int64_t RDP_PARALLEL_SIZE = 32768;
+constexpr int64_t RDP_BLOCK_SIZE = 4096;
 
-std::vector<float> computeBreakpoints(int alphabet_size, float mean_value, float std_value) {
-    std::vector<float> res;
-    boost::math::normal dist(mean_value, std_value);
+// Number of levels of RDP searched in parallel regardless of their segments. Deeper levels are only searched in
+// parallel if they hold at least that many segments, so inputs that peel one point per level, like a zigzag, do not
+// create threads for every level.
+constexpr size_t RDP_PARALLEL_LEVELS = 8;
+
+/**
+ * @brief Computes the breakpoints of the standard normal distribution that divide it in alphabet_size equiprobable
+ * regions.
+ */
+std::vector<double> standardBreakpoints(int alphabet_size) {
+    std::vector<double> res;
+    boost::math::normal dist(0.0, 1.0);
 
     for (int i = 1; i < alphabet_size; i++) {
-        float value = static_cast<float>(quantile(dist, (float)i * (1 / (float)alphabet_size)));
-        res.push_back(value);
+        res.push_back(quantile(dist, static_cast<double>(i) / alphabet_size));
     }
     return res;
 }
 
-std::vector<int> generateAlphabet(int alphabet_size) {
-    std::vector<int> res;
-    for (int i = 0; i < alphabet_size; i++) {
-        res.push_back(i);
+/**
+ * @brief Maps every value to the number of breakpoints below it with a branchless binary search on the device, which
+ * takes log2(alphabet_size) element-wise passes instead of one comparison per breakpoint.
+ *
+ * @param values The values, one time series per column.
+ * @param breakpoints The breakpoints of every time series, in increasing order along dimension zero.
+ * @return The symbols, as s32.
+ */
+af::array lookupSymbols(const af::array &values, const af::array &breakpoints) {
+    auto nBreakpoints = breakpoints.dims(0);
+    af::array symbols = af::constant(0, values.dims(), af::dtype::s32);
+    if (nBreakpoints == 0) {
+        return symbols;
+    }
+
+    // position of the first breakpoint of every column in the flattened breakpoints
+    af::array offsets =
+        af::tile(af::range(af::dim4(1, values.dims(1)), 1, af::dtype::s32) * static_cast<int>(nBreakpoints),
+                 static_cast<unsigned>(values.dims(0)));
+    af::array flatBreakpoints = af::flat(breakpoints);
+
+    dim_t step = 1;
+    while (step * 2 <= nBreakpoints) {
+        step *= 2;
     }
-    return res;
+    for (; step > 0; step /= 2) {
+        af::array candidate = symbols + static_cast<int>(step);
+        af::array positions = af::min(candidate, static_cast<int>(nBreakpoints)) - 1 + offsets;
+        af::array bounds = af::moddims(af::lookup(flatBreakpoints, af::flat(positions)), values.dims());
+        symbols = af::select((candidate <= nBreakpoints) && (values > bounds), candidate, symbols);
+    }
+    return symbols;
 }
 
-double PerpendicularDistance(const Point &pt, const Point &lineStart, const Point &lineEnd) {
-    double dx = static_cast<double>(lineEnd.first) - lineStart.first;
-    double dy = static_cast<double>(lineEnd.second) - lineStart.second;
+struct FarthestPoint {
+    double distance;
+    int64_t index;
+};
+
+/**
+ * @brief Finds the first point of [from, to) at the largest distance from the line between points[start] and
+ * points[end]. The index is zero if all of them are on the line.
+ */
+FarthestPoint farthestPoint(const std::vector<Point> &points, int64_t start, int64_t end, int64_t from, int64_t to) {
+    const auto &lineStart = points[start];
+    double dx = static_cast<double>(points[end].first) - lineStart.first;
+    double dy = static_cast<double>(points[end].second) - lineStart.second;
 
-    // Normalise
-    double mag = pow(pow(dx, 2.0) + pow(dy, 2.0), 0.5);
+    // Normalise, once for all the points
+    double mag = std::sqrt(dx * dx + dy * dy);
     if (mag > 0.0) {
         dx /= mag;
         dy /= mag;
     }
 
-    double pvx = static_cast<double>(pt.first) - lineStart.first;
-    double pvy = static_cast<double>(pt.second) - lineStart.second;
+    FarthestPoint farthest{0.0, 0};
+    for (auto i = from; i < to; i++) {
+        double pvx = static_cast<double>(points[i].first) - lineStart.first;
+        double pvy = static_cast<double>(points[i].second) - lineStart.second;
 
-    // Get dot product (project pv onto normalized direction)
-    double pvdot = dx * pvx + dy * pvy;
+        // Subtract the projection of pv onto the normalised direction from pv
+        double pvdot = dx * pvx + dy * pvy;
+        double ax = pvx - pvdot * dx;
+        double ay = pvy - pvdot * dy;
 
-    // Scale line direction vector
-    double dsx = pvdot * dx;
-    double dsy = pvdot * dy;
+        double d = std::sqrt(ax * ax + ay * ay);
+        if (d > farthest.distance) {
+            farthest = {d, i};
+        }
+    }
+    return farthest;
+}
 
-    // Subtract this from pv
-    double ax = pvx - dsx;
-    double ay = pvy - dsy;
+/**
+ * @brief Ramer-Douglas-Peucker without recursion. The segments still to be split are processed one level at a time:
+ * the farthest point of all of them is searched, in parallel blocks if the level is large, and then the points kept
+ * are flagged and the next level of segments is built. The points kept are the same as the ones of the recursive
+ * algorithm.
+ */
+std::vector<Point> simplifyRDP(const std::vector<Point> &points, double epsilon, bool parallel) {
+    auto n = static_cast<int64_t>(points.size());
+    if (n < 2) {
+        throw std::invalid_argument("Not enough points to simplify ...");
+    }
+
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = true;
+    keep.back() = true;
+
+    std::vector<std::pair<int64_t, int64_t>> segments = {{0, n - 1}};
+    std::vector<std::pair<int64_t, int64_t>> next;
+    std::vector<FarthestPoint> farthest;
+    // Blocks of the parallel search with the segment they belong to, and the farthest point found in each of them
+    std::vector<std::pair<int64_t, int64_t>> blocks;
+    std::vector<size_t> owners;
+    std::vector<FarthestPoint> found;
+
+    for (size_t level = 0; !segments.empty(); level++) {
+        int64_t searched = 0;
+        for (const auto &segment : segments) {
+            searched += segment.second - segment.first - 1;
+        }
+
+        farthest.assign(segments.size(), {0.0, 0});
+        if (parallel && searched >= RDP_PARALLEL_SIZE &&
+            (level < RDP_PARALLEL_LEVELS || segments.size() >= RDP_PARALLEL_LEVELS)) {
+            blocks.clear();
+            owners.clear();
+            for (size_t s = 0; s < segments.size(); s++) {
+                for (auto from = segments[s].first + 1; from < segments[s].second; from += RDP_BLOCK_SIZE) {
+                    blocks.emplace_back(from, std::min(from + RDP_BLOCK_SIZE, segments[s].second));
+                    owners.emplace_back(s);
+                }
+            }
+            found.resize(blocks.size());
+            khiva::parallelutil::parallelFor(0, static_cast<int64_t>(blocks.size()), [&](int64_t b) {
+                const auto &segment = segments[owners[b]];
+                found[b] = farthestPoint(points, segment.first, segment.second, blocks[b].first, blocks[b].second);
+            });
+            // The blocks are in order, so the first farthest point wins as in the sequential search
+            for (size_t b = 0; b < blocks.size(); b++) {
+                if (found[b].distance > farthest[owners[b]].distance) {
+                    farthest[owners[b]] = found[b];
+                }
+            }
+        } else {
+            for (size_t s = 0; s < segments.size(); s++) {
+                farthest[s] = farthestPoint(points, segments[s].first, segments[s].second, segments[s].first + 1,
+                                            segments[s].second);
+            }
+        }
+
+        // If max distance is greater than epsilon, the point is kept and both sides are simplified
+        next.clear();
+        for (size_t s = 0; s < segments.size(); s++) {
+            auto index = farthest[s].index;
+            if (index == 0 || farthest[s].distance <= epsilon) {
+                continue;
+            }
+            keep[index] = true;
+            if (index - segments[s].first > 1) {
+                next.emplace_back(segments[s].first, index);
+            }
+            if (segments[s].second - index > 1) {
+                next.emplace_back(index, segments[s].second);
+            }
+        }
+        segments.swap(next);
+    }
 
-    return pow(pow(ax, 2.0) + pow(ay, 2.0), 0.5);
+    std::vector<Point> out;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (keep[i]) {
+            out.emplace_back(points[i]);
+        }
+    }
+    return out;
 }
 
 /**
@@ -89,145 +218,525 @@ float verticalDistance(const Point &p, const Point &start, const Point &end) {
 }
 
 /**
- * @brief This function just inserts a point in the given position of a vector.
+ * @brief The point of a segment between two selected points with the maximum vertical distance to it.
  */
-void insertPointBetweenSelected(const Point &p, int position, std::vector<Point> &selected) {
-    auto it = selected.begin();
-    selected.insert(it + position, p);
-}
+struct PIPCandidate {
+    float distance;
+    int64_t index;
+    int64_t start;
+    int64_t end;
+};
 
 /**
- * @brief This function just checks if the given point is already in the vector.
+ * @brief Orders the candidates by decreasing distance and, on ties, by increasing position, which is the point the
+ * linear scan over the whole time series would pick.
  */
-bool isPointInDesiredList(const Point &point, const std::vector<Point> &selected) {
-    auto it =
-        std::find_if(selected.cbegin(), selected.cend(), [&point](const Point &p) { return p.first == point.first; });
-    return it != selected.end();
-}
+struct PIPCandidateComparator {
+    bool operator()(const PIPCandidate &a, const PIPCandidate &b) const {
+        return (a.distance < b.distance) || ((a.distance == b.distance) && (a.index > b.index));
+    }
+};
+
+using PIPCandidates = std::priority_queue<PIPCandidate, std::vector<PIPCandidate>, PIPCandidateComparator>;
 
 /**
- * @brief This function calculates the segment indices that we need to compare the point.
+ * @brief Scans the points strictly between start and end and pushes the farthest one as a candidate, if any.
  */
-std::pair<int, int> getSegmentFromSelected(const Point &point, const std::vector<Point> &selected) {
-    int lower = 0, upper = 0;
-    // We do not check the first element, as it is fixed and set to the first element of the time series
-    size_t i = 0;
-    bool rebased = false;
-    while (!rebased && (i < selected.size() - 1)) {
-        // We check points until point.first > selected[i]
-        if (point.first > selected[i].first) {
-            lower = static_cast<int>(i);
-            upper = static_cast<int>(i + 1);
-        } else {
-            rebased = true;
+void pushPIPCandidate(const std::vector<Point> &points, int64_t start, int64_t end, PIPCandidates &candidates) {
+    float dmax = -1.0f;
+    int64_t index = -1;
+    for (int64_t i = start + 1; i < end; i++) {
+        float d = verticalDistance(points[i], points[start], points[end]);
+        if (d > dmax) {
+            index = i;
+            dmax = d;
         }
-        i++;
     }
-    return std::make_pair(lower, upper);
+    if (index >= 0) {
+        candidates.push(PIPCandidate{dmax, index, start, end});
+    }
 }
 
-template <typename T>
-af::array PAA_CPU(const af::array &a, int bins) {
-    af::array result;
-    auto n = a.dims(0);
+/**
+ * @brief Selects the Perceptually Important Points of a time series. Every segment between two consecutive selected
+ * points keeps its farthest point in a max-heap, so each selection pops the heap and only rescans the segment that
+ * has been split, instead of the whole time series.
+ *
+ * @return The positions of the selected points in increasing order.
+ */
+std::vector<int64_t> PIPIndices(const std::vector<Point> &points, int numberIPs) {
+    auto end = static_cast<int64_t>(points.size()) - 1;
+    std::vector<int64_t> selected = {0, end};
+    selected.reserve(std::max(numberIPs, 2));
 
-    auto reducedColumn = std::vector<T>(bins);
+    PIPCandidates candidates;
+    pushPIPCandidate(points, 0, end, candidates);
 
-    // Find out the number of elements per bin
-    T elemPerBin = static_cast<T>(n) / static_cast<T>(bins);
+    // we have to find (numberIPs - 2) points, as we have already included P[0] and P[end].
+    for (int p = 0; (p < numberIPs - 2) && !candidates.empty(); p++) {
+        auto best = candidates.top();
+        candidates.pop();
+        selected.push_back(best.index);
+        pushPIPCandidate(points, best.start, best.index, candidates);
+        pushPIPCandidate(points, best.index, best.end, candidates);
+    }
 
-    // For each column
-    for (int i = 0; i < a.dims(1); i++) {
-        auto column = khiva::utils::makeScopedHostPtr(a.col(i).host<T>());
-        T start = 0.0;
-        T end = elemPerBin - 1;
+    std::sort(selected.begin(), selected.end());
+    return selected;
+}
 
-        // For each column
-        for (int j = 0; j < bins; j++) {
-            T avg = 0.0;
-            int count = 0;
+/**
+ * @brief Applies reduce to every time series of an array of n x 2 x nSeries points in parallel, and joins the
+ * reduced time series along dimension two. The shorter ones are padded with NaN.
+ */
+template <typename Reduce>
+af::array reduceEach(const af::array &ts, Reduce reduce) {
+    auto n = ts.dims(0);
+    auto nSeries = ts.dims(2);
 
-            // Compute avg for this segment
-            for (int k = start; k <= end; k++) {
-                avg = avg + column[k];
-                count++;
-            }
-            avg = avg / count;
-            reducedColumn[j] = avg;
+    // Extracting info from af::array, all the time series at once
+    auto h_ts = khiva::utils::makeScopedHostPtr(ts.as(af::dtype::f32).host<float>());
+    std::vector<std::vector<Point>> reduced(static_cast<size_t>(nSeries));
 
-            // Compute next segment
-            start = std::ceil(end);
-            end = end + elemPerBin;
-            end = (end > n) ? n : end;
+    khiva::parallelutil::parallelFor(0, nSeries, [&](int64_t s) {
+        const float *x = h_ts.get() + s * 2 * n;
+        const float *y = x + n;
+
+        // Converting c-arrays to vector of points
+        std::vector<Point> points;
+        points.reserve(n);
+        for (dim_t i = 0; i < n; i++) {
+            points.emplace_back(x[i], y[i]);
         }
+        reduced[s] = reduce(points);
+    });
 
-        // First Column
-        af::array col(bins, 1, reducedColumn.data());
-        if (i == 0) {
-            result = col;
-        } else {
-            result = af::join(1, result, col);
+    size_t length = 0;
+    for (const auto &points : reduced) {
+        length = std::max(length, points.size());
+    }
+
+    // Converting from vectors to array
+    std::vector<float> out(length * 2 * nSeries, std::numeric_limits<float>::quiet_NaN());
+    for (size_t s = 0; s < reduced.size(); s++) {
+        float *ox = out.data() + s * 2 * length;
+        float *oy = ox + length;
+        for (size_t i = 0; i < reduced[s].size(); i++) {
+            ox[i] = reduced[s][i].first;
+            oy[i] = reduced[s][i].second;
         }
     }
-    return result;
+
+    return af::array(length, 2, nSeries, out.data());
 }
 
-float calculateError(const std::vector<Point> &ts, int start, int end) {
-    Point p1 = ts[start];
-    Point p2 = ts[end];
+/**
+ * @brief Computes the squared error of a set of points against the line y = a + mx, from the number of points and the
+ * sums of their x, y, x^2, xy and y^2.
+ */
+double lineError(double count, double x, double y, double xx, double xy, double yy, double a, double m) {
+    double error = yy - 2 * a * y - 2 * m * xy + count * a * a + 2 * a * m * x + m * m * xx;
+    // cancellation can give tiny negative values
+    return std::max(error, 0.0);
+}
 
-    // We use the point-slope equation for the middle points between start and end: y = mx - mx_1 + y_1
-    // where m = (y_2 - y_1) / (x_2 - x_1)
-    float m = (p2.second - p1.second) / (p2.first - p1.first);
+/**
+ * @brief Gives the squared error of the points between start and end against the line that connects them in O(1),
+ * from the prefix sums of x, y, x^2, xy and y^2. The points are shifted to the first one of the time series to reduce
+ * the cancellation of the sums.
+ */
+class SegmentErrors {
+   public:
+    explicit SegmentErrors(const std::vector<Point> &ts)
+        : ts(ts),
+          sx(ts.size() + 1, 0.0),
+          sy(ts.size() + 1, 0.0),
+          sxx(ts.size() + 1, 0.0),
+          sxy(ts.size() + 1, 0.0),
+          syy(ts.size() + 1, 0.0) {
+        for (size_t i = 0; i < ts.size(); i++) {
+            double x = static_cast<double>(ts[i].first) - ts[0].first;
+            double y = static_cast<double>(ts[i].second) - ts[0].second;
+            sx[i + 1] = sx[i] + x;
+            sy[i + 1] = sy[i] + y;
+            sxx[i + 1] = sxx[i] + x * x;
+            sxy[i + 1] = sxy[i] + x * y;
+            syy[i + 1] = syy[i] + y * y;
+        }
+    }
 
-    return std::accumulate(ts.cbegin() + start, ts.cbegin() + end + 1, 0.0f, [&p1, m](float acc, Point p) {
-        return acc + std::pow(p.second - (m * (p.first - p1.first) + p1.second), 2);
-    });
-}
+    float operator()(int64_t start, int64_t end) const {
+        Point p1 = ts[start];
+        Point p2 = ts[end];
+        double m = (p2.second - p1.second) / (p2.first - p1.first);
+
+        // Every point is compared with y = a + mx in the shifted coordinates
+        double a = (static_cast<double>(p1.second) - ts[0].second) - m * (static_cast<double>(p1.first) - ts[0].first);
+        return static_cast<float>(lineError(static_cast<double>(end - start + 1), sx[end + 1] - sx[start],
+                                            sy[end + 1] - sy[start], sxx[end + 1] - sxx[start],
+                                            sxy[end + 1] - sxy[start], syy[end + 1] - syy[start], a, m));
+    }
+
+   private:
+    const std::vector<Point> &ts;
+    std::vector<double> sx;
+    std::vector<double> sy;
+    std::vector<double> sxx;
+    std::vector<double> sxy;
+    std::vector<double> syy;
+};
 
 Segment merge(Segment s1, Segment s2) { return {s1.first, s2.second}; }
 
-int64_t computeTriangleArea(const VisvalingamSummaryPoint &a, const VisvalingamSummaryPoint &b,
-                            const VisvalingamSummaryPoint &c, const long scale = 1e9) {
-    float f1 = a.x * (b.y - c.y);
-    float f2 = b.x * (c.y - a.y);
-    float f3 = c.x * (a.y - b.y);
+int64_t computeTriangleArea(const Point &a, const Point &b, const Point &c, const int64_t scale) {
+    float f1 = a.first * (b.second - c.second);
+    float f2 = b.first * (c.second - a.second);
+    float f3 = c.first * (a.second - b.second);
     return static_cast<int64_t>(std::abs((static_cast<double>(f1) + f2 + f3) / 2.0f) * scale);
 }
 
-template <typename Iter, typename Distance>
-Iter shiftIterator(Iter iter, Distance positions) {
-    std::advance(iter, positions);
-    return iter;
+void checkDWT(const af::array &tss, Wavelet wavelet, int levels) {
+    if (wavelet != KHIVA_WAVELET_HAAR && wavelet != KHIVA_WAVELET_DAUBECHIES4) {
+        throw std::invalid_argument("Unknown wavelet.");
+    }
+    if (levels < 1 || levels > 30) {
+        throw std::invalid_argument("The number of levels must be between 1 and 30.");
+    }
+    auto n = tss.dims(0);
+    if (n == 0 || n % (int64_t{1} << levels) != 0) {
+        throw std::invalid_argument("The length of the time series must be a multiple of 2^levels.");
+    }
 }
 
-class mapComparator {
-   public:
-    bool operator()(const std::pair<int64_t, int64_t> &p1, const std::pair<int64_t, int64_t> &p2) const {
-        return ((p1.first < p2.first) || ((p1.first == p2.first) && (p1.second < p2.second)));
+/**
+ * @brief One level of the lifting scheme on the rows of x, which are an even number. The approximation coefficients
+ * are returned in the first half of the rows and the details in the second half.
+ */
+af::array liftForward(const af::array &x, Wavelet wavelet) {
+    const double sqrt2 = std::sqrt(2.0);
+    const double sqrt3 = std::sqrt(3.0);
+    auto m = x.dims(0);
+    af::array even = x(af::seq(0, static_cast<double>(m - 2), 2), af::span);
+    af::array odd = x(af::seq(1, static_cast<double>(m - 1), 2), af::span);
+
+    af::array s;
+    af::array d;
+    if (wavelet == KHIVA_WAVELET_HAAR) {
+        // Predict the odd elements with the even ones, and update the even ones to keep the mean
+        d = odd - even;
+        s = even + d / 2;
+        s *= sqrt2;
+        d /= sqrt2;
+    } else {
+        // The neighbours of the first and the last rows are the last and the first ones
+        af::array s1 = even + sqrt3 * odd;
+        af::array d1 = odd - sqrt3 / 4 * s1 - (sqrt3 - 2) / 4 * af::shift(s1, 1);
+        af::array s2 = s1 - af::shift(d1, -1);
+        s = (sqrt3 - 1) / sqrt2 * s2;
+        d = (sqrt3 + 1) / sqrt2 * d1;
     }
-};
-
-void recomputeAreaNeighbor(std::map<int64_t, VisvalingamSummaryPoint>::iterator &iterator_point,
-                           std::set<std::pair<int64_t, int64_t>, mapComparator> &point_indexer,
-                           std::map<int64_t, VisvalingamSummaryPoint> &points, const int64_t scale) {
-    auto im1m1 = shiftIterator(iterator_point, -1);
-    auto im1p1 = shiftIterator(iterator_point, 1);
-    auto original_position_minus1 = iterator_point->first;
+    return af::join(0, s, d);
+}
 
-    auto old_area_minus1 = iterator_point->second.area;
-    auto new_area_minus1 = computeTriangleArea(im1m1->second, iterator_point->second, im1p1->second, scale);
-    points[iterator_point->first] =
-        VisvalingamSummaryPoint{iterator_point->second.x, iterator_point->second.y, new_area_minus1};
+/**
+ * @brief Undoes liftForward.
+ */
+af::array liftInverse(const af::array &c, Wavelet wavelet) {
+    const double sqrt2 = std::sqrt(2.0);
+    const double sqrt3 = std::sqrt(3.0);
+    auto m = c.dims(0);
+    af::array s = c.rows(0, m / 2 - 1);
+    af::array d = c.rows(m / 2, m - 1);
+
+    af::array even;
+    af::array odd;
+    if (wavelet == KHIVA_WAVELET_HAAR) {
+        d *= sqrt2;
+        s /= sqrt2;
+        even = s - d / 2;
+        odd = d + even;
+    } else {
+        af::array d1 = (sqrt3 - 1) / sqrt2 * d;
+        af::array s1 = (sqrt3 + 1) / sqrt2 * s + af::shift(d1, -1);
+        odd = d1 + sqrt3 / 4 * s1 + (sqrt3 - 2) / 4 * af::shift(s1, 1);
+        even = s1 - sqrt3 * odd;
+    }
 
-    auto it = point_indexer.find(std::make_pair(old_area_minus1, original_position_minus1));
-    point_indexer.erase(it);
+    af::array x = af::constant(0, c.dims(0), c.dims(1), c.type());
+    x(af::seq(0, static_cast<double>(m - 2), 2), af::span) = even;
+    x(af::seq(1, static_cast<double>(m - 1), 2), af::span) = odd;
+    return x;
+}
 
-    point_indexer.insert(std::pair<int64_t, int64_t>(std::make_pair(new_area_minus1, original_position_minus1)));
+/**
+ * @brief The positions of the coefficients of the non-redundant half of the spectra, of half rows, in the flattened
+ * array of all of them.
+ */
+af::array spectraPositions(const af::array &indexes, dim_t half) {
+    auto k = static_cast<unsigned int>(indexes.dims(0));
+    af::array offsets = af::range(af::dim4(1, indexes.dims(1)), 1, af::dtype::u32) * static_cast<unsigned int>(half);
+    return af::flat(indexes.as(af::dtype::u32) + af::tile(offsets, k));
 }
 
 }  // namespace
 
+void khiva::dimensionality::DFTTopK(const af::array &tss, int k, af::array &coefficients, af::array &indexes) {
+    auto n = tss.dims(0);
+    auto half = n / 2 + 1;
+    if (n == 0 || k < 1 || k > half) {
+        throw std::invalid_argument("The number of coefficients must be between 1 and n / 2 + 1.");
+    }
+    auto type = (tss.type() == af::dtype::f64) ? af::dtype::f64 : af::dtype::f32;
+    af::array spectra = af::fft(tss.as(type))(af::seq(0, static_cast<double>(half - 1)), af::span);
+
+    // The energy of every coefficient in the whole spectrum, where all but the mean and the Nyquist frequency appear
+    // twice
+    af::array weights = af::constant(2, half, type);
+    weights(0) = 1;
+    if (n % 2 == 0) {
+        weights(half - 1) = 1;
+    }
+    af::array magnitudes = af::abs(spectra);
+    af::array energy = magnitudes * magnitudes * af::tile(weights, 1, static_cast<unsigned int>(tss.dims(1)));
+
+    af::array sorted;
+    af::array order;
+    af::sort(sorted, order, energy, 0, false);
+    indexes = order.rows(0, k - 1);
+    coefficients = af::moddims(af::flat(spectra)(spectraPositions(indexes, half)), k, tss.dims(1));
+}
+
+af::array khiva::dimensionality::inverseDFTTopK(const af::array &coefficients, const af::array &indexes, int n) {
+    if (coefficients.dims() != indexes.dims()) {
+        throw std::invalid_argument("The coefficients and the indexes must have the same dimensions.");
+    }
+    dim_t half = n / 2 + 1;
+    if (n < 1 || coefficients.dims(0) > half) {
+        throw std::invalid_argument("There are more coefficients than the non-redundant half of the spectrum.");
+    }
+    auto type = (coefficients.type() == af::dtype::c64 || coefficients.type() == af::dtype::f64) ? af::dtype::c64
+                                                                                                  : af::dtype::c32;
+    af::array spectra = af::constant(0, half, coefficients.dims(1), type);
+    spectra(spectraPositions(indexes, half)) = af::flat(coefficients.as(type));
+
+    // The rest of the spectrum are the conjugates of the coefficients
+    af::array full = af::constant(0, n, coefficients.dims(1), type);
+    full(af::seq(0, static_cast<double>(half - 1)), af::span) = spectra;
+    auto mirrored = (n - 1) / 2;
+    if (mirrored > 0) {
+        full(af::seq(n - mirrored, n - 1), af::span) =
+            af::flip(af::conjg(spectra(af::seq(1, mirrored), af::span)), 0);
+    }
+    return af::real(af::ifft(full));
+}
+
+af::array khiva::dimensionality::DWT(const af::array &tss, Wavelet wavelet, int levels) {
+    checkDWT(tss, wavelet, levels);
+    auto type = (tss.type() == af::dtype::f64) ? af::dtype::f64 : af::dtype::f32;
+    af::array coefficients = tss.as(type);
+
+    // Every level transforms the approximation of the previous one
+    auto n = tss.dims(0);
+    for (int l = 0; l < levels; l++) {
+        auto m = static_cast<double>(n >> l);
+        coefficients(af::seq(0, m - 1), af::span) = liftForward(coefficients(af::seq(0, m - 1), af::span), wavelet);
+    }
+    return coefficients;
+}
+
+af::array khiva::dimensionality::inverseDWT(const af::array &coefficients, Wavelet wavelet, int levels) {
+    checkDWT(coefficients, wavelet, levels);
+    auto type = (coefficients.type() == af::dtype::f64) ? af::dtype::f64 : af::dtype::f32;
+    af::array tss = coefficients.as(type);
+
+    auto n = coefficients.dims(0);
+    for (int l = levels - 1; l >= 0; l--) {
+        auto m = static_cast<double>(n >> l);
+        tss(af::seq(0, m - 1), af::span) = liftInverse(tss(af::seq(0, m - 1), af::span), wavelet);
+    }
+    return tss;
+}
+
+std::vector<Point> khiva::dimensionality::LTTB(const std::vector<Point> &ts, int64_t numPoints) {
+    std::vector<Point> result;
+    result.reserve(std::min(static_cast<int64_t>(ts.size()), numPoints));
+    LTTBDownsampler downsampler(static_cast<int64_t>(ts.size()), numPoints,
+                                [&result](const Point &point) { result.emplace_back(point); });
+    downsampler.add(ts);
+
+    return result;
+}
+
+af::array khiva::dimensionality::LTTB(const af::array &ts, int numPoints) {
+    if (ts.dims(1) != 2) {
+        throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
+    }
+    return reduceEach(ts, [numPoints](const std::vector<Point> &points) { return LTTB(points, numPoints); });
+}
+
+khiva::dimensionality::LTTBDownsampler::LTTBDownsampler(int64_t length, int64_t numPoints, PointCallback callback)
+    : length(length), numPoints(numPoints), callback(std::move(callback)) {
+    if (numPoints < 3) {
+        throw std::invalid_argument("At least 3 points must be selected.");
+    }
+}
+
+void khiva::dimensionality::LTTBDownsampler::add(const Point &point) {
+    index++;
+
+    // Nothing to be reduced, or the first point, which is always kept
+    if (numPoints >= length || index == 1) {
+        callback(point);
+        previous = point;
+        bucket = 0;
+        bucketEnd = bucketStart(1);
+        if (index == length) {
+            index = 0;
+        }
+        return;
+    }
+
+    filling.emplace_back(point);
+    sumX += point.first;
+    sumY += point.second;
+    if (index < bucketEnd) {
+        return;
+    }
+
+    // The bucket is complete, so the point of the previous one can be selected
+    auto n = static_cast<double>(filling.size());
+    if (bucket > 0) {
+        select(sumX / n, sumY / n);
+    }
+    candidates.swap(filling);
+    filling.clear();
+    sumX = 0.0;
+    sumY = 0.0;
+    bucket++;
+    bucketEnd = bucketStart(bucket + 1);
+
+    // The last point is a bucket on its own
+    if (index == length) {
+        callback(candidates.front());
+        candidates.clear();
+        index = 0;
+    }
+}
+
+void khiva::dimensionality::LTTBDownsampler::add(const std::vector<Point> &points) {
+    for (const auto &point : points) {
+        add(point);
+    }
+}
+
+int64_t khiva::dimensionality::LTTBDownsampler::bucketStart(int64_t bucket) const {
+    // The points between the first and the last one are split into numPoints - 2 buckets, the last point is the
+    // bucket numPoints - 2
+    if (bucket == numPoints - 1) {
+        return length;
+    }
+    return bucket * (length - 2) / (numPoints - 2) + 1;
+}
+
+void khiva::dimensionality::LTTBDownsampler::select(double averageX, double averageY) {
+    double maxArea = -1.0;
+    Point selected;
+    for (const auto &point : candidates) {
+        // Twice the area of the triangle, which gives the same order
+        double area = std::abs((previous.first - averageX) * (point.second - previous.second) -
+                               (previous.first - point.first) * (averageY - previous.second));
+        if (area > maxArea) {
+            maxArea = area;
+            selected = point;
+        }
+    }
+    callback(selected);
+    previous = selected;
+}
+
+std::vector<Point> khiva::dimensionality::M4(const std::vector<Point> &ts, int64_t buckets) {
+    std::vector<Point> result;
+    if (ts.empty()) {
+        return result;
+    }
+    M4Downsampler downsampler(ts.front().first, ts.back().first, buckets,
+                              [&result](const Point &point) { result.emplace_back(point); });
+    downsampler.add(ts);
+    downsampler.flush();
+
+    return result;
+}
+
+af::array khiva::dimensionality::M4(const af::array &ts, int buckets) {
+    if (ts.dims(1) != 2) {
+        throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
+    }
+    return reduceEach(ts, [buckets](const std::vector<Point> &points) { return M4(points, buckets); });
+}
+
+khiva::dimensionality::M4Downsampler::M4Downsampler(double start, double end, int64_t buckets,
+                                                    PointCallback callback)
+    : start(start), end(end), buckets(buckets), callback(std::move(callback)) {
+    if (buckets < 1) {
+        throw std::invalid_argument("At least one bucket is required.");
+    }
+}
+
+void khiva::dimensionality::M4Downsampler::add(const Point &point) {
+    auto pointBucket = bucketOf(point.first);
+    if (count > 0 && pointBucket != bucket) {
+        emit();
+    }
+
+    auto position = index++;
+    if (count == 0) {
+        bucket = pointBucket;
+        first = minimum = maximum = {position, point};
+    } else if (point.second < minimum.second.second) {
+        minimum = {position, point};
+    } else if (point.second > maximum.second.second) {
+        maximum = {position, point};
+    }
+    last = {position, point};
+    count++;
+}
+
+void khiva::dimensionality::M4Downsampler::add(const std::vector<Point> &points) {
+    for (const auto &point : points) {
+        add(point);
+    }
+}
+
+void khiva::dimensionality::M4Downsampler::flush() {
+    emit();
+    index = 0;
+}
+
+void khiva::dimensionality::M4Downsampler::emit() {
+    if (count == 0) {
+        return;
+    }
+    // The four points in their original order, without repeating the ones playing several roles
+    std::pair<int64_t, Point> selected[] = {first, minimum, maximum, last};
+    std::sort(selected, selected + 4, [](const std::pair<int64_t, Point> &a, const std::pair<int64_t, Point> &b) {
+        return a.first < b.first;
+    });
+    for (size_t i = 0; i < 4; i++) {
+        if (i == 0 || selected[i].first != selected[i - 1].first) {
+            callback(selected[i].second);
+        }
+    }
+    count = 0;
+}
+
+int64_t khiva::dimensionality::M4Downsampler::bucketOf(float x) const {
+    if (end <= start) {
+        return 0;
+    }
+    auto b = static_cast<int64_t>(std::floor((x - start) / (end - start) * buckets));
+    return std::min(std::max(b, int64_t{0}), buckets - 1);
+}
+
 std::vector<Point> khiva::dimensionality::PAA(const std::vector<Point> &points, int bins) {
     float xrange = points.back().first - points.front().first;    
     float width_bin = xrange / bins;
@@ -253,27 +762,47 @@ std::vector<Point> khiva::dimensionality::PAA(const std::vector<Point> &points,
 }
 
 af::array khiva::dimensionality::PAA(const af::array &a, int bins) {
-    // Resulting array
-    af::array result;
+    if (bins < 1) {
+        throw std::invalid_argument("The number of bins must be at least one.");
+    }
+    // Integer types are averaged in single precision
+    auto type = (a.type() == af::dtype::f64) ? af::dtype::f64 : af::dtype::f32;
+    af::array values = a.as(type);
+    auto n = a.dims(0);
+    auto columns = static_cast<unsigned int>(a.dims(1));
 
-    // Check dimensions are divisible, if not, call CPU version
-    if (a.dims(0) % bins == 0) {
-        auto n = a.dims(0);
+    if (n % bins == 0) {
         auto elem_row = n / bins;
 
-        af::array b = af::moddims(a, elem_row, bins, a.dims(1));
+        af::array b = af::moddims(values, elem_row, bins, a.dims(1));
         af::array addition = af::sum(b, 0);
-        result = af::reorder(addition / elem_row, 1, 2, 0, 3);
-    } else {
-        // Call the CPU version
-        if (a.type() == af::dtype::f64) {
-            result = PAA_CPU<double>(a, bins);
-        } else if (a.type() == af::dtype::f32) {
-            result = PAA_CPU<float>(a, bins);
-        }
+        return af::reorder(addition / elem_row, 1, 2, 0, 3);
     }
 
-    return result;
+    // Bin j covers the fractional positions [j * n / bins, (j + 1) * n / bins) of the time series, so its sum is the
+    // difference of the prefix sums at both ends, each one adding the covered fraction of the element it falls in.
+    // The values are shifted to the first one to keep the precision of the prefix sums.
+    af::array offset = values.row(0);
+    af::array shifted = values - af::tile(offset, static_cast<unsigned int>(n));
+    af::array prefix = af::join(0, af::constant(0, 1, a.dims(1), type), af::accum(shifted, 0));
+
+    // The whole part and the numerator of the fractional part of the ends of the bins, exact as they are integers
+    std::vector<int> whole(bins + 1);
+    std::vector<int> remainder(bins + 1);
+    for (int j = 0; j <= bins; j++) {
+        auto position = static_cast<int64_t>(j) * n;
+        whole[j] = static_cast<int>(position / bins);
+        remainder[j] = static_cast<int>(position % bins);
+    }
+    af::array wholeIdx(bins + 1, whole.data());
+    af::array covered = af::tile(af::array(bins + 1, remainder.data()).as(type) / bins, 1, columns);
+
+    // The last end falls exactly on n, where the fraction is zero, so any element can be taken there
+    af::array elementIdx = af::min(wholeIdx, static_cast<int>(n - 1));
+    af::array ends = prefix(wholeIdx, af::span) + covered * shifted(elementIdx, af::span);
+    af::array sums = ends.rows(1, bins) - ends.rows(0, bins - 1);
+
+    return sums * (static_cast<double>(bins) / n) + af::tile(offset, static_cast<unsigned int>(bins));
 }
 
 af::array khiva::dimensionality::PIP(const af::array &ts, int numberIPs) {
@@ -281,7 +810,6 @@ af::array khiva::dimensionality::PIP(const af::array &ts, int numberIPs) {
         throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
     }
     auto n = ts.dims(0);
-    auto end = n - 1;
 
     if (n < 2) {
         throw std::invalid_argument("We can't delete all those important points");
@@ -289,106 +817,78 @@ af::array khiva::dimensionality::PIP(const af::array &ts, int numberIPs) {
         return ts;
     }
 
-    // Extracting info from af::array
-    auto h_x = khiva::utils::makeScopedHostPtr(ts.col(0).host<float>());
-    auto h_y = khiva::utils::makeScopedHostPtr(ts.col(1).host<float>());
-
-    // Converting c-arrays to vector of points
-    std::vector<Point> points;
-    for (int i = 0; i < n; i++) {
-        points.emplace_back(h_x[i], h_y[i]);
-    }
-
-    // Allocating vectors for selected points
-    std::vector<Point> selected;
-    selected.emplace_back(points[0]);
-    selected.emplace_back(points[end]);
-
-    // we have to find (numberIPs - 2) points, as we have already included P[0] and P[end].
-    // Number of passes over the collection
-    for (int p = 0; p < (numberIPs - 2); p++) {
-        float dmax = -1.0;
-        int index = -1;
-        int position = -1;
-
-        // Find the next PIP
-        for (int i = 1; i < end; i++) {
-            // We first check if the point is already in the list.
-            if (!isPointInDesiredList(points[i], selected)) {
-                // segment contains the indices of the selected points which are the boundaries for the point i.
-                std::pair<int, int> segment = getSegmentFromSelected(points[i], selected);
-                float d = verticalDistance(points[i], selected[segment.first], selected[segment.second]);
-                // We store the point with the maximum distance to the line that connects the segment.
-                if (d > dmax) {
-                    index = i;
-                    dmax = d;
-                    position = segment.second;
-                }
-            }
+    return reduceEach(ts, [numberIPs](const std::vector<Point> &points) {
+        auto selected = PIPIndices(points, numberIPs);
+        std::vector<Point> result;
+        result.reserve(selected.size());
+        for (auto i : selected) {
+            result.emplace_back(points[i]);
         }
-        insertPointBetweenSelected(points[index], position, selected);
-    }
-
-    // Converting from vector to array
-    std::vector<float> x;
-    x.reserve(selected.size());
-    std::vector<float> y;
-    y.reserve(selected.size());
-    for (auto &i : selected) {
-        x.emplace_back(i.first);
-        y.emplace_back(i.second);
-    }
-
-    // from c-array to af::array
-    af::array tsx(selected.size(), 1, x.data());
-    af::array tsy(selected.size(), 1, y.data());
-    af::array res = af::join(1, tsx, tsy);
-
-    return res;
+        return result;
+    });
 }
 
 std::vector<Point> khiva::dimensionality::PLABottomUp(const std::vector<Point> &ts, float maxError) {
+    if (ts.size() < 2) {
+        throw std::invalid_argument("PLABottomUp needs at least two points.");
+    }
     std::vector<Segment> segments;
-    segments.reserve(ts.size());
+    segments.reserve(ts.size() / 2);
 
-    // Allocating vector of segments
+    // Allocating vector of segments, the last one also takes the last point if there is an odd number of them
     for (size_t i = 0; i < ts.size() - 1; i = i + 2) {
         segments.emplace_back(i, i + 1);
     }
-
-    std::vector<float> mergeCost;
-    mergeCost.reserve(segments.size());
-    for (size_t i = 0; i < segments.size() - 1; i++) {
-        mergeCost.emplace_back(calculateError(ts, segments[i].first, segments[i + 1].second));
+    segments.back().second = static_cast<int>(ts.size() - 1);
+
+    // The segments are kept as a linked list, and the cost of merging a segment with the next one in a heap
+    auto nSegments = static_cast<int64_t>(segments.size());
+    std::vector<int64_t> previous(nSegments);
+    std::vector<int64_t> next(nSegments);
+    SegmentErrors errors(ts);
+    khiva::heaputil::IndexedMinHeap<std::pair<float, int64_t>> mergeCost(nSegments);
+    for (int64_t i = 0; i < nSegments; i++) {
+        previous[i] = i - 1;
+        next[i] = (i + 1 < nSegments) ? i + 1 : -1;
+        if (next[i] >= 0) {
+            mergeCost.push(i, std::make_pair(errors(segments[i].first, segments[i + 1].second), i));
+        }
     }
 
-    // Calculate minimum, calculating in advance
-    auto minCost = std::min_element(std::begin(mergeCost), std::end(mergeCost));
-    while ((segments.size() > 2) && (*minCost < maxError)) {
-        // We have to merge
-        auto index = std::distance(std::begin(mergeCost), minCost);
-
-        // Merge candidate segments
-        segments[index] = merge(segments[index], segments[index + 1]);
-
-        // Delete fused segment
-        segments.erase(segments.begin() + index + 1);
-        mergeCost.erase(mergeCost.begin() + index + 1);
-
-        // Calculate new cost
-        mergeCost[index] = calculateError(ts, segments[index].first, segments[index + 1].second);
-        mergeCost[index - 1] = calculateError(ts, segments[index - 1].first, segments[index].second);
+    // On ties, the leftmost merge goes first
+    auto remaining = nSegments;
+    while ((remaining > 2) && (mergeCost.key(mergeCost.top()).first < maxError)) {
+        auto index = mergeCost.top();
+        auto fused = next[index];
+
+        // Merge candidate segments and delete the fused one
+        segments[index].second = segments[fused].second;
+        mergeCost.erase(fused);
+        next[index] = next[fused];
+        if (next[index] >= 0) {
+            previous[next[index]] = index;
+        }
+        remaining--;
 
-        // Calculate new minimum
-        minCost = std::min_element(std::begin(mergeCost), std::end(mergeCost));
+        // Calculate the new costs of the neighbours
+        if (next[index] >= 0) {
+            mergeCost.update(index, std::make_pair(errors(segments[index].first, segments[next[index]].second), index));
+        } else {
+            mergeCost.erase(index);
+        }
+        if (previous[index] >= 0) {
+            mergeCost.update(previous[index],
+                             std::make_pair(errors(segments[previous[index]].first, segments[index].second),
+                                            previous[index]));
+        }
     }
 
     // Build a polyline from a set of segments
     std::vector<Point> result;
-    result.reserve(segments.size());
-    for (auto &segment : segments) {
-        result.emplace_back(ts[segment.first]);
-        result.emplace_back(ts[segment.second]);
+    result.reserve(2 * remaining);
+    for (int64_t i = 0; i >= 0; i = next[i]) {
+        result.emplace_back(ts[segments[i].first]);
+        result.emplace_back(ts[segments[i].second]);
     }
 
     return result;
@@ -398,67 +898,78 @@ af::array khiva::dimensionality::PLABottomUp(const af::array &ts, float maxError
     if (ts.dims(1) != 2) {
         throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
     }
-    // Extracting info from af::array
-    auto h_x = khiva::utils::makeScopedHostPtr(ts.col(0).host<float>());
-    auto h_y = khiva::utils::makeScopedHostPtr(ts.col(1).host<float>());
+    return reduceEach(ts, [maxError](const std::vector<Point> &points) { return PLABottomUp(points, maxError); });
+}
 
-    std::vector<Point> points;
-    points.reserve(ts.dims(0));
+khiva::dimensionality::PLASegmenter::PLASegmenter(float maxError, SegmentCallback callback)
+    : maxError(maxError), callback(std::move(callback)) {}
 
-    // Creating a vector of Points
-    for (int i = 0; i < ts.dims(0); i++) {
-        points.emplace_back(h_x[i], h_y[i]);
+void khiva::dimensionality::PLASegmenter::add(const Point &point) {
+    if (count == 0) {
+        startWindow(point);
+        return;
+    }
+    // The window was closed by the previous point, which is not the last one
+    if (closed) {
+        callback(closedStart, closedEnd);
+        closed = false;
     }
 
-    std::vector<Point> reducedPoints = PLABottomUp(points, maxError);
-    std::vector<float> x;
-    x.reserve(reducedPoints.size());
-    std::vector<float> y;
-    y.reserve(reducedPoints.size());
-
-    // Converting from vector to array
-    for (const auto &point : reducedPoints) {
-        x.emplace_back(point.first);
-        y.emplace_back(point.second);
+    // Error of the window and the new point against the line between the anchor and the new point
+    double x = static_cast<double>(point.first) - anchor.first;
+    double y = static_cast<double>(point.second) - anchor.second;
+    double m = (point.second - anchor.second) / (point.first - anchor.first);
+    double error = lineError(count + 1, sumX + x, sumY + y, sumXX + x * x, sumXY + x * y, sumYY + y * y, 0.0, m);
+
+    if (error < maxError) {
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        sumYY += y * y;
+        count++;
+        last = point;
+    } else {
+        closed = true;
+        closedStart = anchor;
+        closedEnd = last;
+        startWindow(point);
     }
+}
 
-    // from c-array to af::array
-    af::array tsx(reducedPoints.size(), 1, x.data());
-    af::array tsy(reducedPoints.size(), 1, y.data());
-    af::array res = af::join(1, tsx, tsy);
+void khiva::dimensionality::PLASegmenter::flush() {
+    if (closed) {
+        // The point that closed the window is the last one, so it ends the segment
+        callback(closedStart, anchor);
+    } else if (count > 1) {
+        callback(anchor, last);
+    }
+    closed = false;
+    count = 0;
+}
 
-    return res;
+void khiva::dimensionality::PLASegmenter::startWindow(const Point &point) {
+    anchor = point;
+    last = point;
+    count = 1;
+    sumX = 0.0;
+    sumY = 0.0;
+    sumXX = 0.0;
+    sumXY = 0.0;
+    sumYY = 0.0;
 }
 
 std::vector<Point> khiva::dimensionality::PLASlidingWindow(const std::vector<Point> &ts, float maxError) {
-    std::vector<Segment> segments;
-
-    size_t anchor = 0;
-    size_t i;
-
-    // We haven´t explored the whole time series
-    while (anchor < (ts.size() - 1)) {
-        i = 1;
-        while (((anchor + i) < ts.size()) &&
-               (calculateError(ts, static_cast<int>(anchor), static_cast<int>(anchor + i)) < maxError)) {
-            i = i + 1;
-        }
-
-        if ((anchor + i) == (ts.size() - 1)) {
-            segments.emplace_back(anchor, anchor + i);
-        } else {
-            segments.emplace_back(anchor, anchor + i - 1);
-        }
-        anchor += i;
-    }
-
     // Build a polyline from a set of segments
     std::vector<Point> result;
-    result.reserve(segments.size());
-    for (auto &segment : segments) {
-        result.emplace_back(ts[segment.first]);
-        result.emplace_back(ts[segment.second]);
+    PLASegmenter segmenter(maxError, [&result](const Point &start, const Point &end) {
+        result.emplace_back(start);
+        result.emplace_back(end);
+    });
+    for (const auto &point : ts) {
+        segmenter.add(point);
     }
+    segmenter.flush();
 
     return result;
 }
@@ -467,106 +978,22 @@ af::array khiva::dimensionality::PLASlidingWindow(const af::array &ts, float max
     if (ts.dims(1) != 2) {
         throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
     }
-    // Extracting info from af::array
-    auto h_x = khiva::utils::makeScopedHostPtr(ts.col(0).host<float>());
-    auto h_y = khiva::utils::makeScopedHostPtr(ts.col(1).host<float>());
-
-    std::vector<Point> points;
-    points.reserve(ts.dims(0));
-
-    // Creating a vector of Points
-    for (int i = 0; i < ts.dims(0); i++) {
-        points.emplace_back(h_x[i], h_y[i]);
-    }
-
-    std::vector<Point> reducedPoints = PLASlidingWindow(points, maxError);
-    std::vector<float> x;
-    x.reserve(reducedPoints.size());
-    std::vector<float> y;
-    y.reserve(reducedPoints.size());
-    // Converting from vector to array
-    for (const auto &point : reducedPoints) {
-        x.emplace_back(point.first);
-        y.emplace_back(point.second);
-    }
-
-    // from c-array to af::array
-    af::array tsx(reducedPoints.size(), 1, x.data());
-    af::array tsy(reducedPoints.size(), 1, y.data());
-    af::array res = af::join(1, tsx, tsy);
-
-    return res;
+    return reduceEach(ts, [maxError](const std::vector<Point> &points) { return PLASlidingWindow(points, maxError); });
 }
 
 std::vector<Point> khiva::dimensionality::ramerDouglasPeucker(const std::vector<Point> &pointList, double epsilon) {
-    std::vector<Point> out;
-
-    if (pointList.size() < 2) throw std::invalid_argument("Not enough points to simplify ...");
-
-    // Find the point with the maximum distance from line between start and end
-    double dmax = 0.0;
-    size_t index = 0;
-    size_t end = pointList.size() - 1;
-
-    for (size_t i = 1; i < end; i++) {
-        double d = PerpendicularDistance(pointList[i], pointList[0], pointList[end]);
-        if (d > dmax) {
-            index = i;
-            dmax = d;
-        }
-    }
-
-    // If max distance is greater than epsilon, recursively simplify
-    if (dmax > epsilon) {
-        std::vector<Point> firstLine(pointList.begin(), pointList.begin() + index + 1);
-        std::vector<Point> lastLine(pointList.begin() + index, pointList.end());
-        auto recResults1 = ramerDouglasPeucker(firstLine, epsilon);
-        auto recResults2 = ramerDouglasPeucker(lastLine, epsilon);
-
-        // Build the result list
-        out.assign(recResults1.begin(), recResults1.end() - 1);
-        out.insert(out.end(), recResults2.begin(), recResults2.end());
-        if (out.size() < 2) throw std::runtime_error("Problem assembling output");
-    } else {
-        // Just return start and end points
-        out.clear();
-        out.emplace_back(pointList[0]);
-        out.emplace_back(pointList[end]);
-    }
-    return out;
+    return simplifyRDP(pointList, epsilon, true);
 }
 
 af::array khiva::dimensionality::ramerDouglasPeucker(const af::array &pointList, double epsilon) {
     if (pointList.dims(1) != 2) {
         throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
     }
-
-    auto x = khiva::utils::makeScopedHostPtr(pointList.col(0).host<float>());
-    auto y = khiva::utils::makeScopedHostPtr(pointList.col(1).host<float>());
-
-    std::vector<Point> points;
-    points.reserve(pointList.dims(0));
-    for (int i = 0; i < pointList.dims(0); i++) {
-        points.emplace_back(x[i], y[i]);
-    }
-
-    std::vector<Point> rPoints = ramerDouglasPeucker(points, epsilon);
-    af::array out = af::constant(0, rPoints.size(), 2);
-
-    std::vector<float> vx;
-    vx.reserve(rPoints.size());
-    std::vector<float> vy;
-    vy.reserve(rPoints.size());
-
-    for (const auto &rPoint : rPoints) {
-        vx.emplace_back(rPoint.first);
-        vy.emplace_back(rPoint.second);
-    }
-
-    af::array ox(rPoints.size(), vx.data());
-    af::array oy(rPoints.size(), vy.data());
-
-    return af::join(1, ox, oy);
+    // Several time series are already simplified in parallel, so the search within each of them is sequential
+    bool parallel = pointList.dims(2) == 1;
+    return reduceEach(pointList, [epsilon, parallel](const std::vector<Point> &points) {
+        return simplifyRDP(points, epsilon, parallel);
+    });
 }
 
 af::array khiva::dimensionality::SAX(const af::array &a, int alphabet_size) {
@@ -577,118 +1004,93 @@ af::array khiva::dimensionality::SAX(const af::array &a, int alphabet_size) {
     af::array result = af::constant(0.0, a.dims());
     // Let's store the x-axis.
     result(af::span, 0) += a.col(0);
-
     // Let's compute the y-axis.
-    for (int k = 1; k < a.dims(1); k++) {
-        af::array ts = a.col(k);
-        auto mean_value = af::mean<float>(ts);
-        auto std_value = af::stdev<float>(ts);
-        dim_t n = ts.dims(0);
-        std::vector<int> aux(n, 0);
-
-        if (std_value > 0) {
-            std::vector<float> breakingPoints = computeBreakpoints(alphabet_size, mean_value, std_value);
-            std::vector<int> alphabet = generateAlphabet(alphabet_size);
-            auto a_h = khiva::utils::makeScopedHostPtr(ts.host<float>());
-
-            // Iterate across elements of ts
-            for (int i = 0; i < n; i++) {
-                size_t j = 0;
-                while ((j < breakingPoints.size()) && (a_h[i] > breakingPoints[j])) {
-                    j++;
-                }
-                aux[i] = alphabet[j];
-            }
-        }
-
-        // from c-array to af::array
-        af::array res(aux.size(), 1, aux.data());
-        result(af::span, k) += res;
-    }
+    result(af::span, 1) += SAXBatch(a.col(1), alphabet_size);
 
     return result;
 }
 
-std::vector<Point> khiva::dimensionality::visvalingam(const std::vector<Point> &pointList, int64_t numPoints,
-                                                      int64_t scale) {
-    std::map<int64_t, VisvalingamSummaryPoint> points;
-    std::set<std::pair<int64_t, int64_t>, mapComparator> point_indexer;
-    int64_t counter = 0;
+af::array khiva::dimensionality::SAXBatch(const af::array &tss, int alphabetSize, int bins) {
+    if (alphabetSize < 1) {
+        throw std::invalid_argument("The alphabet size must be at least one.");
+    }
+    auto type = (tss.type() == af::dtype::f64) ? af::dtype::f64 : af::dtype::f32;
+    af::array data = tss.as(type);
+    auto nSeries = static_cast<unsigned>(data.dims(1));
+
+    // The statistics of all the time series at once, with the population standard deviation
+    af::array mean = af::mean(data, 0);
+    af::array centered = data - af::tile(mean, static_cast<unsigned>(data.dims(0)));
+    af::array stdev = af::sqrt(af::mean(centered * centered, 0));
+
+    // The breakpoints of the normal distribution of every time series, along dimension zero
+    auto standard = standardBreakpoints(alphabetSize);
+    af::array breakpoints;
+    if (!standard.empty()) {
+        af::array z = af::array(static_cast<dim_t>(standard.size()), standard.data()).as(type);
+        auto nBreakpoints = static_cast<unsigned>(standard.size());
+        breakpoints = af::tile(mean, nBreakpoints) + af::tile(z, 1, nSeries) * af::tile(stdev, nBreakpoints);
+    } else {
+        breakpoints = af::array(0, data.dims(1), type);
+    }
 
-    std::transform(
-        pointList.cbegin(), pointList.cend(), std::inserter(points, points.end()), [&counter](const Point &point) {
-            return std::make_pair(
-                counter++, VisvalingamSummaryPoint{point.first, point.second, std::numeric_limits<int64_t>::max()});
-        });
+    af::array values = (bins > 0) ? PAA(data, bins) : data;
+    af::array symbols = lookupSymbols(values, breakpoints);
 
-    auto points_to_be_deleted = pointList.size() - numPoints;
-    auto point_iterator = point_indexer.begin();
+    // Constant time series have a single symbol
+    return af::select(af::tile(stdev > 0, static_cast<unsigned>(values.dims(0))), symbols, 0);
+}
 
-    // Precompute areas
-    for (auto it = shiftIterator(points.begin(), 1); it != shiftIterator(points.end(), -1); ++it) {
-        auto area = computeTriangleArea(shiftIterator(it, -1)->second, it->second, shiftIterator(it, 1)->second, scale);
-        it->second.area = area;
-        point_iterator = point_indexer.insert(point_iterator, std::make_pair(area, it->first));
+std::vector<Point> khiva::dimensionality::visvalingam(const std::vector<Point> &pointList, int64_t numPoints,
+                                                      int64_t scale) {
+    auto n = static_cast<int64_t>(pointList.size());
+    if (numPoints >= n) {
+        return pointList;
     }
 
-    // One point to be deleted on each iteration
-    for (size_t iter = 0; iter < points_to_be_deleted; iter++) {
-        auto min_index_iterator = point_indexer.begin();
-        int64_t min_element = min_index_iterator->second;
-        point_indexer.erase(min_index_iterator);
-
-        auto iterator_point = points.find(min_element);
-        auto iterator_point_minus1 = shiftIterator(iterator_point, -1);
-        auto iterator_point_plus1 = shiftIterator(iterator_point, 1);
+    // The points left are a doubly-linked list, and their areas are in a heap ordered by area and position
+    std::vector<int64_t> previous(n);
+    std::vector<int64_t> next(n);
+    khiva::heaputil::IndexedMinHeap<std::pair<int64_t, int64_t>> areas(n);
+    auto area = [&](int64_t i) {
+        return std::make_pair(computeTriangleArea(pointList[previous[i]], pointList[i], pointList[next[i]], scale), i);
+    };
+    for (int64_t i = 0; i < n; i++) {
+        previous[i] = i - 1;
+        next[i] = i + 1;
+    }
+    for (int64_t i = 1; i < n - 1; i++) {
+        areas.push(i, area(i));
+    }
 
-        points.erase(iterator_point);
+    // One point to be deleted on each iteration, the first and the last ones are always kept
+    for (int64_t iter = 0; iter < n - numPoints && !areas.empty(); iter++) {
+        auto i = areas.top();
+        areas.pop();
+        next[previous[i]] = next[i];
+        previous[next[i]] = previous[i];
 
-        if (iterator_point_minus1->first > 0) {
-            recomputeAreaNeighbor(iterator_point_minus1, point_indexer, points, scale);
+        if (previous[i] > 0) {
+            areas.update(previous[i], area(previous[i]));
         }
-
-        if (iterator_point_plus1->first < counter - 1) {
-            recomputeAreaNeighbor(iterator_point_plus1, point_indexer, points, scale);
+        if (next[i] < n - 1) {
+            areas.update(next[i], area(next[i]));
         }
     }
 
     std::vector<Point> out_vector;
-    out_vector.reserve(numPoints);
-    std::transform(points.cbegin(), points.cend(), std::back_inserter(out_vector),
-                   [](const std::pair<int64_t, VisvalingamSummaryPoint> &p) {
-                       return Point{p.second.x, p.second.y};
-                   });
+    out_vector.reserve(std::max<int64_t>(numPoints, 2));
+    for (int64_t i = 0; i < n; i = next[i]) {
+        out_vector.emplace_back(pointList[i]);
+    }
 
     return out_vector;
 }
+
 af::array khiva::dimensionality::visvalingam(const af::array &pointList, int numPoints) {
     if (pointList.dims(1) != 2) {
         throw std::invalid_argument("Invalid dims. Khiva array with two columns expected (x axis and y axis).");
     }
-    std::vector<Point> points;
-    points.reserve(pointList.dims(0));
-    auto x = khiva::utils::makeScopedHostPtr(pointList.col(0).host<float>());
-    auto y = khiva::utils::makeScopedHostPtr(pointList.col(1).host<float>());
-
-    for (int i = 0; i < pointList.dims(0); i++) {
-        points.emplace_back(x[i], y[i]);
-    }
-
-    std::vector<Point> rPoints = visvalingam(points, numPoints);
-    af::array out = af::constant(0, rPoints.size(), 2);
-
-    std::vector<float> vx;
-    vx.reserve(rPoints.size());
-    std::vector<float> vy;
-    vy.reserve(rPoints.size());
-
-    for (const auto &rPoint : rPoints) {
-        vx.emplace_back(rPoint.first);
-        vy.emplace_back(rPoint.second);
-    }
-
-    af::array ox(rPoints.size(), vx.data());
-    af::array oy(rPoints.size(), vy.data());
-
-    return af::join(1, ox, oy);
+    return reduceEach(pointList,
+                      [numPoints](const std::vector<Point> &points) { return visvalingam(points, numPoints); });
 }
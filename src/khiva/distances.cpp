@@ -4,173 +4,697 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <khiva/dimensionality.h>
 #include <khiva/distances.h>
+#include <khiva/internal/condensedUtil.h>
+#include <khiva/internal/fftUtil.h>
+#include <khiva/internal/parallelUtil.h>
+#include <khiva/internal/scopedHostPtr.h>
 #include <khiva/normalization.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace {
 
-double distance(double x, double y) { return std::sqrt(std::pow((x - y), 2)); }
+// Number of time series per side of the tiles of the upper triangle computed by a thread.
+constexpr int64_t TILE_SIZE = 64;
 
-af::array distance(const af::array &a, const af::array &bss) {
-    return af::sqrt(af::pow(af::tile(a, 1, static_cast<unsigned int>(bss.dims(1))) - bss, 2));
+// Number of consecutive elements of the time series accumulated for every pair of the tile before moving to the next
+// chunk, so the chunks of both tiles stay in cache.
+constexpr int64_t CHUNK_LENGTH = 512;
+
+// 64-bit integers do not fit in a double, so their kernels accumulate in integers to stay exact.
+template <typename T>
+struct IsWideInteger : std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) > 4)> {};
+
+struct SquaredEuclideanKernel {
+    template <typename T>
+    using Accumulator = double;
+
+    template <typename T>
+    double operator()(const T *a, const T *b, int64_t length) const {
+        double acc = 0.0;
+        for (int64_t i = 0; i < length; i++) {
+            double d = static_cast<double>(a[i]) - b[i];
+            acc += d * d;
+        }
+        return acc;
+    }
+};
+
+struct ManhattanKernel {
+    template <typename T>
+    using Accumulator = typename std::conditional<IsWideInteger<T>::value, uint64_t, double>::type;
+
+    template <typename T>
+    Accumulator<T> operator()(const T *a, const T *b, int64_t length) const {
+        return accumulate(a, b, length, IsWideInteger<T>());
+    }
+
+   private:
+    template <typename T>
+    static double accumulate(const T *a, const T *b, int64_t length, std::false_type) {
+        double acc = 0.0;
+        for (int64_t i = 0; i < length; i++) {
+            acc += std::abs(static_cast<double>(a[i]) - b[i]);
+        }
+        return acc;
+    }
+
+    // the difference of the larger minus the smaller one is exact modulo 2^64, even for signed integers
+    template <typename T>
+    static uint64_t accumulate(const T *a, const T *b, int64_t length, std::true_type) {
+        uint64_t acc = 0;
+        for (int64_t i = 0; i < length; i++) {
+            acc += (a[i] > b[i]) ? static_cast<uint64_t>(a[i]) - static_cast<uint64_t>(b[i])
+                                 : static_cast<uint64_t>(b[i]) - static_cast<uint64_t>(a[i]);
+        }
+        return acc;
+    }
+};
+
+struct HammingKernel {
+    template <typename T>
+    using Accumulator = int64_t;
+
+    template <typename T>
+    int64_t operator()(const T *a, const T *b, int64_t length) const {
+        int64_t acc = 0;
+        for (int64_t i = 0; i < length; i++) {
+            acc += (a[i] != b[i]) ? 1 : 0;
+        }
+        return acc;
+    }
+};
+
+/**
+ * @brief Converts an accumulated distance to the type of the time series. Doubles go through a 64-bit integer when the
+ * type is an integer, so the distances out of its range wrap around instead of being undefined.
+ */
+template <typename T, typename Accumulator>
+T toResult(Accumulator value) {
+    using Wide = typename std::conditional<std::is_integral<T>::value && std::is_floating_point<Accumulator>::value,
+                                           int64_t, Accumulator>::type;
+    return static_cast<T>(static_cast<Wide>(value));
 }
 
-af::array dtwInternal(const af::array &a, const af::array &bss) {
-    auto m = a.dims(0);
-    auto n = bss.dims(0);
+/**
+ * @brief Computes the distances between all pairs of columns of tss with an additive kernel. The upper triangle is
+ * split in tiles of TILE_SIZE x TILE_SIZE time series which are computed in parallel, and every tile accumulates the
+ * time series in chunks of CHUNK_LENGTH elements.
+ */
+template <typename T, typename Kernel>
+af::array pairwiseDistances(const af::array &tss, bool condensed, Kernel kernel) {
+    auto length = static_cast<int64_t>(tss.dims(0));
+    auto numOfTs = static_cast<int64_t>(tss.dims(1));
+    auto data = khiva::utils::makeScopedHostPtr(tss.host<T>());
+
+    auto resultSize = condensed ? khiva::condensedutil::condensedSize(numOfTs) : numOfTs * numOfTs;
+    std::vector<T> result(static_cast<size_t>(resultSize), static_cast<T>(0));
+
+    auto numTiles = (numOfTs + TILE_SIZE - 1) / TILE_SIZE;
+    std::vector<std::pair<int64_t, int64_t>> tiles;
+    tiles.reserve(static_cast<size_t>(numTiles * (numTiles + 1) / 2));
+    for (int64_t ti = 0; ti < numTiles; ti++) {
+        for (int64_t tj = ti; tj < numTiles; tj++) {
+            tiles.emplace_back(ti, tj);
+        }
+    }
+
+    khiva::parallelutil::parallelFor(0, static_cast<int64_t>(tiles.size()), [&](int64_t t) {
+        auto rowStart = tiles[t].first * TILE_SIZE;
+        auto rowEnd = std::min(rowStart + TILE_SIZE, numOfTs);
+        auto colStart = tiles[t].second * TILE_SIZE;
+        auto colEnd = std::min(colStart + TILE_SIZE, numOfTs);
+
+        using Accumulator = typename Kernel::template Accumulator<T>;
+        std::vector<Accumulator> acc(static_cast<size_t>(TILE_SIZE * TILE_SIZE), static_cast<Accumulator>(0));
+        for (int64_t chunk = 0; chunk < length; chunk += CHUNK_LENGTH) {
+            auto chunkLength = std::min(CHUNK_LENGTH, length - chunk);
+            for (auto i = rowStart; i < rowEnd; i++) {
+                const T *a = data.get() + i * length + chunk;
+                for (auto j = std::max(colStart, i + 1); j < colEnd; j++) {
+                    acc[(i - rowStart) * TILE_SIZE + (j - colStart)] +=
+                        kernel(a, data.get() + j * length + chunk, chunkLength);
+                }
+            }
+        }
 
-    // Allocate the cost Matrix:
-    af::array cost = af::constant(0, m, n, bss.dims(1));
-    auto d = distance(a(0), bss(0, af::span));
-    cost(0, 0, af::span) = af::reorder(d, 0, 2, 1, 3);
+        for (auto i = rowStart; i < rowEnd; i++) {
+            for (auto j = std::max(colStart, i + 1); j < colEnd; j++) {
+                auto position =
+                    condensed ? khiva::condensedutil::condensedIndex(numOfTs, i, j) : i + j * numOfTs;
+                result[position] = toResult<T>(acc[(i - rowStart) * TILE_SIZE + (j - colStart)]);
+            }
+        }
+    });
 
-    // Calculate the first column
-    for (int i = 1; i < m; i++) {
-        cost(i, 0, af::span) = cost(i - 1, 0, af::span) + af::reorder(distance(a(i), bss(0, af::span)), 0, 2, 1, 3);
+    if (condensed) {
+        return af::array(resultSize, result.data());
     }
+    return af::array(numOfTs, numOfTs, result.data());
+}
 
-    // Calculate the first row
-    for (int j = 1; j < n; j++) {
-        cost(0, j, af::span) = cost(0, j - 1, af::span) + af::reorder(distance(a(0), bss(j, af::span)), 0, 2, 1, 3);
+/**
+ * @brief Computes the distances in the type of tss, so integers are compared exactly. Complex and boolean time series
+ * are rejected rather than coerced.
+ */
+template <typename Kernel>
+af::array pairwiseDistances(const af::array &tss, bool condensed, Kernel kernel) {
+    switch (tss.type()) {
+        case af::dtype::f64:
+            return pairwiseDistances<double>(tss, condensed, kernel);
+        case af::dtype::f32:
+            return pairwiseDistances<float>(tss, condensed, kernel);
+        case af::dtype::s64:
+            return pairwiseDistances<long long>(tss, condensed, kernel);
+        case af::dtype::u64:
+            return pairwiseDistances<unsigned long long>(tss, condensed, kernel);
+        case af::dtype::s32:
+            return pairwiseDistances<int>(tss, condensed, kernel);
+        case af::dtype::u32:
+            return pairwiseDistances<unsigned int>(tss, condensed, kernel);
+        case af::dtype::s16:
+            return pairwiseDistances<short>(tss, condensed, kernel);
+        case af::dtype::u16:
+            return pairwiseDistances<unsigned short>(tss, condensed, kernel);
+        case af::dtype::u8:
+            return pairwiseDistances<unsigned char>(tss, condensed, kernel);
+        default:
+            throw std::invalid_argument("The time series must be of a real floating point or integer type.");
     }
+}
 
-    for (int i = 1; i < m; i++) {
-        for (int j = 1; j < n; j++) {
-            cost(i, j, af::span) =
-                af::min(cost(i - 1, j, af::span), af::min(cost(i, j - 1, af::span), cost(i - 1, j - 1, af::span))) +
-                af::reorder(distance(a(i), bss(j, af::span)), 0, 2, 1, 3);
+/**
+ * @brief Computes an elastic distance with the recurrence
+ *
+ *     D(i, j) = min(D(i - 1, j - 1) + match(i, j), D(i - 1, j) + vertical(i, j), D(i, j - 1) + horizontal(i, j))
+ *
+ * where i and j are one-based positions of a and b, D(0, 0) = 0 and the first column and row accumulate
+ * firstColumn(i) and firstRow(j). Only two rows of the cost matrix are kept. Cells farther than band from the
+ * diagonal are not computed, and the computation is abandoned returning infinity as soon as a whole row exceeds
+ * upperBound, which is valid because all the costs are non-negative.
+ *
+ * @param n The length of a.
+ * @param m The length of b.
+ * @param costs The policy giving the costs of the recurrence.
+ * @param band The maximum distance to the diagonal, widened to |n - m|. A negative value disables the band.
+ * @param upperBound The value above which the computation is abandoned.
+ *
+ * @return D(n, m), or infinity if it is greater than upperBound.
+ */
+template <typename Costs>
+double elasticDistance(int64_t n, int64_t m, const Costs &costs, int64_t band, double upperBound) {
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    band = (band < 0) ? std::max(n, m) : std::max(band, std::abs(n - m));
+
+    std::vector<double> previous(static_cast<size_t>(m + 1), inf);
+    std::vector<double> current(static_cast<size_t>(m + 1), inf);
+
+    previous[0] = 0.0;
+    auto firstHi = std::min(m, band);
+    for (int64_t j = 1; j <= firstHi; j++) {
+        previous[j] = previous[j - 1] + costs.firstRow(j);
+    }
+
+    double column = 0.0;
+    for (int64_t i = 1; i <= n; i++) {
+        auto lo = std::max<int64_t>(1, i - band);
+        auto hi = std::min(m, i + band);
+
+        column += costs.firstColumn(i);
+        current[lo - 1] = (lo == 1) ? column : inf;
+        auto rowMin = current[lo - 1];
+        for (int64_t j = lo; j <= hi; j++) {
+            auto diagonal = previous[j - 1] + costs.match(i, j);
+            auto value = std::min(diagonal, std::min(previous[j] + costs.vertical(i, j),
+                                                     current[j - 1] + costs.horizontal(i, j)));
+            current[j] = value;
+            rowMin = std::min(rowMin, value);
+        }
+        if (hi < m) {
+            current[hi + 1] = inf;
         }
+
+        if (rowMin > upperBound) {
+            return inf;
+        }
+        std::swap(previous, current);
     }
-    return af::reorder(cost(m - 1, n - 1, af::span), 0, 2, 1, 3);
+
+    return (previous[m] > upperBound) ? inf : previous[m];
 }
 
-}  // namespace
+struct DtwCosts {
+    const double *a;
+    const double *b;
+
+    double match(int64_t i, int64_t j) const { return std::abs(a[i - 1] - b[j - 1]); }
+    double vertical(int64_t i, int64_t j) const { return match(i, j); }
+    double horizontal(int64_t i, int64_t j) const { return match(i, j); }
+    double firstColumn(int64_t) const { return std::numeric_limits<double>::infinity(); }
+    double firstRow(int64_t) const { return std::numeric_limits<double>::infinity(); }
+};
+
+// Insertions and deletions cost one and only elements closer than epsilon can be matched, so D(n, m) = n + m - 2 *
+// LCSS(a, b).
+struct LcssCosts {
+    const double *a;
+    const double *b;
+    double epsilon;
+
+    double match(int64_t i, int64_t j) const {
+        return (std::abs(a[i - 1] - b[j - 1]) <= epsilon) ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+    double vertical(int64_t, int64_t) const { return 1.0; }
+    double horizontal(int64_t, int64_t) const { return 1.0; }
+    double firstColumn(int64_t) const { return 1.0; }
+    double firstRow(int64_t) const { return 1.0; }
+};
+
+struct ErpCosts {
+    const double *a;
+    const double *b;
+    double g;
+
+    double match(int64_t i, int64_t j) const { return std::abs(a[i - 1] - b[j - 1]); }
+    double vertical(int64_t i, int64_t) const { return std::abs(a[i - 1] - g); }
+    double horizontal(int64_t, int64_t j) const { return std::abs(b[j - 1] - g); }
+    double firstColumn(int64_t i) const { return vertical(i, 0); }
+    double firstRow(int64_t j) const { return horizontal(0, j); }
+};
+
+struct MsmCosts {
+    const double *a;
+    const double *b;
+    double c;
+
+    // Cost of splitting or merging x next to its predecessor xPrev when it is aligned against y.
+    double splitMerge(double x, double xPrev, double y) const {
+        if ((xPrev <= x && x <= y) || (xPrev >= x && x >= y)) {
+            return c;
+        }
+        return c + std::min(std::abs(x - xPrev), std::abs(x - y));
+    }
 
-double khiva::distances::dtw(const std::vector<double> &t0, const std::vector<double> &t1) {
-    auto m = t0.size();
-    auto n = t1.size();
+    double match(int64_t i, int64_t j) const { return std::abs(a[i - 1] - b[j - 1]); }
+    double vertical(int64_t i, int64_t j) const {
+        return (i < 2) ? std::numeric_limits<double>::infinity() : splitMerge(a[i - 1], a[i - 2], b[j - 1]);
+    }
+    double horizontal(int64_t i, int64_t j) const {
+        return (j < 2) ? std::numeric_limits<double>::infinity() : splitMerge(b[j - 1], b[j - 2], a[i - 1]);
+    }
+    double firstColumn(int64_t) const { return std::numeric_limits<double>::infinity(); }
+    double firstRow(int64_t) const { return std::numeric_limits<double>::infinity(); }
+};
+
+// The time stamps are the positions of the elements and both time series are preceded by a zero.
+struct TweCosts {
+    const double *a;
+    const double *b;
+    double nu;
+    double lambda;
+
+    double at(const double *x, int64_t i) const { return (i == 0) ? 0.0 : x[i - 1]; }
+
+    double match(int64_t i, int64_t j) const {
+        return std::abs(at(a, i) - at(b, j)) + std::abs(at(a, i - 1) - at(b, j - 1)) +
+               2.0 * nu * static_cast<double>(std::abs(i - j));
+    }
+    double vertical(int64_t i, int64_t) const { return std::abs(at(a, i) - at(a, i - 1)) + nu + lambda; }
+    double horizontal(int64_t, int64_t j) const { return std::abs(at(b, j) - at(b, j - 1)) + nu + lambda; }
+    double firstColumn(int64_t) const { return std::numeric_limits<double>::infinity(); }
+    double firstRow(int64_t) const { return std::numeric_limits<double>::infinity(); }
+};
+
+double lcssDistance(const double *a, int64_t n, const double *b, int64_t m, double epsilon, int64_t band,
+                    double upperBound) {
+    auto shortest = std::min(n, m);
+    if (shortest == 0) {
+        return (n == m) ? 0.0 : 1.0;
+    }
+    // distance = 1 - (n + m - D) / (2 * shortest), so the bound is translated to the indel cost D
+    auto costBound = static_cast<double>(n + m) - 2.0 * static_cast<double>(shortest) * (1.0 - upperBound);
+    auto cost = elasticDistance(n, m, LcssCosts{a, b, epsilon}, band, costBound);
+    if (std::isinf(cost)) {
+        return cost;
+    }
+    return 1.0 - (static_cast<double>(n + m) - cost) / (2.0 * static_cast<double>(shortest));
+}
 
-    // Allocate the cost Matrix
-    std::vector<std::vector<double>> cost(m, std::vector<double>(n));
+/**
+ * @brief Computes the elastic distance between every pair of columns of tss in parallel.
+ *
+ * @param tss The time series in columns.
+ * @param measure Function returning the distance between two time series given their data and length.
+ *
+ * @return An upper triangular matrix with the distances.
+ */
+template <typename Measure>
+af::array pairwiseElastic(const af::array &tss, Measure measure) {
+    auto length = static_cast<int64_t>(tss.dims(0));
+    auto numOfTs = static_cast<int64_t>(tss.dims(1));
+    auto data = khiva::utils::makeScopedHostPtr(tss.as(af::dtype::f64).host<double>());
+
+    std::vector<double> result(static_cast<size_t>(numOfTs * numOfTs), 0.0);
+    auto numPairs = khiva::condensedutil::condensedSize(numOfTs);
+
+    // the pairs are enumerated in the condensed order, so every thread takes consecutive pairs of the same row
+    khiva::parallelutil::parallelFor(0, std::max<int64_t>(numPairs, 0), [&](int64_t p) {
+        int64_t i;
+        int64_t j;
+        khiva::condensedutil::condensedPair(numOfTs, p, i, j);
+        result[i + j * numOfTs] = measure(data.get() + i * length, data.get() + j * length, length);
+    });
+
+    return af::array(numOfTs, numOfTs, result.data()).as(tss.type());
+}
+
+using Path = std::vector<std::pair<int64_t, int64_t>>;
+
+/**
+ * @brief Computes DTW only on the cells of the cost matrix between lo[i] and hi[i] for every row i. The rows are stored
+ * one after the other, so the memory is proportional to the number of cells of the window.
+ *
+ * @param path If not null, it receives the optimal warping path from (0, 0) to (n - 1, m - 1).
+ *
+ * @return The DTW distance restricted to the window.
+ */
+double windowedDtw(const double *a, int64_t n, const double *b, int64_t m, const std::vector<int64_t> &lo,
+                   const std::vector<int64_t> &hi, Path *path) {
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    std::vector<int64_t> offsets(static_cast<size_t>(n + 1), 0);
+    for (int64_t i = 0; i < n; i++) {
+        offsets[i + 1] = offsets[i] + std::max<int64_t>(0, hi[i] - lo[i] + 1);
+    }
+    std::vector<double> cost(static_cast<size_t>(offsets[n]));
 
-    cost[0][0] = distance(t0[0], t1[0]);
+    auto at = [&](int64_t i, int64_t j) {
+        if (i < 0 || j < lo[i] || j > hi[i]) {
+            return inf;
+        }
+        return cost[offsets[i] + j - lo[i]];
+    };
 
-    // Calculate the first column
-    for (size_t i = 1; i < m; i++) {
-        cost[i][0] = cost[i - 1][0] + distance(t0[i], t1[0]);
+    for (int64_t i = 0; i < n; i++) {
+        for (auto j = lo[i]; j <= hi[i]; j++) {
+            auto best = (i == 0 && j == 0) ? 0.0 : std::min(at(i - 1, j - 1), std::min(at(i - 1, j), at(i, j - 1)));
+            cost[offsets[i] + j - lo[i]] = best + std::abs(a[i] - b[j]);
+        }
     }
 
-    // Calculate the first row
-    for (size_t j = 1; j < n; j++) {
-        cost[0][j] = cost[0][j - 1] + distance(t0[0], t1[j]);
+    if (path != nullptr) {
+        path->clear();
+        int64_t i = n - 1;
+        int64_t j = m - 1;
+        path->emplace_back(i, j);
+        while (i > 0 || j > 0) {
+            auto diagonal = at(i - 1, j - 1);
+            auto up = at(i - 1, j);
+            auto left = at(i, j - 1);
+            if (diagonal <= up && diagonal <= left) {
+                i--;
+                j--;
+            } else if (up <= left) {
+                i--;
+            } else {
+                j--;
+            }
+            path->emplace_back(i, j);
+        }
+        std::reverse(path->begin(), path->end());
     }
 
-    // Computing the remaining values (we could apply the wavefront parallel pattern, to compute it in parallel)
-    for (size_t i = 1; i < m; i++) {
-        for (size_t j = 1; j < n; j++) {
-            cost[i][j] =
-                std::min(cost[i - 1][j], std::min(cost[i][j - 1], cost[i - 1][j - 1])) + distance(t0[i], t1[j]);
+    return at(n - 1, m - 1);
+}
+
+/**
+ * @brief Projects a warping path found on series of lengths nc and mc to series of lengths n and m, and expands it by
+ * radius cells in every direction. Every coarse element covers the fine elements [I * n / nc, (I + 1) * n / nc).
+ */
+void projectWindow(const Path &coarsePath, int64_t nc, int64_t mc, int64_t n, int64_t m, int64_t radius,
+                   std::vector<int64_t> &lo, std::vector<int64_t> &hi) {
+    lo.assign(static_cast<size_t>(n), m);
+    hi.assign(static_cast<size_t>(n), -1);
+    for (const auto &cell : coarsePath) {
+        auto rowStart = cell.first * n / nc;
+        auto rowEnd = std::max(rowStart + 1, (cell.first + 1) * n / nc);
+        auto colStart = std::max<int64_t>(0, cell.second * m / mc - radius);
+        auto colEnd = std::min(m - 1, std::max(cell.second * m / mc + 1, (cell.second + 1) * m / mc) - 1 + radius);
+        for (auto row = std::max<int64_t>(0, rowStart - radius); row < std::min(n, rowEnd + radius); row++) {
+            lo[row] = std::min(lo[row], colStart);
+            hi[row] = std::max(hi[row], colEnd);
         }
     }
+}
 
-    return cost[m - 1][n - 1];
+/**
+ * @brief Lengths of the levels of the FastDTW pyramid. Both time series are halved until the shortest one has
+ * radius + 2 elements or less.
+ */
+std::vector<std::pair<int64_t, int64_t>> pyramidLengths(int64_t n, int64_t m, int64_t radius) {
+    std::vector<std::pair<int64_t, int64_t>> lengths{{n, m}};
+    while (std::min(lengths.back().first, lengths.back().second) > radius + 2) {
+        lengths.emplace_back((lengths.back().first + 1) / 2, (lengths.back().second + 1) / 2);
+    }
+    return lengths;
 }
 
-af::array khiva::distances::dtw(const af::array &tss) {
-    // get the number of time series
-    auto numOfTs = tss.dims(1);
-    // the result is a squared matrix of dimensions numOfTs x numOfTs
-    // which is initialised as zero.
-    auto result = af::constant(0, numOfTs, numOfTs, tss.type());
+/**
+ * @brief Coarsens the columns of tss with dimensionality::PAA to every length of the pyramid, and copies the levels
+ * to the host. The first level is the original time series.
+ */
+std::vector<std::vector<double>> pyramid(const af::array &tss, const std::vector<int64_t> &lengths) {
+    std::vector<std::vector<double>> levels;
+    levels.reserve(lengths.size());
+    af::array level = tss.as(af::dtype::f64);
+    for (size_t l = 0; l < lengths.size(); l++) {
+        if (l > 0) {
+            level = khiva::dimensionality::PAA(level, static_cast<int>(lengths[l]));
+        }
+        levels.emplace_back(static_cast<size_t>(level.elements()));
+        level.host(levels.back().data());
+    }
+    return levels;
+}
 
-    // for each time series, calculate in parallel all distances
-    for (dim_t currentCol = 0; currentCol < numOfTs - 1; currentCol++) {
-        gfor(af::seq otherCol, currentCol + 1, static_cast<double>(numOfTs - 1)) {
-            auto currentSpan = tss(af::span, currentCol);
-            auto otherSpan = tss(af::span, otherCol);
-            result(currentCol, otherCol) = dtwInternal(currentSpan, af::reorder(otherSpan, 0, 3, 1, 2));
+/**
+ * @brief Runs FastDTW given the pyramids of both time series, where levelsA[l] + offsetA points to the time series a
+ * at the level l.
+ */
+double fastDtwFromPyramids(const std::vector<std::vector<double>> &levelsA, int64_t offsetA,
+                           const std::vector<std::vector<double>> &levelsB, int64_t offsetB,
+                           const std::vector<std::pair<int64_t, int64_t>> &lengths, int64_t radius, Path *path) {
+    Path levelPath;
+    std::vector<int64_t> lo;
+    std::vector<int64_t> hi;
+    double result = 0.0;
+
+    for (auto l = static_cast<int64_t>(lengths.size()) - 1; l >= 0; l--) {
+        auto n = lengths[l].first;
+        auto m = lengths[l].second;
+        if (l == static_cast<int64_t>(lengths.size()) - 1) {
+            // the coarsest level is solved completely
+            lo.assign(static_cast<size_t>(n), 0);
+            hi.assign(static_cast<size_t>(n), m - 1);
+        } else {
+            projectWindow(levelPath, lengths[l + 1].first, lengths[l + 1].second, n, m, radius, lo, hi);
         }
+        auto needsPath = (l > 0) || (path != nullptr);
+        result = windowedDtw(levelsA[l].data() + offsetA * n, n, levelsB[l].data() + offsetB * m, m, lo, hi,
+                             needsPath ? &levelPath : nullptr);
     }
 
+    if (path != nullptr) {
+        *path = std::move(levelPath);
+    }
     return result;
 }
 
-af::array khiva::distances::euclidean(const af::array &tss) {
+double fastDtwInternal(const std::vector<double> &a, const std::vector<double> &b, int radius, Path *path) {
+    if (radius < 0) {
+        throw std::invalid_argument("The radius must be non-negative.");
+    }
+    if (a.empty() || b.empty()) {
+        throw std::invalid_argument("The time series must not be empty.");
+    }
+    auto lengths = pyramidLengths(static_cast<int64_t>(a.size()), static_cast<int64_t>(b.size()), radius);
+    std::vector<int64_t> lengthsA;
+    std::vector<int64_t> lengthsB;
+    for (const auto &length : lengths) {
+        lengthsA.push_back(length.first);
+        lengthsB.push_back(length.second);
+    }
+    auto levelsA = pyramid(af::array(static_cast<dim_t>(a.size()), a.data()), lengthsA);
+    auto levelsB = pyramid(af::array(static_cast<dim_t>(b.size()), b.data()), lengthsB);
+    return fastDtwFromPyramids(levelsA, 0, levelsB, 0, lengths, radius, path);
+}
+
+}  // namespace
+
+double khiva::distances::dtw(const std::vector<double> &t0, const std::vector<double> &t1) {
+    return elasticDistance(static_cast<int64_t>(t0.size()), static_cast<int64_t>(t1.size()),
+                           DtwCosts{t0.data(), t1.data()}, -1, std::numeric_limits<double>::infinity());
+}
+
+af::array khiva::distances::dtw(const af::array &tss) {
+    return pairwiseElastic(tss, [](const double *a, const double *b, int64_t length) {
+        return elasticDistance(length, length, DtwCosts{a, b}, -1, std::numeric_limits<double>::infinity());
+    });
+}
+
+double khiva::distances::erp(const std::vector<double> &a, const std::vector<double> &b, double g, int band,
+                             double upperBound) {
+    return elasticDistance(static_cast<int64_t>(a.size()), static_cast<int64_t>(b.size()),
+                           ErpCosts{a.data(), b.data(), g}, band, upperBound);
+}
+
+af::array khiva::distances::erp(const af::array &tss, double g, int band) {
+    return pairwiseElastic(tss, [g, band](const double *a, const double *b, int64_t length) {
+        return elasticDistance(length, length, ErpCosts{a, b, g}, band, std::numeric_limits<double>::infinity());
+    });
+}
+
+af::array khiva::distances::euclidean(const af::array &tss, bool condensed) {
     // simply invokes non squared version and completes with
     // an elementwise sqrt operation.
-    return af::sqrt(khiva::distances::squaredEuclidean(tss));
+    return af::sqrt(khiva::distances::squaredEuclidean(tss, condensed));
 }
 
-af::array khiva::distances::hamming(const af::array &tss) {
-    // get the number of time series
-    auto numOfTs = tss.dims(1);
-    // the result is a squared matrix of dimensions numOfTs x numOfTs
-    // which is initialised as zero.
-    auto result = af::constant(0, numOfTs, numOfTs, tss.type());
+double khiva::distances::fastDtw(const std::vector<double> &a, const std::vector<double> &b, int radius) {
+    return fastDtwInternal(a, b, radius, nullptr);
+}
 
-    // for each time series, calculate in parallel all distances
-    for (dim_t currentCol = 0; currentCol < numOfTs - 1; currentCol++) {
-        gfor(af::seq otherCol, currentCol + 1, static_cast<double>(numOfTs - 1)) {
-            result(currentCol, otherCol) =
-                af::sum((tss(af::span, currentCol) != tss(af::span, otherCol)).as(af::dtype::s32));
-        }
+double khiva::distances::fastDtw(const std::vector<double> &a, const std::vector<double> &b, int radius,
+                                 std::vector<std::pair<int64_t, int64_t>> &path) {
+    return fastDtwInternal(a, b, radius, &path);
+}
+
+af::array khiva::distances::fastDtw(const af::array &tss, int radius) {
+    if (radius < 0) {
+        throw std::invalid_argument("The radius must be non-negative.");
     }
-    return result;
+    auto length = static_cast<int64_t>(tss.dims(0));
+    auto numOfTs = static_cast<int64_t>(tss.dims(1));
+
+    // all the time series have the same length, so the pyramid of every level is computed at once for all of them
+    auto lengths = pyramidLengths(length, length, radius);
+    std::vector<int64_t> levelLengths;
+    for (const auto &l : lengths) {
+        levelLengths.push_back(l.first);
+    }
+    auto levels = pyramid(tss, levelLengths);
+
+    std::vector<double> result(static_cast<size_t>(numOfTs * numOfTs), 0.0);
+    auto numPairs = khiva::condensedutil::condensedSize(numOfTs);
+    khiva::parallelutil::parallelFor(0, std::max<int64_t>(numPairs, 0), [&](int64_t p) {
+        int64_t i;
+        int64_t j;
+        khiva::condensedutil::condensedPair(numOfTs, p, i, j);
+        result[i + j * numOfTs] = fastDtwFromPyramids(levels, i, levels, j, lengths, radius, nullptr);
+    });
+
+    return af::array(numOfTs, numOfTs, result.data()).as(tss.type());
 }
 
-af::array khiva::distances::manhattan(const af::array &tss) {
-    // get the number of time series
-    auto numOfTs = tss.dims(1);
-    // the result is a squared matrix of dimensions numOfTs x numOfTs
-    // which is initialised as zero.
-    auto result = af::constant(0, numOfTs, numOfTs, tss.type());
+af::array khiva::distances::hamming(const af::array &tss, bool condensed) {
+    return pairwiseDistances(tss, condensed, HammingKernel());
+}
 
-    // for each time series, calculate in parallel all distances
-    for (dim_t currentCol = 0; currentCol < numOfTs - 1; currentCol++) {
-        gfor(af::seq otherCol, currentCol + 1, static_cast<double>(numOfTs - 1)) {
-            result(currentCol, otherCol) = af::sum(af::abs(tss(af::span, currentCol) - tss(af::span, otherCol)));
-        }
+double khiva::distances::lcss(const std::vector<double> &a, const std::vector<double> &b, double epsilon, int band,
+                              double upperBound) {
+    if (epsilon < 0) {
+        throw std::invalid_argument("The matching threshold epsilon must be non-negative.");
     }
-    return result;
+    return lcssDistance(a.data(), static_cast<int64_t>(a.size()), b.data(), static_cast<int64_t>(b.size()), epsilon,
+                        band, upperBound);
+}
+
+af::array khiva::distances::lcss(const af::array &tss, double epsilon, int band) {
+    if (epsilon < 0) {
+        throw std::invalid_argument("The matching threshold epsilon must be non-negative.");
+    }
+    return pairwiseElastic(tss, [epsilon, band](const double *a, const double *b, int64_t length) {
+        return lcssDistance(a, length, b, length, epsilon, band, std::numeric_limits<double>::infinity());
+    });
+}
+
+af::array khiva::distances::manhattan(const af::array &tss, bool condensed) {
+    return pairwiseDistances(tss, condensed, ManhattanKernel());
+}
+
+double khiva::distances::msm(const std::vector<double> &a, const std::vector<double> &b, double c, int band,
+                             double upperBound) {
+    if (c < 0) {
+        throw std::invalid_argument("The split and merge cost c must be non-negative.");
+    }
+    return elasticDistance(static_cast<int64_t>(a.size()), static_cast<int64_t>(b.size()),
+                           MsmCosts{a.data(), b.data(), c}, band, upperBound);
+}
+
+af::array khiva::distances::msm(const af::array &tss, double c, int band) {
+    if (c < 0) {
+        throw std::invalid_argument("The split and merge cost c must be non-negative.");
+    }
+    return pairwiseElastic(tss, [c, band](const double *a, const double *b, int64_t length) {
+        return elasticDistance(length, length, MsmCosts{a, b, c}, band, std::numeric_limits<double>::infinity());
+    });
 }
 
 af::array khiva::distances::sbd(const af::array &tss) {
+    auto n = tss.dims(0);
     // get the number of time series
     auto numOfTs = tss.dims(1);
-    // the result is a squared matrix of dimensions numOfTs x numOfTs
-    // which is initialised as zero.
-    auto result = af::constant(0, numOfTs, numOfTs, tss.type());
 
-    // for each time series, calculate in parallel all distances
-    for (dim_t currentCol = 0; currentCol < numOfTs - 1; currentCol++) {
-        gfor(af::seq otherCol, currentCol + 1, numOfTs - 1) {
-            af::array xZNorm = khiva::normalization::znorm(tss(af::span, currentCol));
-            af::array yZNorm = khiva::normalization::znorm(tss(af::span, otherCol));
-            af::array xNorm = af::sqrt(af::sum(af::pow(xZNorm, 2), 0));
-            af::array yNorm = af::sqrt(af::sum(af::pow(yZNorm, 2), 0));
-            result(currentCol, otherCol) =
-                1.0 - af::max(af::convolve(xZNorm, af::flip(yZNorm, 0), AF_CONV_EXPAND), 0) / (xNorm * yNorm);
-        }
+    // every time series is normalised and transformed only once
+    af::array zNorm = khiva::normalization::znorm(tss);
+    af::array norms = af::sqrt(af::sum(af::pow(zNorm, 2), 0));
+    af::array spectra = af::fft(zNorm, khiva::fftutil::crossCorrelationLength(n));
+
+    // the maximum cross-correlation of every pair, only blocks of rows against the columns to their right are computed
+    af::array maxCC = af::constant(0, numOfTs, numOfTs, zNorm.type());
+    auto batchSize = khiva::fftutil::spectrumBatchSize(spectra.dims(0), numOfTs);
+    for (dim_t start = 0; start < numOfTs - 1; start += batchSize) {
+        auto end = std::min(start + batchSize, numOfTs - 1);
+        auto rows = af::seq(static_cast<double>(start), static_cast<double>(end - 1));
+        auto cols = af::seq(static_cast<double>(start), static_cast<double>(numOfTs - 1));
+        maxCC(rows, cols) = khiva::fftutil::maxCrossCorrelation(spectra(af::span, rows), spectra(af::span, cols), n);
     }
 
-    return result;
+    af::array result = 1.0 - maxCC / af::matmul(norms.T(), norms);
+
+    // the result is an upper triangular matrix with zeros in the diagonal
+    af::array rowIdx = af::range(af::dim4(numOfTs, numOfTs), 0, af::dtype::s32);
+    af::array colIdx = af::range(af::dim4(numOfTs, numOfTs), 1, af::dtype::s32);
+    return af::select(colIdx > rowIdx, result, 0.0).as(tss.type());
 }
 
-af::array khiva::distances::squaredEuclidean(const af::array &tss) {
-    // get the number of time series
-    auto numOfTs = tss.dims(1);
-    // the result is a squared matrix of dimensions numOfTs x numOfTs
-    // which is initialised as zero.
-    auto result = af::constant(0, numOfTs, numOfTs, tss.type());
+af::array khiva::distances::squaredEuclidean(const af::array &tss, bool condensed) {
+    return pairwiseDistances(tss, condensed, SquaredEuclideanKernel());
+}
 
-    // for each time series, calculate in parallel all distances
-    for (dim_t currentCol = 0; currentCol < numOfTs - 1; currentCol++) {
-        gfor(af::seq otherCol, currentCol + 1, static_cast<double>(numOfTs - 1)) {
-            result(currentCol, otherCol) = af::sum(af::pow(tss(af::span, currentCol) - tss(af::span, otherCol), 2));
-        }
+double khiva::distances::twe(const std::vector<double> &a, const std::vector<double> &b, double nu, double lambda,
+                             int band, double upperBound) {
+    if (nu < 0 || lambda < 0) {
+        throw std::invalid_argument("The stiffness nu and the penalty lambda must be non-negative.");
     }
+    return elasticDistance(static_cast<int64_t>(a.size()), static_cast<int64_t>(b.size()),
+                           TweCosts{a.data(), b.data(), nu, lambda}, band, upperBound);
+}
 
-    return result;
+af::array khiva::distances::twe(const af::array &tss, double nu, double lambda, int band) {
+    if (nu < 0 || lambda < 0) {
+        throw std::invalid_argument("The stiffness nu and the penalty lambda must be non-negative.");
+    }
+    return pairwiseElastic(tss, [nu, lambda, band](const double *a, const double *b, int64_t length) {
+        return elasticDistance(length, length, TweCosts{a, b, nu, lambda}, band,
+                               std::numeric_limits<double>::infinity());
+    });
 }
@@ -0,0 +1,882 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <khiva/internal/parallelUtil.h>
+#include <khiva/normalization.h>
+#include <khiva/search.h>
+
+#include <algorithm>
+#include <boost/math/distributions/normal.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Number of time series of a node above which the distances to its vantage point are computed in parallel.
+constexpr int64_t PARALLEL_BUILD_SIZE = 4096;
+
+// Identifier of the serialised trees and version of the format.
+constexpr char VPTREE_MAGIC[4] = {'K', 'V', 'P', 'T'};
+constexpr uint32_t VPTREE_VERSION = 1;
+constexpr char ISAX_MAGIC[4] = {'K', 'I', 'S', 'X'};
+constexpr uint32_t ISAX_VERSION = 1;
+
+// Bits of the SAX words of the indexed time series, which gives a cardinality of 256 symbols per segment.
+constexpr int ISAX_MAX_BITS = 8;
+constexpr int ISAX_MAX_SEGMENTS = 16;
+
+// Number of time series written to the leaves file at once.
+constexpr int64_t ISAX_WRITE_BLOCK = 4096;
+
+double squaredDistance(const double *x, const double *y, int64_t length, double bound) {
+    double acc = 0.0;
+    for (int64_t i = 0; i < length; i++) {
+        double d = x[i] - y[i];
+        acc += d * d;
+        if (acc > bound) {
+            return std::numeric_limits<double>::infinity();
+        }
+    }
+    return acc;
+}
+
+/**
+ * Checks that the positions of the time series of an index fit in the unsigned 32-bit indexes returned by its searches.
+ */
+int64_t checkIndexSize(int64_t numOfTs) {
+    if (numOfTs > static_cast<int64_t>(std::numeric_limits<uint32_t>::max())) {
+        throw std::invalid_argument("At most 2^32 - 1 time series can be indexed.");
+    }
+    return numOfTs;
+}
+
+// The distances to integer or single precision time series are returned in single precision
+af::dtype distanceType(af::dtype type) { return (type == af::dtype::f64) ? af::dtype::f64 : af::dtype::f32; }
+
+// Max-heap ordered by distance, so the front holds the farthest of the current neighbours
+bool closer(const khiva::search::Neighbour &a, const khiva::search::Neighbour &b) { return a.second < b.second; }
+
+af::array prepare(const af::array &tss, khiva::search::Metric metric) {
+    af::array result = tss.as(af::dtype::f64);
+    if (metric == khiva::search::KHIVA_METRIC_ZNORM_EUCLIDEAN) {
+        result = khiva::normalization::znorm(result);
+    }
+    return result;
+}
+
+template <typename T>
+void writeValue(std::ostream &os, const T &value) {
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeVector(std::ostream &os, const std::vector<T> &values) {
+    writeValue(os, static_cast<int64_t>(values.size()));
+    os.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+template <typename T>
+T readValue(std::istream &is) {
+    T value;
+    if (!is.read(reinterpret_cast<char *>(&value), sizeof(T))) {
+        throw std::runtime_error("Unexpected end of the serialised index.");
+    }
+    return value;
+}
+
+template <typename T>
+std::vector<T> readVector(std::istream &is) {
+    auto size = readValue<int64_t>(is);
+    if (size < 0) {
+        throw std::runtime_error("Corrupted serialised index.");
+    }
+    std::vector<T> values(static_cast<size_t>(size));
+    if (!is.read(reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)))) {
+        throw std::runtime_error("Unexpected end of the serialised index.");
+    }
+    return values;
+}
+
+af::dtype readDistanceType(std::istream &is) {
+    auto type = static_cast<af::dtype>(readValue<int32_t>(is));
+    if (type != af::dtype::f32 && type != af::dtype::f64) {
+        throw std::invalid_argument("The serialised index has an unsupported type of distances.");
+    }
+    return type;
+}
+
+/**
+ * Breakpoints of the standard normal distribution for every number of bits of the iSAX words: the element b holds the
+ * 2^b - 1 values that divide it in 2^b equiprobable regions. The breakpoints of b bits are a subset of the ones of
+ * b + 1 bits, so the symbol of a value with b bits is the prefix of its symbol with more bits.
+ */
+const std::vector<std::vector<double>> &isaxBreakpoints() {
+    static const std::vector<std::vector<double>> breakpoints = []() {
+        std::vector<std::vector<double>> result(ISAX_MAX_BITS + 1);
+        boost::math::normal dist(0.0, 1.0);
+        for (int b = 1; b <= ISAX_MAX_BITS; b++) {
+            auto cardinality = 1 << b;
+            for (int i = 1; i < cardinality; i++) {
+                result[b].push_back(quantile(dist, static_cast<double>(i) / cardinality));
+            }
+        }
+        return result;
+    }();
+    return breakpoints;
+}
+
+// Symbol of a value with the maximum number of bits, which is the number of breakpoints below it.
+uint8_t isaxSymbol(double value) {
+    const auto &breakpoints = isaxBreakpoints()[ISAX_MAX_BITS];
+    return static_cast<uint8_t>(std::lower_bound(breakpoints.begin(), breakpoints.end(), value) - breakpoints.begin());
+}
+
+// Bit of the symbol at the given depth, starting from the most significant one.
+int isaxBit(uint8_t symbol, int depth) { return (symbol >> (ISAX_MAX_BITS - 1 - depth)) & 1; }
+
+}  // namespace
+
+khiva::search::VPTree::VPTree(const af::array &tss, Metric metric, int leafSize)
+    : metric(metric), leafSize(leafSize), length(tss.dims(0)), type(distanceType(tss.type())) {
+    if (leafSize < 1) {
+        throw std::invalid_argument("The leaf size must be at least one.");
+    }
+    if (tss.elements() == 0) {
+        throw std::invalid_argument("There are no time series to index.");
+    }
+    if (metric != KHIVA_METRIC_EUCLIDEAN && metric != KHIVA_METRIC_ZNORM_EUCLIDEAN) {
+        throw std::invalid_argument("Unsupported metric.");
+    }
+
+    auto numOfTs = checkIndexSize(static_cast<int64_t>(tss.dims(1)));
+    data.resize(static_cast<size_t>(numOfTs * length));
+    prepare(tss, metric).host(data.data());
+
+    order.resize(static_cast<size_t>(numOfTs));
+    for (int64_t i = 0; i < numOfTs; i++) {
+        order[i] = i;
+    }
+    build(0, numOfTs, 0);
+
+    // the time series are stored in the order of the tree, so every node reads a contiguous block
+    std::vector<double> sorted(data.size());
+    for (int64_t p = 0; p < numOfTs; p++) {
+        std::memcpy(sorted.data() + p * length, data.data() + order[p] * length, sizeof(double) * length);
+    }
+    data = std::move(sorted);
+}
+
+int64_t khiva::search::VPTree::build(int64_t begin, int64_t end, uint64_t seed) {
+    auto id = static_cast<int64_t>(nodes.size());
+    nodes.push_back(Node{begin, end, 0.0, -1, -1});
+    if (end - begin <= leafSize) {
+        return id;
+    }
+
+    // choose the vantage point at random and move it to the first position of the node
+    std::mt19937_64 rng(seed);
+    auto pick = begin + static_cast<int64_t>(rng() % static_cast<uint64_t>(end - begin));
+    std::swap(order[begin], order[pick]);
+    const double *vantage = data.data() + order[begin] * length;
+
+    std::vector<Neighbour> others(static_cast<size_t>(end - begin - 1));
+    auto fill = [&](int64_t p) {
+        auto d2 = squaredDistance(vantage, data.data() + order[p] * length, length,
+                                  std::numeric_limits<double>::infinity());
+        others[p - begin - 1] = Neighbour(order[p], std::sqrt(d2));
+    };
+    if (end - begin > PARALLEL_BUILD_SIZE) {
+        khiva::parallelutil::parallelFor(begin + 1, end, fill, 256);
+    } else {
+        for (auto p = begin + 1; p < end; p++) {
+            fill(p);
+        }
+    }
+
+    // the first half is at most mu away from the vantage point and the second half at least mu
+    auto half = static_cast<int64_t>(others.size()) / 2;
+    std::nth_element(others.begin(), others.begin() + half, others.end(), closer);
+    for (size_t i = 0; i < others.size(); i++) {
+        order[begin + 1 + static_cast<int64_t>(i)] = others[i].first;
+    }
+    auto mu = others[half].second;
+    auto mid = begin + 1 + half;
+
+    auto inside = (half > 0) ? build(begin + 1, mid, 2 * seed + 1) : -1;
+    auto outside = build(mid, end, 2 * seed + 2);
+    nodes[id].mu = mu;
+    nodes[id].inside = inside;
+    nodes[id].outside = outside;
+    return id;
+}
+
+std::vector<double> khiva::search::VPTree::prepareQueries(const af::array &queries) const {
+    if (queries.dims(0) != length) {
+        throw std::invalid_argument("The queries must have the same length as the indexed time series.");
+    }
+    std::vector<double> result(static_cast<size_t>(queries.elements()));
+    if (!result.empty()) {
+        prepare(queries, metric).host(result.data());
+    }
+    return result;
+}
+
+double khiva::search::VPTree::distance(const double *query, int64_t position, double bound) const {
+    auto bound2 = std::isinf(bound) ? bound : bound * bound;
+    return std::sqrt(squaredDistance(query, data.data() + position * length, length, bound2));
+}
+
+void khiva::search::VPTree::knnSearch(const double *query, int64_t node, size_t k,
+                                      std::vector<Neighbour> &heap) const {
+    auto tau = [&]() { return (heap.size() < k) ? std::numeric_limits<double>::infinity() : heap.front().second; };
+    auto offer = [&](int64_t position, double d) {
+        if (heap.size() < k) {
+            heap.emplace_back(position, d);
+            std::push_heap(heap.begin(), heap.end(), closer);
+        } else if (d < heap.front().second) {
+            std::pop_heap(heap.begin(), heap.end(), closer);
+            heap.back() = Neighbour(position, d);
+            std::push_heap(heap.begin(), heap.end(), closer);
+        }
+    };
+
+    const Node &current = nodes[node];
+    if (current.outside == -1) {
+        for (auto p = current.begin; p < current.end; p++) {
+            auto d = distance(query, p, tau());
+            if (!std::isinf(d)) {
+                offer(p, d);
+            }
+        }
+        return;
+    }
+
+    auto d = distance(query, current.begin, std::numeric_limits<double>::infinity());
+    offer(current.begin, d);
+    if (d < current.mu) {
+        if (current.inside != -1 && d - tau() <= current.mu) {
+            knnSearch(query, current.inside, k, heap);
+        }
+        if (d + tau() >= current.mu) {
+            knnSearch(query, current.outside, k, heap);
+        }
+    } else {
+        if (d + tau() >= current.mu) {
+            knnSearch(query, current.outside, k, heap);
+        }
+        if (current.inside != -1 && d - tau() <= current.mu) {
+            knnSearch(query, current.inside, k, heap);
+        }
+    }
+}
+
+void khiva::search::VPTree::rangeSearch(const double *query, int64_t node, double radius,
+                                        std::vector<Neighbour> &result) const {
+    const Node &current = nodes[node];
+    if (current.outside == -1) {
+        for (auto p = current.begin; p < current.end; p++) {
+            auto d = distance(query, p, radius);
+            if (d <= radius) {
+                result.emplace_back(p, d);
+            }
+        }
+        return;
+    }
+
+    auto d = distance(query, current.begin, std::numeric_limits<double>::infinity());
+    if (d <= radius) {
+        result.emplace_back(current.begin, d);
+    }
+    if (current.inside != -1 && d - radius <= current.mu) {
+        rangeSearch(query, current.inside, radius, result);
+    }
+    if (d + radius >= current.mu) {
+        rangeSearch(query, current.outside, radius, result);
+    }
+}
+
+void khiva::search::VPTree::knn(const af::array &queries, int k, af::array &distances, af::array &indexes) const {
+    if (k < 1 || k > getNumberOfTimeSeries()) {
+        throw std::invalid_argument("The number of neighbours must be between one and the number of time series.");
+    }
+    auto hostQueries = prepareQueries(queries);
+    auto numQueries = static_cast<int64_t>(queries.dims(1));
+
+    std::vector<double> hostDistances(static_cast<size_t>(k * numQueries));
+    std::vector<unsigned int> hostIndexes(static_cast<size_t>(k * numQueries));
+    khiva::parallelutil::parallelFor(0, numQueries, [&](int64_t q) {
+        std::vector<Neighbour> heap;
+        heap.reserve(static_cast<size_t>(k));
+        knnSearch(hostQueries.data() + q * length, 0, static_cast<size_t>(k), heap);
+        std::sort_heap(heap.begin(), heap.end(), closer);
+        for (int64_t i = 0; i < k; i++) {
+            hostDistances[q * k + i] = heap[i].second;
+            hostIndexes[q * k + i] = static_cast<unsigned int>(order[heap[i].first]);
+        }
+    });
+
+    distances = af::array(k, numQueries, hostDistances.data()).as(type);
+    indexes = af::array(k, numQueries, hostIndexes.data());
+}
+
+std::vector<std::vector<khiva::search::Neighbour>> khiva::search::VPTree::range(const af::array &queries,
+                                                                                double radius) const {
+    if (radius < 0) {
+        throw std::invalid_argument("The radius must be non-negative.");
+    }
+    auto hostQueries = prepareQueries(queries);
+    auto numQueries = static_cast<int64_t>(queries.dims(1));
+
+    std::vector<std::vector<Neighbour>> result(static_cast<size_t>(numQueries));
+    khiva::parallelutil::parallelFor(0, numQueries, [&](int64_t q) {
+        auto &neighbours = result[q];
+        rangeSearch(hostQueries.data() + q * length, 0, radius, neighbours);
+        for (auto &neighbour : neighbours) {
+            neighbour.first = order[neighbour.first];
+        }
+        std::sort(neighbours.begin(), neighbours.end(), closer);
+    });
+    return result;
+}
+
+void khiva::search::VPTree::save(std::ostream &os) const {
+    os.write(VPTREE_MAGIC, sizeof(VPTREE_MAGIC));
+    writeValue(os, VPTREE_VERSION);
+    writeValue(os, static_cast<int32_t>(metric));
+    writeValue(os, static_cast<int32_t>(leafSize));
+    writeValue(os, static_cast<int32_t>(type));
+    writeValue(os, length);
+    writeVector(os, data);
+    writeVector(os, order);
+    writeVector(os, nodes);
+    if (!os) {
+        throw std::runtime_error("The index could not be written.");
+    }
+}
+
+khiva::search::VPTree khiva::search::VPTree::load(std::istream &is) {
+    char magic[sizeof(VPTREE_MAGIC)];
+    if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, VPTREE_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("The stream does not contain a serialised VPTree.");
+    }
+    if (readValue<uint32_t>(is) != VPTREE_VERSION) {
+        throw std::runtime_error("Unsupported version of the serialised VPTree.");
+    }
+
+    VPTree tree;
+    tree.metric = static_cast<Metric>(readValue<int32_t>(is));
+    tree.leafSize = readValue<int32_t>(is);
+    tree.type = readDistanceType(is);
+    tree.length = readValue<int64_t>(is);
+    tree.data = readVector<double>(is);
+    tree.order = readVector<int64_t>(is);
+    tree.nodes = readVector<Node>(is);
+
+    if (tree.length <= 0 || tree.data.size() != tree.order.size() * static_cast<size_t>(tree.length) ||
+        tree.nodes.empty()) {
+        throw std::runtime_error("Corrupted serialised index.");
+    }
+    if (tree.metric != KHIVA_METRIC_EUCLIDEAN && tree.metric != KHIVA_METRIC_ZNORM_EUCLIDEAN) {
+        throw std::invalid_argument("The serialised index has an unsupported metric.");
+    }
+
+    // The positions must be a permutation of the time series, and every node must cover a range of them and only
+    // point to later nodes, so the searches stay in bounds and terminate
+    auto numOfTs = checkIndexSize(static_cast<int64_t>(tree.order.size()));
+    std::vector<bool> seen(static_cast<size_t>(numOfTs), false);
+    for (auto id : tree.order) {
+        if (id < 0 || id >= numOfTs || seen[id]) {
+            throw std::invalid_argument("The serialised index has an invalid order of the time series.");
+        }
+        seen[id] = true;
+    }
+    auto numNodes = static_cast<int64_t>(tree.nodes.size());
+    auto validChild = [&](int64_t id, int64_t child) { return child == -1 || (child > id && child < numNodes); };
+    for (int64_t i = 0; i < numNodes; i++) {
+        const Node &node = tree.nodes[i];
+        if (node.begin < 0 || node.begin > node.end || node.end > numOfTs || !validChild(i, node.inside) ||
+            !validChild(i, node.outside) || (node.outside != -1 && node.begin == node.end)) {
+            throw std::invalid_argument("The serialised index has a node out of range.");
+        }
+    }
+    if (tree.nodes[0].begin != 0 || tree.nodes[0].end != numOfTs) {
+        throw std::invalid_argument("The serialised index has a node out of range.");
+    }
+    return tree;
+}
+
+khiva::search::ISAXIndex::ISAXIndex(const af::array &tss, int segments, int leafSize, const std::string &leavesFile)
+    : segments(segments),
+      leafSize(leafSize),
+      length(tss.dims(0)),
+      type(distanceType(tss.type())),
+      leavesFile(leavesFile) {
+    if (tss.elements() == 0) {
+        throw std::invalid_argument("There are no time series to index.");
+    }
+    auto numOfTs = checkIndexSize(static_cast<int64_t>(tss.dims(1)));
+    auto values64 = tss.as(af::dtype::f64);
+    step = length;
+    values.resize(static_cast<size_t>(numOfTs * length));
+    means.resize(static_cast<size_t>(numOfTs));
+    stdevs.resize(static_cast<size_t>(numOfTs));
+    values64.host(values.data());
+    af::mean(values64, 0).host(means.data());
+    af::stdev(values64, 0).host(stdevs.data());
+
+    // Same normalisation as khiva::normalization::znorm
+    constexpr double epsilon = 0.00000001;
+    for (auto &stdev : stdevs) {
+        if (stdev <= epsilon) {
+            stdev = 1.0;
+        }
+    }
+    build(numOfTs);
+}
+
+khiva::search::ISAXIndex khiva::search::ISAXIndex::subsequences(const af::array &ts, int64_t window, int segments,
+                                                                int leafSize, const std::string &leavesFile) {
+    if (ts.dims(1) != 1 || ts.dims(2) != 1 || ts.dims(3) != 1) {
+        throw std::invalid_argument("A single time series is expected.");
+    }
+    if (window < 1 || window > ts.dims(0)) {
+        throw std::invalid_argument("The window must be between one and the length of the time series.");
+    }
+    ISAXIndex index;
+    index.segments = segments;
+    index.leafSize = leafSize;
+    index.length = window;
+    index.type = distanceType(ts.type());
+    index.leavesFile = leavesFile;
+    index.step = 1;
+
+    // The mean and standard deviation of every subsequence come from prefix sums of the time series, centred to
+    // reduce their cancellation
+    auto n = static_cast<int64_t>(ts.dims(0));
+    auto numOfTs = checkIndexSize(n - window + 1);
+    auto &values = index.values;
+    values.resize(static_cast<size_t>(n));
+    ts.as(af::dtype::f64).host(values.data());
+    double centre = 0.0;
+    for (auto v : values) {
+        centre += v / n;
+    }
+    std::vector<double> sum(static_cast<size_t>(n + 1), 0.0);
+    std::vector<double> sumSquares(static_cast<size_t>(n + 1), 0.0);
+    for (int64_t i = 0; i < n; i++) {
+        values[i] -= centre;
+        sum[i + 1] = sum[i] + values[i];
+        sumSquares[i + 1] = sumSquares[i] + values[i] * values[i];
+    }
+
+    // Same normalisation as khiva::normalization::znorm
+    constexpr double epsilon = 0.00000001;
+    index.means.resize(static_cast<size_t>(numOfTs));
+    index.stdevs.resize(static_cast<size_t>(numOfTs));
+    for (int64_t id = 0; id < numOfTs; id++) {
+        auto mean = (sum[id + window] - sum[id]) / window;
+        auto variance = (sumSquares[id + window] - sumSquares[id]) / window - mean * mean;
+        auto stdev = std::sqrt(std::max(variance, 0.0));
+        index.means[id] = mean;
+        index.stdevs[id] = (stdev <= epsilon) ? 1.0 : stdev;
+    }
+    index.build(numOfTs);
+    return index;
+}
+
+void khiva::search::ISAXIndex::build(int64_t numOfTs) {
+    if (segments < 1 || segments > ISAX_MAX_SEGMENTS || segments > length) {
+        throw std::invalid_argument("The number of segments must be between one and 16, and at most the length.");
+    }
+    if (leafSize < 1) {
+        throw std::invalid_argument("The leaf size must be at least one.");
+    }
+
+    // The SAX words with the maximum cardinality
+    std::vector<uint8_t> words(static_cast<size_t>(numOfTs * segments));
+    khiva::parallelutil::parallelFor(
+        0, numOfTs,
+        [&](int64_t id) {
+            std::vector<double> ts(static_cast<size_t>(length));
+            std::vector<double> segmentMeans(static_cast<size_t>(segments));
+            normalise(id, ts.data());
+            paa(ts.data(), segmentMeans.data());
+            for (int i = 0; i < segments; i++) {
+                words[id * segments + i] = isaxSymbol(segmentMeans[i]);
+            }
+        },
+        256);
+
+    // The root splits the words by the first bit of every segment
+    order.resize(static_cast<size_t>(numOfTs));
+    for (int64_t i = 0; i < numOfTs; i++) {
+        order[i] = i;
+    }
+    auto rootKey = [&](int64_t id) {
+        uint32_t key = 0;
+        for (int i = 0; i < segments; i++) {
+            key |= static_cast<uint32_t>(isaxBit(words[id * segments + i], 0)) << i;
+        }
+        return key;
+    };
+    std::vector<uint32_t> keys(static_cast<size_t>(numOfTs));
+    for (int64_t i = 0; i < numOfTs; i++) {
+        keys[i] = rootKey(i);
+    }
+    std::sort(order.begin(), order.end(),
+              [&](int64_t a, int64_t b) { return (keys[a] < keys[b]) || (keys[a] == keys[b] && a < b); });
+
+    std::vector<uint8_t> bits(static_cast<size_t>(segments), 0);
+    std::vector<uint8_t> symbols(static_cast<size_t>(segments), 0);
+    addNode(0, numOfTs, bits.data(), symbols.data());
+
+    std::vector<std::pair<int64_t, int64_t>> groups;
+    for (int64_t begin = 0; begin < numOfTs;) {
+        auto end = begin + 1;
+        while (end < numOfTs && keys[order[end]] == keys[order[begin]]) {
+            end++;
+        }
+        groups.emplace_back(begin, end);
+        begin = end;
+    }
+    nodes[0].firstChild = static_cast<int64_t>(nodes.size());
+    nodes[0].numChildren = static_cast<int32_t>(groups.size());
+    std::fill(bits.begin(), bits.end(), 1);
+    for (const auto &group : groups) {
+        for (int i = 0; i < segments; i++) {
+            symbols[i] = static_cast<uint8_t>(isaxBit(words[order[group.first] * segments + i], 0));
+        }
+        addNode(group.first, group.second, bits.data(), symbols.data());
+    }
+    for (int32_t c = 0; c < nodes[0].numChildren; c++) {
+        split(nodes[0].firstChild + c, words);
+    }
+
+    // In a file, the time series are stored z-normalised in the order of the tree, so every leaf is a contiguous block
+    if (leavesFile.empty()) {
+        return;
+    }
+    std::ofstream file(leavesFile, std::ios::binary | std::ios::trunc);
+    std::vector<double> block(static_cast<size_t>(std::min(ISAX_WRITE_BLOCK, numOfTs) * length));
+    for (int64_t begin = 0; begin < numOfTs; begin += ISAX_WRITE_BLOCK) {
+        auto end = std::min(begin + ISAX_WRITE_BLOCK, numOfTs);
+        khiva::parallelutil::parallelFor(
+            begin, end, [&](int64_t p) { normalise(order[p], block.data() + (p - begin) * length); }, 256);
+        file.write(reinterpret_cast<const char *>(block.data()),
+                   static_cast<std::streamsize>(sizeof(double) * (end - begin) * length));
+    }
+    if (!file) {
+        throw std::runtime_error("The leaves of the index could not be written.");
+    }
+    std::vector<double>().swap(values);
+    std::vector<double>().swap(means);
+    std::vector<double>().swap(stdevs);
+}
+
+void khiva::search::ISAXIndex::normalise(int64_t id, double *result) const {
+    const double *ts = values.data() + id * step;
+    auto mean = means[id];
+    auto stdev = stdevs[id];
+    for (int64_t i = 0; i < length; i++) {
+        result[i] = (ts[i] - mean) / stdev;
+    }
+}
+
+void khiva::search::ISAXIndex::addNode(int64_t begin, int64_t end, const uint8_t *bits, const uint8_t *symbols) {
+    nodes.push_back(Node{begin, end, -1, 0, -1});
+    nodeBits.insert(nodeBits.end(), bits, bits + segments);
+    nodeSymbols.insert(nodeSymbols.end(), symbols, symbols + segments);
+}
+
+void khiva::search::ISAXIndex::split(int64_t node, const std::vector<uint8_t> &words) {
+    auto begin = nodes[node].begin;
+    auto end = nodes[node].end;
+    if (end - begin <= leafSize) {
+        return;
+    }
+
+    // the segment whose next bit divides the time series most evenly
+    int best = -1;
+    int64_t bestBalance = std::numeric_limits<int64_t>::max();
+    for (int i = 0; i < segments; i++) {
+        int depth = nodeBits[node * segments + i];
+        if (depth == ISAX_MAX_BITS) {
+            continue;
+        }
+        int64_t ones = 0;
+        for (auto p = begin; p < end; p++) {
+            ones += isaxBit(words[order[p] * segments + i], depth);
+        }
+        auto balance = std::abs(2 * ones - (end - begin));
+        if (ones > 0 && ones < end - begin && balance < bestBalance) {
+            best = i;
+            bestBalance = balance;
+        }
+    }
+    // the words cannot be told apart, so the leaf stays over its size
+    if (best == -1) {
+        return;
+    }
+
+    int depth = nodeBits[node * segments + best];
+    auto middle = std::stable_partition(order.begin() + begin, order.begin() + end, [&](int64_t id) {
+                      return isaxBit(words[id * segments + best], depth) == 0;
+                  }) -
+                  order.begin();
+
+    std::vector<uint8_t> bits(nodeBits.begin() + node * segments, nodeBits.begin() + (node + 1) * segments);
+    std::vector<uint8_t> symbols(nodeSymbols.begin() + node * segments, nodeSymbols.begin() + (node + 1) * segments);
+    bits[best]++;
+    auto first = static_cast<int64_t>(nodes.size());
+    nodes[node].firstChild = first;
+    nodes[node].numChildren = 2;
+    nodes[node].splitSegment = best;
+
+    auto symbol = symbols[best];
+    symbols[best] = static_cast<uint8_t>(symbol * 2);
+    addNode(begin, middle, bits.data(), symbols.data());
+    symbols[best] = static_cast<uint8_t>(symbol * 2 + 1);
+    addNode(middle, end, bits.data(), symbols.data());
+
+    split(first, words);
+    split(first + 1, words);
+}
+
+void khiva::search::ISAXIndex::paa(const double *ts, double *result) const {
+    for (int i = 0; i < segments; i++) {
+        auto begin = i * length / segments;
+        auto end = (i + 1) * length / segments;
+        double acc = 0.0;
+        for (auto j = begin; j < end; j++) {
+            acc += ts[j];
+        }
+        result[i] = acc / (end - begin);
+    }
+}
+
+double khiva::search::ISAXIndex::minDistance(const double *paa, int64_t node) const {
+    const auto &breakpoints = isaxBreakpoints();
+    double acc = 0.0;
+    for (int i = 0; i < segments; i++) {
+        int b = nodeBits[node * segments + i];
+        if (b == 0) {
+            continue;
+        }
+        int symbol = nodeSymbols[node * segments + i];
+        double lower = (symbol == 0) ? -std::numeric_limits<double>::infinity() : breakpoints[b][symbol - 1];
+        double upper =
+            (symbol == (1 << b) - 1) ? std::numeric_limits<double>::infinity() : breakpoints[b][symbol];
+        double d = (paa[i] < lower) ? lower - paa[i] : ((paa[i] > upper) ? paa[i] - upper : 0.0);
+        // every element of the segment is at least d away from the region, by the Cauchy-Schwarz inequality
+        auto segmentLength = (i + 1) * length / segments - i * length / segments;
+        acc += segmentLength * d * d;
+    }
+    return std::sqrt(acc);
+}
+
+void khiva::search::ISAXIndex::knn(const af::array &queries, int k, af::array &distances, af::array &indexes,
+                                   bool exact) const {
+    if (k < 1 || k > getNumberOfTimeSeries()) {
+        throw std::invalid_argument("The number of neighbours must be between one and the number of time series.");
+    }
+    if (queries.dims(0) != length) {
+        throw std::invalid_argument("The queries must have the same length as the indexed time series.");
+    }
+    auto numQueries = static_cast<int64_t>(queries.dims(1));
+    std::vector<double> hostQueries(static_cast<size_t>(queries.elements()));
+    if (!hostQueries.empty()) {
+        prepare(queries, KHIVA_METRIC_ZNORM_EUCLIDEAN).host(hostQueries.data());
+    }
+
+    std::vector<double> hostDistances(static_cast<size_t>(k * numQueries));
+    std::vector<unsigned int> hostIndexes(static_cast<size_t>(k * numQueries));
+    khiva::parallelutil::parallelFor(0, numQueries, [&](int64_t q) {
+        const double *query = hostQueries.data() + q * length;
+        std::vector<double> queryPaa(static_cast<size_t>(segments));
+        paa(query, queryPaa.data());
+
+        std::ifstream file;
+        std::vector<double> leaf;
+        if (!leavesFile.empty()) {
+            file.open(leavesFile, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("The leaves of the index could not be read.");
+            }
+        }
+
+        std::vector<Neighbour> heap;
+        heap.reserve(static_cast<size_t>(k));
+        auto tau = [&]() {
+            return (heap.size() < static_cast<size_t>(k)) ? std::numeric_limits<double>::infinity()
+                                                          : heap.front().second;
+        };
+
+        // best-first traversal of the nodes by their lower bound
+        using Candidate = std::pair<double, int64_t>;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+        candidates.emplace(0.0, 0);
+        while (!candidates.empty()) {
+            auto candidate = candidates.top();
+            candidates.pop();
+            if (candidate.first >= tau()) {
+                break;
+            }
+            const Node &current = nodes[candidate.second];
+            if (current.numChildren > 0) {
+                for (int32_t c = 0; c < current.numChildren; c++) {
+                    auto child = current.firstChild + c;
+                    auto bound = minDistance(queryPaa.data(), child);
+                    if (bound < tau()) {
+                        candidates.emplace(bound, child);
+                    }
+                }
+                continue;
+            }
+
+            leaf.resize(static_cast<size_t>((current.end - current.begin) * length));
+            if (leavesFile.empty()) {
+                for (auto p = current.begin; p < current.end; p++) {
+                    normalise(order[p], leaf.data() + (p - current.begin) * length);
+                }
+            } else {
+                file.seekg(static_cast<std::streamoff>(sizeof(double) * current.begin * length));
+                if (!file.read(reinterpret_cast<char *>(leaf.data()),
+                               static_cast<std::streamsize>(sizeof(double) * leaf.size()))) {
+                    throw std::runtime_error("The leaves of the index could not be read.");
+                }
+            }
+            const double *block = leaf.data();
+            for (auto p = current.begin; p < current.end; p++) {
+                auto bound = tau();
+                auto d2 = squaredDistance(query, block + (p - current.begin) * length, length,
+                                          std::isinf(bound) ? bound : bound * bound);
+                if (std::isinf(d2)) {
+                    continue;
+                }
+                auto d = std::sqrt(d2);
+                if (heap.size() < static_cast<size_t>(k)) {
+                    heap.emplace_back(p, d);
+                    std::push_heap(heap.begin(), heap.end(), closer);
+                } else if (d < heap.front().second) {
+                    std::pop_heap(heap.begin(), heap.end(), closer);
+                    heap.back() = Neighbour(p, d);
+                    std::push_heap(heap.begin(), heap.end(), closer);
+                }
+            }
+            // the approximate search stops at the first leaves that give k neighbours
+            if (!exact && heap.size() == static_cast<size_t>(k)) {
+                break;
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), closer);
+        for (int64_t i = 0; i < k; i++) {
+            hostDistances[q * k + i] = heap[i].second;
+            hostIndexes[q * k + i] = static_cast<unsigned int>(order[heap[i].first]);
+        }
+    });
+
+    distances = af::array(k, numQueries, hostDistances.data()).as(type);
+    indexes = af::array(k, numQueries, hostIndexes.data());
+}
+
+void khiva::search::ISAXIndex::save(std::ostream &os) const {
+    os.write(ISAX_MAGIC, sizeof(ISAX_MAGIC));
+    writeValue(os, ISAX_VERSION);
+    writeValue(os, static_cast<int32_t>(segments));
+    writeValue(os, static_cast<int32_t>(leafSize));
+    writeValue(os, static_cast<int32_t>(type));
+    writeValue(os, length);
+    writeVector(os, std::vector<char>(leavesFile.begin(), leavesFile.end()));
+    writeValue(os, step);
+    writeVector(os, values);
+    writeVector(os, means);
+    writeVector(os, stdevs);
+    writeVector(os, order);
+    writeVector(os, nodes);
+    writeVector(os, nodeBits);
+    writeVector(os, nodeSymbols);
+    if (!os) {
+        throw std::runtime_error("The index could not be written.");
+    }
+}
+
+khiva::search::ISAXIndex khiva::search::ISAXIndex::load(std::istream &is) {
+    char magic[sizeof(ISAX_MAGIC)];
+    if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, ISAX_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("The stream does not contain a serialised ISAXIndex.");
+    }
+    if (readValue<uint32_t>(is) != ISAX_VERSION) {
+        throw std::runtime_error("Unsupported version of the serialised ISAXIndex.");
+    }
+
+    ISAXIndex index;
+    index.segments = readValue<int32_t>(is);
+    index.leafSize = readValue<int32_t>(is);
+    index.type = readDistanceType(is);
+    index.length = readValue<int64_t>(is);
+    auto file = readVector<char>(is);
+    index.leavesFile = std::string(file.begin(), file.end());
+    index.step = readValue<int64_t>(is);
+    index.values = readVector<double>(is);
+    index.means = readVector<double>(is);
+    index.stdevs = readVector<double>(is);
+    index.order = readVector<int64_t>(is);
+    index.nodes = readVector<Node>(is);
+    index.nodeBits = readVector<uint8_t>(is);
+    index.nodeSymbols = readVector<uint8_t>(is);
+
+    auto numOfTs = checkIndexSize(static_cast<int64_t>(index.order.size()));
+    auto segmentsSize = index.nodes.size() * static_cast<size_t>(std::max(index.segments, 0));
+    if (index.length <= 0 || index.segments < 1 || index.segments > ISAX_MAX_SEGMENTS || numOfTs == 0 ||
+        index.nodes.empty() || index.nodeBits.size() != segmentsSize || index.nodeSymbols.size() != segmentsSize) {
+        throw std::runtime_error("Corrupted serialised index.");
+    }
+    if (index.leavesFile.empty()) {
+        if (index.step < 1 || index.means.size() != index.order.size() || index.stdevs.size() != index.order.size() ||
+            index.values.size() != static_cast<size_t>((numOfTs - 1) * index.step + index.length)) {
+            throw std::runtime_error("Corrupted serialised index.");
+        }
+    } else if (!index.values.empty() || !index.means.empty() || !index.stdevs.empty()) {
+        throw std::runtime_error("Corrupted serialised index.");
+    }
+
+    // The positions must be a permutation of the time series, and every node must cover a range of them and only
+    // point to later nodes, so the traversals stay in bounds and terminate
+    std::vector<bool> seen(static_cast<size_t>(numOfTs), false);
+    for (auto id : index.order) {
+        if (id < 0 || id >= numOfTs || seen[id]) {
+            throw std::invalid_argument("The serialised index has an invalid order of the time series.");
+        }
+        seen[id] = true;
+    }
+    auto numNodes = static_cast<int64_t>(index.nodes.size());
+    for (int64_t i = 0; i < numNodes; i++) {
+        const Node &node = index.nodes[i];
+        if (node.begin < 0 || node.begin > node.end || node.end > numOfTs || node.numChildren < 0 ||
+            (node.numChildren > 0 &&
+             (node.firstChild <= i || node.firstChild > numNodes - node.numChildren ||
+              node.splitSegment >= index.segments))) {
+            throw std::invalid_argument("The serialised index has a node out of range.");
+        }
+        for (int s = 0; s < index.segments; s++) {
+            int bits = index.nodeBits[i * index.segments + s];
+            if (bits > ISAX_MAX_BITS || index.nodeSymbols[i * index.segments + s] >= (1 << bits)) {
+                throw std::invalid_argument("The serialised index has a node out of range.");
+            }
+        }
+    }
+    if (index.nodes[0].begin != 0 || index.nodes[0].end != numOfTs) {
+        throw std::invalid_argument("The serialised index has a node out of range.");
+    }
+    return index;
+}
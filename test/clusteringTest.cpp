@@ -6,9 +6,16 @@
 
 #include <gtest/gtest.h>
 #include <khiva/clustering.h>
+#include <khiva/distances.h>
 #include <khiva/internal/scopedHostPtr.h>
+#include <khiva/normalization.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
 #include "khivaTest.h"
 
@@ -18,7 +25,7 @@ void kmeans() {
 
     af::array tss(4, 6, data);
 
-    float expected_c[] = {0.0, 0.1667, 0.3333, 0.5, 1.5, -1.5, 0.8333, -0.8333, 4.8333, 3.6667, 2.6667, 1.6667};
+    float expected_c[] = {4.0f, 3.0f, 2.5f, 2.0f, 10.5f, 8.5f, 6.5f, 4.5f, 4.5f, -4.5f, 2.5f, -2.5f};
     af::array means;
 
     unsigned int initial_l[] = {0, 1, 2, 0, 1, 2};
@@ -27,10 +34,14 @@ void kmeans() {
     khiva::clustering::kMeans(tss, 3, means, labels);
 
     auto calculated_c = khiva::utils::makeScopedHostPtr(means.host<float>());
+    auto calculated_l = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
 
-    for (size_t i = 0; i < 4; i++) {
-        ASSERT_NEAR(calculated_c[i] + calculated_c[i + 4] + calculated_c[i + 8],
-                    expected_c[i] + expected_c[i + 4] + expected_c[i + 8], 1e-3);
+    // the initial labels are already a fixed point, so the centroids are the means of their time series
+    for (size_t i = 0; i < 12; i++) {
+        ASSERT_NEAR(calculated_c[i], expected_c[i], 1e-3);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        ASSERT_EQ(calculated_l[i], initial_l[i]);
     }
 }
 
@@ -40,20 +51,246 @@ void kmeans2() {
 
     af::array tss(4, 6, data);
 
-    float expected_c[] = {0.0, 0.1667, 0.3333, 0.5, 1.5, -1.5, 0.8333, -0.8333, 4.8333, 3.6667, 2.6667, 1.6667};
     af::array means;
-
     af::array labels;
     khiva::clustering::kMeans(tss, 3, means, labels);
 
     auto calculated_c = khiva::utils::makeScopedHostPtr(means.host<float>());
+    auto calculated_l = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
+
+    // the seeding is random, but at convergence every time series is labeled with its closest centroid and every
+    // centroid is the mean of its time series
+    for (int j = 0; j < 6; j++) {
+        float best = std::numeric_limits<float>::max();
+        unsigned int closest = 0;
+        for (unsigned int c = 0; c < 3; c++) {
+            float d = 0.0f;
+            for (int i = 0; i < 4; i++) {
+                d += std::pow(data[j * 4 + i] - calculated_c[c * 4 + i], 2.0f);
+            }
+            if (d < best) {
+                best = d;
+                closest = c;
+            }
+        }
+        ASSERT_EQ(calculated_l[j], closest);
+    }
+    for (unsigned int c = 0; c < 3; c++) {
+        for (int i = 0; i < 4; i++) {
+            float sum = 0.0f;
+            int count = 0;
+            for (int j = 0; j < 6; j++) {
+                if (calculated_l[j] == c) {
+                    sum += data[j * 4 + i];
+                    count++;
+                }
+            }
+            ASSERT_GT(count, 0);
+            ASSERT_NEAR(calculated_c[c * 4 + i], sum / count, 1e-3);
+        }
+    }
+}
+
+void kmeansInvalidK() {
+    af::array tss = af::randu(4, 3);
+    af::array means;
+    af::array labels;
+    ASSERT_THROW(khiva::clustering::kMeans(tss, 4, means, labels), std::invalid_argument);
+}
+
+void kmeansRestarts() {
+    float data[] = {0.0f, 1.0f, 2.0f, 3.0f, 6.0f,  7.0f,  8.0f, 9.0f, 2.0f, -2.0f, 4.0f, -4.0f,
+                    8.0f, 5.0,  3.0,  1.0,  15.0f, 10.0f, 5.0f, 0.0f, 7.0f, -7.0,  1.0f, -1.0f};
+
+    af::array tss(4, 6, data);
+
+    af::array means;
+    af::array labels;
+    af::array stats;
+    khiva::clustering::kMeans(tss, 3, 8, means, labels, stats);
+
+    ASSERT_EQ(means.dims(), af::dim4(4, 3, 1, 1));
+    ASSERT_EQ(stats.dims(), af::dim4(2, 8, 1, 1));
+
+    // the solution kept is the one with the lowest inertia
+    auto calculated_c = khiva::utils::makeScopedHostPtr(means.host<float>());
+    auto calculated_l = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
+    double inertia = 0.0;
+    for (int j = 0; j < 6; j++) {
+        for (int i = 0; i < 4; i++) {
+            inertia += std::pow(data[j * 4 + i] - calculated_c[calculated_l[j] * 4 + i], 2.0f);
+        }
+    }
+    auto hostStats = khiva::utils::makeScopedHostPtr(stats.host<double>());
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < 8; r++) {
+        best = std::min(best, hostStats[r * 2]);
+        ASSERT_GE(hostStats[r * 2 + 1], 1.0);
+    }
+    ASSERT_NEAR(inertia, best, 1e-3);
+
+    ASSERT_THROW(khiva::clustering::kMeans(tss, 3, 0, means, labels, stats), std::invalid_argument);
+}
+
+void kmeansAccelerated() {
+    float data[] = {0.0f, 1.0f, 2.0f, 3.0f, 6.0f,  7.0f,  8.0f, 9.0f, 2.0f, -2.0f, 4.0f, -4.0f,
+                    8.0f, 5.0,  3.0,  1.0,  15.0f, 10.0f, 5.0f, 0.0f, 7.0f, -7.0,  1.0f, -1.0f};
+
+    af::array tss(4, 6, data);
+
+    float expected_c[] = {4.0f, 3.0f, 2.5f, 2.0f, 10.5f, 8.5f, 6.5f, 4.5f, 4.5f, -4.5f, 2.5f, -2.5f};
+    af::array means;
+
+    unsigned int initial_l[] = {0, 1, 2, 0, 1, 2};
+    af::array labels(6, 1, initial_l);
+
+    khiva::clustering::kMeansAccelerated(tss, 3, means, labels);
+
+    auto calculated_c = khiva::utils::makeScopedHostPtr(means.host<float>());
+    auto calculated_l = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
+
+    for (size_t i = 0; i < 12; i++) {
+        ASSERT_NEAR(calculated_c[i], expected_c[i], 1e-3);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        ASSERT_EQ(calculated_l[i], initial_l[i]);
+    }
+}
+
+void kmeansAcceleratedSameAsLloyd() {
+    af::setSeed(21);
+    af::array tss = af::join(1, af::randn(8, 300, f64), af::randn(8, 300, f64) + 3.0, af::randn(8, 300, f64) - 3.0);
+    af::array initial = tss(af::span, af::seq(0, 899, 100));
+
+    af::array lloydMeans = initial.copy();
+    af::array lloydLabels;
+    khiva::clustering::kMeans(tss, 9, lloydMeans, lloydLabels);
+
+    af::array means = initial.copy();
+    af::array labels;
+    khiva::clustering::kMeansAccelerated(tss, 9, means, labels);
+
+    ASSERT_EQ(labels.dims(), lloydLabels.dims());
+    ASSERT_TRUE(af::allTrue<bool>(labels == lloydLabels));
+    ASSERT_LT(af::max<double>(af::abs(means - lloydMeans)), 1e-9);
+}
+
+void kmeansAcceleratedNearTies() {
+    // Two mirrored clusters far from the origin, and time series between them which are closer to one of them by less
+    // than the rounding error of the distances expanded with a matrix multiplication
+    af::setSeed(13);
+    af::array left = af::randn(4, 200, f64) + 997.0;
+    af::array offsets = (af::randu(1, 25, f64) + 0.5) * 1e-12;
+    af::array ties = af::tile(af::join(1, offsets, -offsets), 4) + 1000.0;
+    af::array tss = af::join(1, left, 2000.0 - left, ties);
+    af::array initial = af::join(1, left.col(0), 2000.0 - left.col(0));
+    auto n = static_cast<size_t>(tss.dims(1));
+
+    af::array lloydMeans = initial.copy();
+    af::array lloydLabels;
+    khiva::clustering::kMeans(tss, 2, lloydMeans, lloydLabels);
+    af::array means = initial.copy();
+    af::array labels;
+    khiva::clustering::kMeansAccelerated(tss, 2, means, labels);
+
+    ASSERT_TRUE(af::allTrue<bool>(labels == lloydLabels));
+    ASSERT_TRUE(af::allTrue<bool>(means == lloydMeans));
 
-    for (size_t i = 0; i < 4; i++) {
-        ASSERT_NEAR(calculated_c[i] + calculated_c[i + 4] + calculated_c[i + 8],
-                    expected_c[i] + expected_c[i + 4] + expected_c[i + 8], 1e-3);
+    af::array first = af::sum(af::pow(tss - af::tile(means.col(0), 1, static_cast<unsigned int>(n)), 2), 0);
+    af::array second = af::sum(af::pow(tss - af::tile(means.col(1), 1, static_cast<unsigned int>(n)), 2), 0);
+    std::vector<double> d0(n);
+    std::vector<double> d1(n);
+    first.host(d0.data());
+    second.host(d1.data());
+    auto hostLabels = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
+    for (size_t i = 0; i < n; i++) {
+        // the exact distances decide every time series, including the near ties
+        ASSERT_EQ(hostLabels[i], (d0[i] <= d1[i]) ? 0u : 1u);
     }
 }
 
+void miniBatchKMeans() {
+    af::setSeed(5);
+    af::array tss = af::join(1, af::randn(4, 600, f64) * 0.1, af::randn(4, 600, f64) * 0.1 + 5.0,
+                             af::randn(4, 600, f64) * 0.1 - 5.0);
+    af::array initial = tss(af::span, af::seq(0, 1200, 600));
+
+    // batches of 100 time series
+    int next = 0;
+    auto nextBatch = [&]() {
+        if (next >= 1800) {
+            return af::array();
+        }
+        af::array batch = tss(af::span, af::seq(next, next + 99));
+        next += 100;
+        return batch;
+    };
+
+    af::array centroids = initial.copy();
+    af::array counts;
+    khiva::clustering::miniBatchKMeans(nextBatch, 3, centroids, counts);
+
+    // the clusters are well separated, so every centroid ends as the mean of its cluster
+    ASSERT_EQ(af::sum<long long>(counts), 1800);
+    af::array expected = af::join(1, af::mean(tss(af::span, af::seq(0, 599)), 1),
+                                  af::mean(tss(af::span, af::seq(600, 1199)), 1),
+                                  af::mean(tss(af::span, af::seq(1200, 1799)), 1));
+    ASSERT_LT(af::max<double>(af::abs(centroids - expected)), 1e-9);
+}
+
+void miniBatchKMeansWarmStart() {
+    af::setSeed(7);
+    af::array tss = af::randn(6, 400, f64);
+    af::array initial = tss(af::span, af::seq(0, 3));
+
+    auto batchesOf = [&](int first, int last) {
+        int next = first;
+        return [&tss, next, last]() mutable {
+            if (next >= last) {
+                return af::array();
+            }
+            af::array batch = tss(af::span, af::seq(next, next + 49));
+            next += 50;
+            return batch;
+        };
+    };
+
+    af::array allCentroids = initial.copy();
+    af::array allCounts;
+    khiva::clustering::miniBatchKMeans(batchesOf(0, 400), 4, allCentroids, allCounts);
+
+    // clustering the second half of the data after the first one gives the same result as clustering it at once
+    af::array centroids = initial.copy();
+    af::array counts;
+    khiva::clustering::miniBatchKMeans(batchesOf(0, 200), 4, centroids, counts);
+    khiva::clustering::miniBatchKMeans(batchesOf(200, 400), 4, centroids, counts);
+
+    ASSERT_TRUE(af::allTrue<bool>(counts == allCounts));
+    ASSERT_LT(af::max<double>(af::abs(centroids - allCentroids)), 1e-12);
+}
+
+void miniBatchKMeansDrainsBatches() {
+    af::array centroids = af::join(1, af::constant(0.0f, 4), af::constant(1.0f, 4));
+    af::array counts = af::constant(1000000, 1, 2, af::dtype::s64);
+
+    // batches of the centroids themselves leave them unchanged, but all of them are still read
+    int read = 0;
+    auto nextBatch = [&]() {
+        if (read == 3) {
+            return af::array();
+        }
+        read++;
+        return centroids.copy();
+    };
+    khiva::clustering::miniBatchKMeans(nextBatch, 2, centroids, counts);
+
+    ASSERT_EQ(read, 3);
+    ASSERT_EQ(af::sum<long long>(counts), 2000006);
+
+    af::array wrongCounts = af::constant(0, 1, 3, af::dtype::s64);
+    ASSERT_THROW(khiva::clustering::miniBatchKMeans(nextBatch, 2, centroids, wrongCounts), std::invalid_argument);
+}
+
 void kShapeFloat() {
     float tolerance = 1e-10;
     int maxIter = 100;
@@ -113,7 +350,315 @@ void kShapeDouble() {
     }
 }
 
+void kShapeShapeExtraction() {
+    // A single cluster of noisy and scaled copies of a shape, so one refinement step from a zero centroid gives the
+    // first eigenvector of Q^T S Q, with the sign of the first time series
+    af::setSeed(37);
+    af::array shape = af::sin(af::range(af::dim4(16), 0, f64) * 0.4);
+    af::array scales = af::randu(1, 20, f64) + 0.5;
+    af::array tss = af::tile(shape, 1, 20) * af::tile(scales, 16) + af::randn(16, 20, f64) * 0.1;
+    af::array centroids;
+    af::array labels = af::constant(0, 20, 1, u32);
+    khiva::clustering::kShape(tss, 1, centroids, labels, 0.0f, 1);
+
+    af::array x = khiva::normalization::znorm(tss);
+    af::array centered = x - af::tile(af::mean(x, 0), 16);
+    af::array m = af::matmul(centered, centered, AF_MAT_NONE, AF_MAT_TRANS);
+    af::array u;
+    af::array s;
+    af::array vt;
+    af::svd(u, s, vt, m);
+    af::array expected = u.col(0);
+    af::array first = x.col(0);
+    if (af::norm(first - expected) >= af::norm(first + expected)) {
+        expected = expected * -1.0;
+    }
+    expected = khiva::normalization::znorm(expected);
+
+    ASSERT_EQ(centroids.dims(0), 16);
+    ASSERT_EQ(centroids.dims(1), 1);
+    ASSERT_LT(af::max<double>(af::abs(centroids - expected)), 1e-6);
+}
+
+void kShapeRestarts() {
+    double a[35] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0,  0.0,  10.0, 4.0, 5.0,  7.0,  -3.0, 0.0, -1.0, 15.0, -12.0, 8.0,
+                    9.0, 4.0, 5.0, 2.0, 8.0, 7.0, -6.0, -1.0, 2.0,  9.0, -5.0, -5.0, -6.0, 7.0, 9.0,  9.0,  0.0};
+    unsigned int idxh[] = {0, 1, 2, 0, 1};
+    af::array data = af::array(7, 5, a);
+
+    // a single run from the given labels is the same as kShape
+    af::array centroids = af::constant(0, 7, 3, data.type());
+    af::array idx = af::array(5, 1, idxh);
+    af::array stats;
+    khiva::clustering::kShape(data, 3, 1, centroids, idx, stats, 1e-10f, 100);
+
+    af::array expectedCentroids = af::constant(0, 7, 3, data.type());
+    af::array expectedIdx = af::array(5, 1, idxh);
+    khiva::clustering::kShape(data, 3, expectedCentroids, expectedIdx, 1e-10f, 100);
+
+    ASSERT_EQ(stats.dims(), af::dim4(2, 1, 1, 1));
+    ASSERT_LT(af::max<double>(af::abs(centroids - expectedCentroids)), 1e-9);
+
+    // more runs never give a worse objective than the first one
+    af::array restartCentroids = af::constant(0, 7, 3, data.type());
+    af::array restartIdx = af::array(5, 1, idxh);
+    khiva::clustering::kShape(data, 3, 6, restartCentroids, restartIdx, stats, 1e-10f, 100);
+
+    ASSERT_EQ(stats.dims(), af::dim4(2, 6, 1, 1));
+    auto hostStats = khiva::utils::makeScopedHostPtr(stats.host<double>());
+    for (int r = 1; r < 6; r++) {
+        ASSERT_GE(hostStats[r * 2], 0.0);
+    }
+    ASSERT_LE(af::min<double>(stats.row(0)), hostStats[0]);
+}
+
+void kMedoids() {
+    float data[] = {0.0f, 0.0f, 1.0f, 0.0f, 2.0f, 0.0f, 10.0f, 0.0f, 11.0f, 0.0f, 12.0f, 0.0f};
+    af::array tss(2, 6, data);
+    af::array distances = khiva::distances::euclidean(tss);
+
+    unsigned int initial[] = {0, 1};
+    af::array medoids(1, 2, initial);
+    af::array labels;
+    khiva::clustering::kMedoids(distances, 2, medoids, labels);
+
+    ASSERT_EQ(medoids.dims(), af::dim4(1, 2, 1, 1));
+    ASSERT_EQ(labels.dims(), af::dim4(1, 6, 1, 1));
+
+    auto hostMedoids = khiva::utils::makeScopedHostPtr(medoids.host<unsigned int>());
+    auto hostLabels = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
+    for (unsigned int j = 0; j < 6; j++) {
+        ASSERT_EQ(hostMedoids[hostLabels[j]], (j < 3) ? 1u : 4u);
+    }
+}
+
+void kMedoidsCondensedAndFunction() {
+    af::setSeed(17);
+    af::array tss = af::randn(8, 60, f64);
+    af::array dense = khiva::distances::euclidean(tss);
+    af::array condensed = khiva::distances::euclidean(tss, true);
+    auto hostDense = khiva::utils::makeScopedHostPtr(dense.host<double>());
+
+    unsigned int initial[] = {0, 1, 2, 3};
+    af::array denseMedoids(1, 4, initial);
+    af::array denseLabels;
+    khiva::clustering::kMedoids(dense, 4, denseMedoids, denseLabels);
+
+    af::array condensedMedoids(1, 4, initial);
+    af::array condensedLabels;
+    khiva::clustering::kMedoids(condensed, 4, condensedMedoids, condensedLabels, true);
+
+    af::array functionMedoids(1, 4, initial);
+    af::array functionLabels;
+    khiva::clustering::kMedoids(
+        60, [&](int64_t i, int64_t j) { return hostDense[i + j * 60]; }, 4, functionMedoids, functionLabels);
+
+    ASSERT_TRUE(af::allTrue<bool>(denseMedoids == condensedMedoids));
+    ASSERT_TRUE(af::allTrue<bool>(denseLabels == condensedLabels));
+    ASSERT_TRUE(af::allTrue<bool>(denseMedoids == functionMedoids));
+    ASSERT_TRUE(af::allTrue<bool>(denseLabels == functionLabels));
+
+    // every time series is labeled with its closest medoid
+    auto hostMedoids = khiva::utils::makeScopedHostPtr(denseMedoids.host<unsigned int>());
+    auto hostLabels = khiva::utils::makeScopedHostPtr(denseLabels.host<unsigned int>());
+    auto distance = [&](unsigned int i, unsigned int j) {
+        return (i == j) ? 0.0 : hostDense[std::min(i, j) + std::max(i, j) * 60];
+    };
+    for (unsigned int j = 0; j < 60; j++) {
+        for (unsigned int c = 0; c < 4; c++) {
+            ASSERT_LE(distance(j, hostMedoids[hostLabels[j]]), distance(j, hostMedoids[c]));
+        }
+    }
+}
+
+void kMedoidsInvalidArguments() {
+    af::array distances = khiva::distances::euclidean(af::randu(4, 5));
+    af::array medoids;
+    af::array labels;
+    ASSERT_THROW(khiva::clustering::kMedoids(distances, 6, medoids, labels), std::invalid_argument);
+    ASSERT_THROW(khiva::clustering::kMedoids(af::randu(5, 4), 2, medoids, labels), std::invalid_argument);
+    ASSERT_THROW(khiva::clustering::kMedoids(af::randu(7), 2, medoids, labels, true), std::invalid_argument);
+
+    unsigned int repeated[] = {1, 1};
+    af::array repeatedMedoids(1, 2, repeated);
+    ASSERT_THROW(khiva::clustering::kMedoids(distances, 2, repeatedMedoids, labels), std::invalid_argument);
+}
+
+void agglomerative() {
+    double data[] = {0.0, 1.0, 3.0, 7.0};
+    af::array tss(1, 4, data);
+    af::array distances = khiva::distances::euclidean(tss);
+
+    // rows of the linkage matrix: first cluster, second cluster, distance and number of time series
+    std::vector<std::vector<double>> expected = {
+        {0, 2, 3, 1, 4, 5, 1, 2, 4, 2, 3, 4},          // single
+        {0, 2, 3, 1, 4, 5, 1, 3, 7, 2, 3, 4},          // complete
+        {0, 2, 3, 1, 4, 5, 1, 2.5, 17.0 / 3, 2, 3, 4},  // average
+        {0, 2, 3, 1, 4, 5, 1, std::sqrt(25.0 / 3), std::sqrt(289.0 / 6), 2, 3, 4}};  // ward
+    khiva::clustering::Linkage methods[] = {khiva::clustering::KHIVA_LINKAGE_SINGLE,
+                                            khiva::clustering::KHIVA_LINKAGE_COMPLETE,
+                                            khiva::clustering::KHIVA_LINKAGE_AVERAGE,
+                                            khiva::clustering::KHIVA_LINKAGE_WARD};
+
+    for (size_t m = 0; m < 4; m++) {
+        af::array linkage = khiva::clustering::agglomerative(distances, methods[m]);
+        ASSERT_EQ(linkage.dims(), af::dim4(3, 4, 1, 1));
+        auto hostLinkage = khiva::utils::makeScopedHostPtr(linkage.host<double>());
+        for (size_t i = 0; i < 12; i++) {
+            ASSERT_NEAR(hostLinkage[i], expected[m][i], 1e-9);
+        }
+    }
+}
+
+void agglomerativeCondensed() {
+    af::setSeed(19);
+    af::array tss = af::randn(6, 40, f64);
+    af::array dense = khiva::distances::euclidean(tss);
+    af::array condensed = khiva::distances::euclidean(tss, true);
+
+    for (auto method : {khiva::clustering::KHIVA_LINKAGE_SINGLE, khiva::clustering::KHIVA_LINKAGE_COMPLETE,
+                        khiva::clustering::KHIVA_LINKAGE_AVERAGE, khiva::clustering::KHIVA_LINKAGE_WARD}) {
+        af::array fromDense = khiva::clustering::agglomerative(dense, method);
+        af::array fromCondensed = khiva::clustering::agglomerative(condensed, method, true);
+        ASSERT_LT(af::max<double>(af::abs(fromDense - fromCondensed)), 1e-12);
+
+        // the distances of the merges never decrease and the last cluster has all the time series
+        af::array heights = fromDense.col(2);
+        ASSERT_TRUE(af::allTrue<bool>(af::diff1(heights) >= 0));
+        ASSERT_EQ(fromDense(39 - 1, 3).scalar<double>(), 40.0);
+    }
+
+    ASSERT_THROW(khiva::clustering::agglomerative(af::randu(3, 2)), std::invalid_argument);
+    ASSERT_THROW(khiva::clustering::agglomerative(af::randu(5), khiva::clustering::KHIVA_LINKAGE_SINGLE, true),
+                 std::invalid_argument);
+}
+
+void dbscan() {
+    float data[] = {0.0f, 0.5f, 1.0f, 10.0f, 10.5f, 11.0f, 50.0f};
+    af::array tss(1, 7, data);
+
+    af::array labels = khiva::clustering::dbscan(tss, 0.6, 2);
+    ASSERT_EQ(labels.dims(), af::dim4(1, 7, 1, 1));
+    auto hostLabels = khiva::utils::makeScopedHostPtr(labels.host<int>());
+    int expected[] = {0, 0, 0, 1, 1, 1, -1};
+    for (int i = 0; i < 7; i++) {
+        ASSERT_EQ(hostLabels[i], expected[i]);
+    }
+
+    // only the middle time series of every group is a core point, and the rest join its cluster
+    labels = khiva::clustering::dbscan(tss, 0.6, 3);
+    hostLabels = khiva::utils::makeScopedHostPtr(labels.host<int>());
+    for (int i = 0; i < 7; i++) {
+        ASSERT_EQ(hostLabels[i], expected[i]);
+    }
+
+    ASSERT_THROW(khiva::clustering::dbscan(tss, -1.0, 2), std::invalid_argument);
+    ASSERT_THROW(khiva::clustering::dbscan(tss, 1.0, 0), std::invalid_argument);
+}
+
+void hdbscan() {
+    // two grids of 5 x 4 points far from each other and three outliers
+    std::vector<double> data;
+    for (int b = 0; b < 2; b++) {
+        for (int x = 0; x < 5; x++) {
+            for (int y = 0; y < 4; y++) {
+                data.push_back(b * 10 + x * 0.1);
+                data.push_back(b * 10 + y * 0.1);
+            }
+        }
+    }
+    std::vector<double> outliers = {100.0, 0.0, -100.0, 0.0, 50.0, 50.0};
+    data.insert(data.end(), outliers.begin(), outliers.end());
+    af::array tss(2, 43, data.data());
+
+    af::array labels = khiva::clustering::hdbscan(tss, 5);
+    ASSERT_EQ(labels.dims(), af::dim4(1, 43, 1, 1));
+    auto hostLabels = khiva::utils::makeScopedHostPtr(labels.host<int>());
+    for (int i = 0; i < 43; i++) {
+        ASSERT_EQ(hostLabels[i], (i < 20) ? 0 : (i < 40) ? 1 : -1);
+    }
+
+    ASSERT_THROW(khiva::clustering::hdbscan(tss, 1), std::invalid_argument);
+    ASSERT_THROW(khiva::clustering::hdbscan(tss, 5, 44), std::invalid_argument);
+}
+
+void kMeansPredict() {
+    float centroidsData[] = {0.0f, 0.0f, 0.0f, 10.0f, 10.0f, 10.0f};
+    af::array centroids(3, 2, centroidsData);
+    float data[] = {1.0f, 0.0f, 0.0f, 9.0f, 10.0f, 12.0f, 4.0f, 4.0f, 4.0f};
+    af::array tss(3, 3, data);
+
+    khiva::clustering::KMeansPredictor predictor(centroids);
+    af::array labels;
+    af::array distances;
+    predictor.predict(tss, labels, distances);
+
+    ASSERT_EQ(labels.dims(), af::dim4(1, 3, 1, 1));
+    auto hostLabels = khiva::utils::makeScopedHostPtr(labels.host<unsigned int>());
+    auto hostDistances = khiva::utils::makeScopedHostPtr(distances.host<float>());
+    unsigned int expectedLabels[] = {0, 1, 0};
+    float expectedDistances[] = {1.0f, std::sqrt(5.0f), std::sqrt(48.0f)};
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(hostLabels[i], expectedLabels[i]);
+        ASSERT_NEAR(hostDistances[i], expectedDistances[i], 1e-4);
+    }
+
+    // the stateless function gives the same labels
+    af::array otherLabels;
+    af::array otherDistances;
+    khiva::clustering::kMeansPredict(tss, centroids, otherLabels, otherDistances);
+    ASSERT_TRUE(af::allTrue<bool>(labels == otherLabels));
+
+    ASSERT_THROW(predictor.predict(af::constant(0, 4, 1), labels, distances), std::invalid_argument);
+}
+
+void kShapePredict() {
+    float data[] = {1.0f,  2.0f,  3.0f,  4.0f,  5.0f,   6.0f,  7.0f,  0.0f, 10.0f, 4.0f, 5.0f, 7.0f,
+                    -3.0f, 0.0f,  -1.0f, 15.0f, -12.0f, 8.0f,  9.0f,  4.0f, 5.0f,  2.0f, 8.0f, 7.0f,
+                    -6.0f, -1.0f, 2.0f,  9.0f,  -5.0f,  -5.0f, -6.0f, 7.0f, 9.0f,  9.0f, 0.0f};
+    af::array tss(7, 5, data);
+    unsigned int initial_l[] = {0, 1, 2, 0, 1};
+    af::array labels(5, 1, initial_l);
+    af::array centroids;
+    khiva::clustering::kShape(tss, 3, centroids, labels);
+
+    khiva::clustering::KShapePredictor predictor(centroids);
+    af::array predicted;
+    af::array distances;
+    predictor.predict(tss, predicted, distances);
+
+    // the last step of kShape labels every time series with its closest centroid
+    ASSERT_EQ(predicted.dims(), af::dim4(5, 1, 1, 1));
+    ASSERT_TRUE(af::allTrue<bool>(predicted == labels));
+
+    // a scaled and offset copy of a centroid has no shape-based distance to it
+    khiva::clustering::kShapePredict(centroids(af::span, 1) * 3.0f + 2.0f, centroids, predicted, distances);
+    ASSERT_EQ(predicted.scalar<unsigned int>(), 1u);
+    ASSERT_NEAR(distances.scalar<float>(), 0.0f, 1e-4);
+
+    ASSERT_THROW(predictor.predict(af::constant(0, 6, 1), predicted, distances), std::invalid_argument);
+}
+
 KHIVA_TEST(ClusteringTests, KMeans, kmeans)
 KHIVA_TEST(ClusteringTests, KMeans2, kmeans2)
+KHIVA_TEST(ClusteringTests, KMeansInvalidK, kmeansInvalidK)
+KHIVA_TEST(ClusteringTests, KMeansRestarts, kmeansRestarts)
+KHIVA_TEST(ClusteringTests, KMeansAccelerated, kmeansAccelerated)
+KHIVA_TEST(ClusteringTests, KMeansAcceleratedSameAsLloyd, kmeansAcceleratedSameAsLloyd)
+KHIVA_TEST(ClusteringTests, KMeansAcceleratedNearTies, kmeansAcceleratedNearTies)
+KHIVA_TEST(ClusteringTests, MiniBatchKMeans, miniBatchKMeans)
+KHIVA_TEST(ClusteringTests, MiniBatchKMeansWarmStart, miniBatchKMeansWarmStart)
+KHIVA_TEST(ClusteringTests, MiniBatchKMeansDrainsBatches, miniBatchKMeansDrainsBatches)
 KHIVA_TEST(ClusteringTests, KShapeFloat, kShapeFloat)
 KHIVA_TEST(ClusteringTests, KShapeDouble, kShapeDouble)
+KHIVA_TEST(ClusteringTests, KShapeShapeExtraction, kShapeShapeExtraction)
+KHIVA_TEST(ClusteringTests, KShapeRestarts, kShapeRestarts)
+KHIVA_TEST(ClusteringTests, KMedoids, kMedoids)
+KHIVA_TEST(ClusteringTests, KMedoidsCondensedAndFunction, kMedoidsCondensedAndFunction)
+KHIVA_TEST(ClusteringTests, KMedoidsInvalidArguments, kMedoidsInvalidArguments)
+KHIVA_TEST(ClusteringTests, Agglomerative, agglomerative)
+KHIVA_TEST(ClusteringTests, AgglomerativeCondensed, agglomerativeCondensed)
+KHIVA_TEST(ClusteringTests, Dbscan, dbscan)
+KHIVA_TEST(ClusteringTests, Hdbscan, hdbscan)
+KHIVA_TEST(ClusteringTests, KMeansPredict, kMeansPredict)
+KHIVA_TEST(ClusteringTests, KShapePredict, kShapePredict)
@@ -8,8 +8,198 @@
 #include <khiva/dimensionality.h>
 #include <khiva/internal/scopedHostPtr.h>
 
+#include <cmath>
+#include <random>
+#include <vector>
+
 #include "khivaTest.h"
 
+/**
+ * The points of the examples of the reductions as a 10 x 2 array, with the values scaled and shifted.
+ */
+af::array examplePoints(float scale = 1.0f, float offset = 0.0f) {
+    float px[] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+    float py[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
+    return af::join(1, af::array(10, 1, px), af::array(10, 1, py) * scale + offset);
+}
+
+void dftTopK() {
+    // 1 + cos(2 pi 2t / 8) and 3 sin(2 pi t / 8)
+    float data[] = {2.0f, 1.0f,        0.0f, 1.0f,        2.0f, 1.0f,         0.0f,  1.0f,
+                    0.0f, 2.12132034f, 3.0f, 2.12132034f, 0.0f, -2.12132034f, -3.0f, -2.12132034f};
+    af::array tss(8, 2, data);
+
+    af::array coefficients;
+    af::array indexes;
+    khiva::dimensionality::DFTTopK(tss, 2, coefficients, indexes);
+    ASSERT_EQ(coefficients.dims(), af::dim4(2, 2, 1, 1));
+    ASSERT_EQ(indexes.dims(), af::dim4(2, 2, 1, 1));
+
+    // the mean weights once and the rest of the frequencies twice
+    auto indexes_h = khiva::utils::makeScopedHostPtr(indexes.host<unsigned int>());
+    auto coefficients_h = khiva::utils::makeScopedHostPtr(coefficients.host<af::cfloat>());
+    ASSERT_EQ(indexes_h[0], 0u);
+    ASSERT_EQ(indexes_h[1], 2u);
+    ASSERT_EQ(indexes_h[2], 1u);
+    ASSERT_NEAR(coefficients_h[0].real, 8.0f, 1e-4);
+    ASSERT_NEAR(coefficients_h[1].real, 4.0f, 1e-4);
+    ASSERT_NEAR(coefficients_h[2].imag, -12.0f, 1e-4);
+
+    af::array reconstructed = khiva::dimensionality::inverseDFTTopK(coefficients, indexes, 8);
+    ASSERT_EQ(reconstructed.dims(), tss.dims());
+    ASSERT_NEAR(af::max<float>(af::abs(reconstructed - tss)), 0.0f, 1e-4);
+
+    ASSERT_THROW(khiva::dimensionality::DFTTopK(tss, 6, coefficients, indexes), std::invalid_argument);
+}
+
+void dwtHaar() {
+    float data[] = {1.0f, 2.0f, 3.0f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f};
+    af::array tss(4, 2, data);
+
+    af::array coefficients = khiva::dimensionality::DWT(tss, khiva::dimensionality::KHIVA_WAVELET_HAAR, 2);
+
+    auto coefficients_h = khiva::utils::makeScopedHostPtr(coefficients.host<float>());
+    std::vector<float> expected = {5.0f, 2.0f, 0.70710678f, 0.70710678f, 8.0f, 0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(coefficients_h[i], expected[i], EPSILON * 10);
+    }
+
+    af::array reconstructed =
+        khiva::dimensionality::inverseDWT(coefficients, khiva::dimensionality::KHIVA_WAVELET_HAAR, 2);
+    ASSERT_NEAR(af::max<float>(af::abs(reconstructed - tss)), 0.0f, EPSILON * 10);
+}
+
+void dwtDaubechies4() {
+    af::array ramp = af::range(af::dim4(8), 0, af::dtype::f64) + 1;
+    af::array coefficients = khiva::dimensionality::DWT(ramp, khiva::dimensionality::KHIVA_WAVELET_DAUBECHIES4);
+
+    // two vanishing moments, the details of a line are zero but at the periodic boundary
+    auto coefficients_h = khiva::utils::makeScopedHostPtr(coefficients.host<double>());
+    std::vector<double> expected = {2.310789035, 5.139216159, 7.967643284, 10.038195645, 2.828427125, 0.0, 0.0, 0.0};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(coefficients_h[i], expected[i], 1e-8);
+    }
+
+    // orthonormal and invertible with several levels and time series
+    af::setSeed(1);
+    af::array tss = af::randn(64, 3, af::dtype::f64);
+    af::array multilevel = khiva::dimensionality::DWT(tss, khiva::dimensionality::KHIVA_WAVELET_DAUBECHIES4, 3);
+    ASSERT_NEAR(af::sum<double>(multilevel * multilevel), af::sum<double>(tss * tss), 1e-9);
+    af::array reconstructed =
+        khiva::dimensionality::inverseDWT(multilevel, khiva::dimensionality::KHIVA_WAVELET_DAUBECHIES4, 3);
+    ASSERT_NEAR(af::max<double>(af::abs(reconstructed - tss)), 0.0, 1e-9);
+}
+
+void dwtException() {
+    af::array tss = af::randu(6, 2);
+    ASSERT_THROW(khiva::dimensionality::DWT(tss, khiva::dimensionality::KHIVA_WAVELET_HAAR, 2), std::invalid_argument);
+    ASSERT_THROW(khiva::dimensionality::DWT(tss, khiva::dimensionality::KHIVA_WAVELET_HAAR, 0), std::invalid_argument);
+}
+
+void lttb() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0},
+                                                           {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {8.0, 9.0}, {9.0, 9.0}};
+    std::vector<khiva::dimensionality::Point> expected = {{0.0, 0.0}, {2.0, -0.1}, {3.0, 5.0}, {7.0, 9.0}, {9.0, 9.0}};
+
+    ASSERT_EQ(expected, khiva::dimensionality::LTTB(pointList, 5));
+
+    // nothing to be reduced
+    ASSERT_EQ(pointList, khiva::dimensionality::LTTB(pointList, 10));
+}
+
+void lttbBatch() {
+    af::array tss = examplePoints();
+    af::array shifted = examplePoints(1.0f, 100.0f);
+
+    af::array pointsOut = khiva::dimensionality::LTTB(join(2, tss, shifted), 5);
+    ASSERT_EQ(pointsOut.dims(), af::dim4(5, 2, 2, 1));
+
+    // the areas of the triangles do not change when the values are shifted, so the same points are selected
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, 0, 1) == pointsOut(af::span, 0, 0)));
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, 1, 1) == pointsOut(af::span, 1, 0) + 100.0f));
+
+    auto pox = khiva::utils::makeScopedHostPtr(pointsOut(af::span, 0, 0).host<float>());
+    auto expectedX = std::vector<float>{0.0f, 2.0f, 3.0f, 7.0f, 9.0f};
+    for (size_t i = 0; i < expectedX.size(); i++) {
+        ASSERT_EQ(pox[i], expectedX[i]);
+    }
+}
+
+void lttbDownsampler() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0},
+                                                           {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {8.0, 9.0}, {9.0, 9.0}};
+
+    std::vector<khiva::dimensionality::Point> out;
+    khiva::dimensionality::LTTBDownsampler downsampler(
+        10, 5, [&out](const khiva::dimensionality::Point &point) { out.emplace_back(point); });
+
+    // the point of a bucket is emitted once the next bucket is complete
+    downsampler.add(std::vector<khiva::dimensionality::Point>(pointList.begin(), pointList.begin() + 3));
+    ASSERT_EQ(out.size(), 1u);
+    downsampler.add(std::vector<khiva::dimensionality::Point>(pointList.begin() + 3, pointList.begin() + 6));
+    ASSERT_EQ(out.size(), 2u);
+    downsampler.add(std::vector<khiva::dimensionality::Point>(pointList.begin() + 6, pointList.end()));
+    ASSERT_EQ(khiva::dimensionality::LTTB(pointList, 5), out);
+
+    // the downsampler can be reused after the last point
+    out.clear();
+    downsampler.add(pointList);
+    ASSERT_EQ(khiva::dimensionality::LTTB(pointList, 5), out);
+}
+
+void lttbException() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}};
+    ASSERT_THROW(khiva::dimensionality::LTTB(pointList, 2), std::invalid_argument);
+
+    ASSERT_THROW(khiva::dimensionality::LTTBDownsampler(3, 2, [](const khiva::dimensionality::Point &) {}),
+                 std::invalid_argument);
+}
+
+void m4() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0},
+                                                           {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {8.0, 9.0}, {9.0, 9.0}};
+    std::vector<khiva::dimensionality::Point> expected = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0},
+                                                          {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {9.0, 9.0}};
+
+    ASSERT_EQ(expected, khiva::dimensionality::M4(pointList, 3));
+}
+
+void m4Batch() {
+    af::array tss = examplePoints();
+    af::array flat = examplePoints(0.0f, 1.0f);
+
+    af::array pointsOut = khiva::dimensionality::M4(join(2, tss, flat), 3);
+    ASSERT_EQ(pointsOut.dims(), af::dim4(8, 2, 2, 1));
+
+    // only the first and the last points of the buckets of a flat time series are kept, and the rest is padded
+    auto pox = khiva::utils::makeScopedHostPtr(pointsOut(af::span, 0, 1).host<float>());
+    auto expectedX = std::vector<float>{0.0f, 2.0f, 3.0f, 5.0f, 6.0f, 9.0f};
+    for (size_t i = 0; i < expectedX.size(); i++) {
+        ASSERT_EQ(pox[i], expectedX[i]);
+    }
+    ASSERT_TRUE(std::isnan(pox[6]));
+    ASSERT_TRUE(std::isnan(pox[7]));
+}
+
+void m4Downsampler() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0},
+                                                           {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {8.0, 9.0}, {9.0, 9.0}};
+
+    std::vector<khiva::dimensionality::Point> out;
+    khiva::dimensionality::M4Downsampler downsampler(
+        0.0, 9.0, 3, [&out](const khiva::dimensionality::Point &point) { out.emplace_back(point); });
+
+    // a bucket is emitted when a point of the next one is added
+    downsampler.add(std::vector<khiva::dimensionality::Point>(pointList.begin(), pointList.begin() + 3));
+    ASSERT_TRUE(out.empty());
+    downsampler.add(std::vector<khiva::dimensionality::Point>(pointList.begin() + 3, pointList.end()));
+    ASSERT_EQ(out.size(), 5u);
+    downsampler.flush();
+    ASSERT_EQ(khiva::dimensionality::M4(pointList, 3), out);
+
+    ASSERT_THROW(khiva::dimensionality::M4(pointList, 0), std::invalid_argument);
+}
+
 void paaDivisible() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
@@ -32,12 +222,15 @@ void paaNonDivisibleFloat() {
 
     auto col0 = khiva::utils::makeScopedHostPtr(out.col(0).host<float>());
     auto col1 = khiva::utils::makeScopedHostPtr(out.col(1).host<float>());
-    std::vector<float> col0_expected = {1.0f, 4.0f, 7.5f};
-    std::vector<float> col1_expected = {0.0f, 6.0f, 8.7750f};
+    std::vector<float> col0_expected = {1.2f, 4.5f, 7.8f};
+    std::vector<float> col1_expected = {0.5f, 6.52f, 8.91f};
 
+    // Every frame splits a point with a fractional weight of 1/3, which has no exact single precision value, so
+    // these averages are off by about one ulp (6.52 by ~1e-6). The divisible and double tests keep EPSILON.
+    const auto fractionalEpsilon = EPSILON * 10;
     for (size_t i = 0; i < 3; i++) {
-        ASSERT_NEAR(col0[i], col0_expected[i], EPSILON);
-        ASSERT_NEAR(col1[i], col1_expected[i], EPSILON);
+        ASSERT_NEAR(col0[i], col0_expected[i], fractionalEpsilon);
+        ASSERT_NEAR(col1[i], col1_expected[i], fractionalEpsilon);
     }
 }
 
@@ -50,8 +243,8 @@ void paaNonDivisibleDouble() {
 
     auto col0 = khiva::utils::makeScopedHostPtr(out.col(0).host<double>());
     auto col1 = khiva::utils::makeScopedHostPtr(out.col(1).host<double>());
-    std::vector<double> col0_expected = {1.0, 4.0, 7.5};
-    std::vector<double> col1_expected = {0.0, 6.0, 8.7750};
+    std::vector<double> col0_expected = {1.2, 4.5, 7.8};
+    std::vector<double> col1_expected = {0.5, 6.52, 8.91};
 
     for (size_t i = 0; i < 3; i++) {
         ASSERT_NEAR(col0[i], col0_expected[i], EPSILON);
@@ -59,6 +252,21 @@ void paaNonDivisibleDouble() {
     }
 }
 
+void paaInteger() {
+    int pointList[] = {1, 2, 3};
+    af::array a(3, 1, pointList);
+
+    // more bins than points, every bin is the weighted average of the points it covers
+    af::array out = khiva::dimensionality::PAA(a, 7);
+    ASSERT_EQ(out.type(), af::dtype::f32);
+
+    auto out_h = khiva::utils::makeScopedHostPtr(out.host<float>());
+    std::vector<float> expected = {1.0f, 1.0f, 5.0f / 3.0f, 2.0f, 7.0f / 3.0f, 3.0f, 3.0f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(out_h[i], expected[i], EPSILON);
+    }
+}
+
 void paaNorm() {
     std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0},
                                                            {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {8.0, 9.0}, {9.0, 9.0}};
@@ -94,6 +302,25 @@ void pip() {
     ASSERT_EQ(expectedY, poyVector);
 }
 
+void pipBatch() {
+    af::array tss = examplePoints();
+    af::array flipped = examplePoints(-1.0f);
+
+    af::array pointsOut = khiva::dimensionality::PIP(join(2, tss, flipped), 6);
+    ASSERT_EQ(pointsOut.dims(), af::dim4(6, 2, 2, 1));
+
+    // the vertical distances to the segments keep their size when the time series is flipped, so the same points are
+    // selected
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, 0, 1) == pointsOut(af::span, 0, 0)));
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, 1, 1) + pointsOut(af::span, 1, 0) == 0.0f));
+
+    auto pox = khiva::utils::makeScopedHostPtr(pointsOut(af::span, 0, 1).host<float>());
+    auto expectedX = std::vector<float>{0.0f, 2.0f, 3.0f, 6.0f, 7.0f, 9.0f};
+    for (size_t i = 0; i < expectedX.size(); i++) {
+        ASSERT_EQ(pox[i], expectedX[i]);
+    }
+}
+
 void pipException() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
@@ -136,6 +363,48 @@ void plaBottomUp2() {
     ASSERT_EQ(expectedY, poyVector);
 }
 
+void plaBottomUpBatch() {
+    float maxError = 1.0;
+    float px[] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+    float py[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
+    float ly[] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+
+    af::array tsx(10, 1, px);
+    af::array tss = join(2, join(1, tsx, af::array(10, 1, py)), join(1, tsx, af::array(10, 1, ly)));
+
+    auto d_out = khiva::dimensionality::PLABottomUp(tss, maxError);
+    ASSERT_EQ(d_out.dims(), af::dim4(8, 2, 2, 1));
+    auto out = khiva::utils::makeScopedHostPtr(d_out.host<float>());
+
+    auto expectedX = std::vector<float>{0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 7.0f, 8.0f, 9.0f};
+    auto expectedY = std::vector<float>{0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 9.0f, 9.0f, 9.0f};
+    for (size_t i = 0; i < 8; i++) {
+        ASSERT_EQ(out[i], expectedX[i]);
+        ASSERT_EQ(out[8 + i], expectedY[i]);
+    }
+
+    // a line is merged into two segments and the rest of the rows are padded
+    auto expectedLine = std::vector<float>{0.0f, 7.0f, 8.0f, 9.0f};
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_EQ(out[16 + i], expectedLine[i]);
+        ASSERT_EQ(out[24 + i], expectedLine[i]);
+        ASSERT_TRUE(std::isnan(out[20 + i]));
+        ASSERT_TRUE(std::isnan(out[28 + i]));
+    }
+}
+
+void plaBottomUpOdd() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0},
+                                                           {4.0, 6.0}, {5.0, 7.0}, {6.0, 8.1}};
+
+    auto out = khiva::dimensionality::PLABottomUp(pointList, 0.5);
+
+    // the last point is kept in the last segment
+    std::vector<khiva::dimensionality::Point> expected = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1},
+                                                          {3.0, 5.0}, {4.0, 6.0}, {6.0, 8.1}};
+    ASSERT_EQ(expected, out);
+}
+
 void plaBottomUpException() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
@@ -180,6 +449,40 @@ void plaSlidingWindow2() {
     ASSERT_EQ(expectedY, poyVector);
 }
 
+void plaSegmenter() {
+    std::vector<khiva::dimensionality::Point> pointList = {{0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0},
+                                                           {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0},  {8.0, 9.0}, {9.0, 9.0}};
+
+    std::vector<khiva::dimensionality::Point> out;
+    khiva::dimensionality::PLASegmenter segmenter(
+        1.0f, [&out](const khiva::dimensionality::Point &start, const khiva::dimensionality::Point &end) {
+            out.emplace_back(start);
+            out.emplace_back(end);
+        });
+
+    // the first segment is closed by the fourth point and emitted with the fifth one
+    for (size_t i = 0; i < 4; i++) {
+        segmenter.add(pointList[i]);
+    }
+    ASSERT_TRUE(out.empty());
+    segmenter.add(pointList[4]);
+    ASSERT_EQ(out.size(), 2u);
+
+    for (size_t i = 5; i < pointList.size(); i++) {
+        segmenter.add(pointList[i]);
+    }
+    segmenter.flush();
+    ASSERT_EQ(khiva::dimensionality::PLASlidingWindow(pointList, 1.0f), out);
+
+    // the segmenter can be reused after a flush
+    out.clear();
+    segmenter.add({0.0f, 0.0f});
+    segmenter.add({1.0f, 1.0f});
+    segmenter.flush();
+    std::vector<khiva::dimensionality::Point> expected = {{0.0f, 0.0f}, {1.0f, 1.0f}};
+    ASSERT_EQ(expected, out);
+}
+
 void plaSlidingWindowException() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
@@ -216,6 +519,57 @@ void ramerDouglasPeucker2() {
     ASSERT_EQ(expectedY, pyVector);
 }
 
+void ramerDouglasPeuckerBatch() {
+    af::array tss = examplePoints();
+    af::array flat = examplePoints(0.0f, 1.0f);
+
+    af::array pointsOut = khiva::dimensionality::ramerDouglasPeucker(join(2, tss, flat), 1.0);
+    ASSERT_EQ(pointsOut.dims(), af::dim4(5, 2, 2, 1));
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, af::span, 0) ==
+                                  khiva::dimensionality::ramerDouglasPeucker(tss, 1.0)));
+
+    // only the first and the last points of a flat time series are kept, and the rest is padded
+    auto pox = khiva::utils::makeScopedHostPtr(pointsOut(af::span, 0, 1).host<float>());
+    ASSERT_EQ(pox[0], 0.0f);
+    ASSERT_EQ(pox[1], 9.0f);
+    for (size_t i = 2; i < 5; i++) {
+        ASSERT_TRUE(std::isnan(pox[i]));
+    }
+}
+
+void ramerDouglasPeuckerLarge() {
+    // the first levels of a random walk are searched in parallel, and give the same points as the sequential search
+    // of a batch
+    std::mt19937 generator(7);
+    std::normal_distribution<float> step;
+    std::vector<khiva::dimensionality::Point> pointList;
+    std::vector<float> px;
+    std::vector<float> py;
+    float y = 0.0f;
+    for (int i = 0; i < 100000; i++) {
+        pointList.emplace_back(static_cast<float>(i), y);
+        px.push_back(static_cast<float>(i));
+        py.push_back(y);
+        y += step(generator);
+    }
+
+    auto out = khiva::dimensionality::ramerDouglasPeucker(pointList, 10.0);
+    ASSERT_GT(out.size(), 2u);
+    ASSERT_LT(out.size(), pointList.size());
+    ASSERT_EQ(out.front(), pointList.front());
+    ASSERT_EQ(out.back(), pointList.back());
+
+    af::array tss = join(1, af::array(100000, px.data()), af::array(100000, py.data()));
+    af::array batch = khiva::dimensionality::ramerDouglasPeucker(join(2, tss, tss), 10.0);
+    ASSERT_EQ(batch.dims(0), static_cast<dim_t>(out.size()));
+    auto bx = khiva::utils::makeScopedHostPtr(batch(af::span, 0, 0).host<float>());
+    auto by = khiva::utils::makeScopedHostPtr(batch(af::span, 1, 0).host<float>());
+    for (size_t i = 0; i < out.size(); i++) {
+        ASSERT_EQ(bx[i], out[i].first);
+        ASSERT_EQ(by[i], out[i].second);
+    }
+}
+
 void ramerDouglasPeuckerException() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
@@ -247,6 +601,30 @@ void sax2() {
     EXPECT_EQ(expected, outVector);
 }
 
+void saxBatch() {
+    float pointList[] = {7.0f, 8.1f, 9.0f, 9.0f, 9.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+    af::array tss(5, 3, pointList);
+
+    af::array out = khiva::dimensionality::SAXBatch(tss, 3);
+    ASSERT_EQ(out.dims(), af::dim4(5, 3, 1, 1));
+
+    // every column is mapped with its own statistics, and a constant one has a single symbol
+    auto out_h = khiva::utils::makeScopedHostPtr(out.host<int>());
+    auto outVector = std::vector<int>(out_h.get(), out_h.get() + out.elements());
+    auto expected = std::vector<int>{0, 1, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 1, 2, 2};
+    ASSERT_EQ(expected, outVector);
+
+    // the PAA of the time series is {1.5, 3.5, 5.5}
+    float longer[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+    af::array reduced = khiva::dimensionality::SAXBatch(af::array(6, 1, longer), 3, 3);
+    auto reduced_h = khiva::utils::makeScopedHostPtr(reduced.host<int>());
+    auto reducedVector = std::vector<int>(reduced_h.get(), reduced_h.get() + reduced.elements());
+    auto expectedReduced = std::vector<int>{0, 1, 2};
+    ASSERT_EQ(expectedReduced, reducedVector);
+
+    ASSERT_THROW(khiva::dimensionality::SAXBatch(tss, 0), std::invalid_argument);
+}
+
 void saxException() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
@@ -283,30 +661,71 @@ void visvalingam2() {
     ASSERT_EQ(expectedY, pyVector);
 }
 
+void visvalingamBatch() {
+    af::array tss = examplePoints();
+    af::array scaled = examplePoints(2.0f);
+
+    af::array pointsOut = khiva::dimensionality::visvalingam(join(2, tss, scaled), 5);
+    ASSERT_EQ(pointsOut.dims(), af::dim4(5, 2, 2, 1));
+
+    // doubling the values doubles the area of every triangle, so the points are removed in the same order
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, 0, 1) == pointsOut(af::span, 0, 0)));
+    ASSERT_TRUE(af::allTrue<bool>(pointsOut(af::span, 1, 1) == 2.0f * pointsOut(af::span, 1, 0)));
+
+    auto poy = khiva::utils::makeScopedHostPtr(pointsOut(af::span, 1, 1).host<float>());
+    auto expectedY = std::vector<float>{0.0f, -0.2f, 10.0f, 18.0f, 18.0f};
+    for (size_t i = 0; i < expectedY.size(); i++) {
+        ASSERT_EQ(poy[i], expectedY[i]);
+    }
+
+    // asking for more points than available returns the input
+    ASSERT_TRUE(af::allTrue<bool>(khiva::dimensionality::visvalingam(tss, 20) == tss));
+}
+
 void visvalingamException() {
     float pointList[] = {0.0f, 0.1f, -0.1f, 5.0f, 6.0f, 7.0f, 8.1f, 9.0f, 9.0f, 9.0f};
     af::array a(10, 1, pointList);
     ASSERT_THROW(khiva::dimensionality::visvalingam(a, 6), std::invalid_argument);
 }
 
+KHIVA_TEST(DimensionalityTests, DFTTopK, dftTopK)
+KHIVA_TEST(DimensionalityTests, DWTHaar, dwtHaar)
+KHIVA_TEST(DimensionalityTests, DWTDaubechies4, dwtDaubechies4)
+KHIVA_TEST(DimensionalityTests, DWTException, dwtException)
+KHIVA_TEST(DimensionalityTests, LTTB, lttb)
+KHIVA_TEST(DimensionalityTests, LTTBBatch, lttbBatch)
+KHIVA_TEST(DimensionalityTests, LTTBDownsampler, lttbDownsampler)
+KHIVA_TEST(DimensionalityTests, LTTBException, lttbException)
+KHIVA_TEST(DimensionalityTests, M4, m4)
+KHIVA_TEST(DimensionalityTests, M4Batch, m4Batch)
+KHIVA_TEST(DimensionalityTests, M4Downsampler, m4Downsampler)
 KHIVA_TEST(DimensionalityTests, PAA_Divisible, paaDivisible)
 KHIVA_TEST(DimensionalityTests, PAA_NonDivisibleFloat, paaNonDivisibleFloat)
 KHIVA_TEST(DimensionalityTests, PAA_NonDivisibleDouble, paaNonDivisibleDouble)
+KHIVA_TEST(DimensionalityTests, PAA_Integer, paaInteger)
 KHIVA_TEST(DimensionalityTests, PAA_NORM, paaNorm)
 KHIVA_TEST(DimensionalityTests, PIP, pip)
+KHIVA_TEST(DimensionalityTests, PIPBatch, pipBatch)
 KHIVA_TEST(DimensionalityTests, PIPException, pipException)
 KHIVA_TEST(DimensionalityTests, PLABottomUp, plaBottomUp)
 KHIVA_TEST(DimensionalityTests, PLABottomUp2, plaBottomUp2)
+KHIVA_TEST(DimensionalityTests, PLABottomUpBatch, plaBottomUpBatch)
+KHIVA_TEST(DimensionalityTests, PLABottomUpOdd, plaBottomUpOdd)
 KHIVA_TEST(DimensionalityTests, PLABottomUpException, plaBottomUpException)
 KHIVA_TEST(DimensionalityTests, PLASlidingWindow, plaSlidingWindow)
 KHIVA_TEST(DimensionalityTests, PLASlidingWindow2, plaSlidingWindow2)
+KHIVA_TEST(DimensionalityTests, PLASegmenter, plaSegmenter)
 KHIVA_TEST(DimensionalityTests, PLASlidingWindowException, plaSlidingWindowException)
 KHIVA_TEST(DimensionalityTests, RamerDouglasPeucker, ramerDouglasPeucker)
 KHIVA_TEST(DimensionalityTests, RamerDouglasPeucker2, ramerDouglasPeucker2)
+KHIVA_TEST(DimensionalityTests, RamerDouglasPeuckerBatch, ramerDouglasPeuckerBatch)
+KHIVA_TEST(DimensionalityTests, RamerDouglasPeuckerLarge, ramerDouglasPeuckerLarge)
 KHIVA_TEST(DimensionalityTests, RamerDouglasPeuckerException, ramerDouglasPeuckerException)
 KHIVA_TEST(DimensionalityTests, SAX, sax)
 KHIVA_TEST(DimensionalityTests, SAX2, sax2)
+KHIVA_TEST(DimensionalityTests, SAXBatch, saxBatch)
 KHIVA_TEST(DimensionalityTests, SAXException, saxException)
 KHIVA_TEST(DimensionalityTests, Visvalingam, visvalingam)
 KHIVA_TEST(DimensionalityTests, Visvalingam2, visvalingam2)
+KHIVA_TEST(DimensionalityTests, VisvalingamBatch, visvalingamBatch)
 KHIVA_TEST(DimensionalityTests, VisvalingamException, visvalingamException)
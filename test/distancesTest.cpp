@@ -7,6 +7,11 @@
 #include <gtest/gtest.h>
 #include <khiva/distances.h>
 #include <khiva/internal/scopedHostPtr.h>
+#include <khiva/normalization.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
 
 #include "khivaTest.h"
 
@@ -41,6 +46,43 @@ void dtw2() {
     ASSERT_EQ(resultVector, expected);
 }
 
+void erp() {
+    std::vector<double> a = {1.0, 3.0, 4.0, 9.0, 8.0, 2.0, 1.0, 5.0, 7.0, 3.0};
+    std::vector<double> b = {1.0, 2.0, 5.0, 8.0, 9.0, 3.0, 1.0, 6.0, 6.0, 2.0, 4.0, 1.0};
+
+    ASSERT_NEAR(khiva::distances::erp(a, b), 11.0, 1e-9);
+    ASSERT_NEAR(khiva::distances::erp(a, b, 2.0), 9.0, 1e-9);
+    ASSERT_NEAR(khiva::distances::erp(a, b, 0.0, 3), 11.0, 1e-9);
+}
+
+void erpEarlyAbandon() {
+    std::vector<double> a = {1.0, 3.0, 4.0, 9.0, 8.0, 2.0, 1.0, 5.0, 7.0, 3.0};
+    std::vector<double> b = {1.0, 2.0, 5.0, 8.0, 9.0, 3.0, 1.0, 6.0, 6.0, 2.0, 4.0, 1.0};
+
+    ASSERT_TRUE(std::isinf(khiva::distances::erp(a, b, 0.0, -1, 10.0)));
+    ASSERT_NEAR(khiva::distances::erp(a, b, 0.0, -1, 11.0), 11.0, 1e-9);
+}
+
+void erpPairwise() {
+    float data[] = {1.0f, 3.0f, 4.0f, 9.0f, 8.0f, 2.0f, 1.0f, 2.0f, 5.0f, 8.0f, 9.0f,
+                    3.0f, 3.0f, 1.0f, 6.0f, 6.0f, 2.0f, 4.0f};
+    af::array tss(6, 3, data);
+
+    auto result = khiva::distances::erp(tss);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(3, 3, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto expected = std::vector<float>{0.0f, 0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 13.0f, 14.0f, 0.0f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(expected[i], hostResult[i], EPSILON);
+    }
+}
+
 void euclidean() {
     float data[] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f};
     af::array tss(4, 3, data);
@@ -60,6 +102,71 @@ void euclidean() {
     ASSERT_EQ(resultVector, expected);
 }
 
+void fastDtw() {
+    std::vector<double> a = {4.0, 4.0, 5.0, 5.0, 6.0, 6.0, 7.0, 7.0};
+    std::vector<double> b = {23.0, 4.0, 5.0, 6.0, 7.0};
+    std::vector<std::pair<int64_t, int64_t>> path;
+
+    double result = khiva::distances::fastDtw(a, b, 10, path);
+
+    ASSERT_EQ(result, 19.0);
+    auto expectedPath =
+        std::vector<std::pair<int64_t, int64_t>>{{0, 0}, {1, 1}, {2, 2}, {3, 2}, {4, 3}, {5, 3}, {6, 4}, {7, 4}};
+    ASSERT_EQ(path, expectedPath);
+}
+
+void fastDtwApproximation() {
+    af::setSeed(3);
+    auto hostA = khiva::utils::makeScopedHostPtr(af::accum(af::randn(1000, f64)).host<double>());
+    auto hostB = khiva::utils::makeScopedHostPtr(af::accum(af::randn(777, f64)).host<double>());
+    std::vector<double> a(hostA.get(), hostA.get() + 1000);
+    std::vector<double> b(hostB.get(), hostB.get() + 777);
+    std::vector<std::pair<int64_t, int64_t>> path;
+
+    double exact = khiva::distances::dtw(a, b);
+    double result = khiva::distances::fastDtw(a, b, 10, path);
+
+    // the approximation can only be worse than the exact distance, and it is the cost of the returned path
+    ASSERT_GE(result, exact - 1e-9);
+    ASSERT_LE(result, exact * 1.1);
+    ASSERT_EQ(path.front().first, 0);
+    ASSERT_EQ(path.front().second, 0);
+    ASSERT_EQ(path.back().first, 999);
+    ASSERT_EQ(path.back().second, 776);
+    double pathCost = 0.0;
+    for (size_t k = 0; k < path.size(); k++) {
+        if (k > 0) {
+            auto di = path[k].first - path[k - 1].first;
+            auto dj = path[k].second - path[k - 1].second;
+            ASSERT_TRUE(di >= 0 && di <= 1 && dj >= 0 && dj <= 1 && di + dj > 0);
+        }
+        pathCost += std::abs(a[path[k].first] - b[path[k].second]);
+    }
+    ASSERT_NEAR(result, pathCost, 1e-6);
+}
+
+void fastDtwPairwise() {
+    float data[] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f,
+                    3.0f, 3.0f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f};
+    af::array tss(5, 5, data);
+
+    af::array result = khiva::distances::fastDtw(tss, 1);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(5, 5, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto resultVector = std::vector<float>(hostResult.get(), hostResult.get() + result.elements());
+    auto expected =
+        std::vector<float>{0.0f, 0.0f, 0.0f,  0.0f,  0.0f, 5.0f, 0.0f, 0.0f,  0.0f,  0.0f,  10.0f, 5.0f, 0.0f,
+                           0.0f, 0.0f, 15.0f, 10.0f, 5.0f, 0.0f, 0.0f, 20.0f, 15.0f, 10.0f, 5.0f,  0.0f};
+
+    ASSERT_EQ(resultVector, expected);
+}
+
 void hamming() {
     float data[] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f,
                     3.0f, 3.0f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f};
@@ -80,6 +187,55 @@ void hamming() {
     ASSERT_EQ(resultVector, expected);
 }
 
+void hammingCondensed() {
+    float data[] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f,
+                    3.0f, 3.0f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f};
+    af::array tss(5, 5, data);
+
+    af::array result = khiva::distances::hamming(tss, true);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(10, 1, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto resultVector = std::vector<float>(hostResult.get(), hostResult.get() + result.elements());
+    auto expected = std::vector<float>{5.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f};
+    ASSERT_EQ(resultVector, expected);
+}
+
+void lcss() {
+    std::vector<double> a = {1.0, 3.0, 4.0, 9.0, 8.0, 2.0, 1.0, 5.0, 7.0, 3.0};
+    std::vector<double> b = {1.0, 2.0, 5.0, 8.0, 9.0, 3.0, 1.0, 6.0, 6.0, 2.0, 4.0, 1.0};
+
+    ASSERT_NEAR(khiva::distances::lcss(a, b, 0.5), 0.6, 1e-9);
+    ASSERT_NEAR(khiva::distances::lcss(a, b, 0.5, 2), 0.7, 1e-9);
+    ASSERT_TRUE(std::isinf(khiva::distances::lcss(a, b, 0.5, -1, 0.5)));
+    ASSERT_THROW(khiva::distances::lcss(a, b, -1.0), std::invalid_argument);
+}
+
+void lcssPairwise() {
+    float data[] = {1.0f, 3.0f, 4.0f, 9.0f, 8.0f, 2.0f, 1.0f, 2.0f, 5.0f, 8.0f, 9.0f,
+                    3.0f, 3.0f, 1.0f, 6.0f, 6.0f, 2.0f, 4.0f};
+    af::array tss(6, 3, data);
+
+    auto result = khiva::distances::lcss(tss, 0.5);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(3, 3, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto expected = std::vector<float>{0.0f, 0.0f, 0.0f, 0.666667f, 0.0f, 0.0f, 0.666667f, 0.666667f, 0.0f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(expected[i], hostResult[i], EPSILON);
+    }
+}
+
 void manhattan() {
     float data[] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f,
                     3.0f, 3.0f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f};
@@ -102,6 +258,105 @@ void manhattan() {
     ASSERT_EQ(resultVector, expected);
 }
 
+void manhattanCondensed() {
+    float data[] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f,
+                    3.0f, 3.0f, 4.0f, 4.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f};
+    af::array tss(5, 5, data);
+
+    af::array result = khiva::distances::manhattan(tss, true);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(10, 1, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto resultVector = std::vector<float>(hostResult.get(), hostResult.get() + result.elements());
+    auto expected = std::vector<float>{5.0f, 10.0f, 15.0f, 20.0f, 5.0f, 10.0f, 15.0f, 5.0f, 10.0f, 5.0f};
+    ASSERT_EQ(resultVector, expected);
+}
+
+void manhattanTiled() {
+    // Enough time series to span several tiles, with a length spanning several chunks
+    auto tss = af::randu(1000, 150, af::dtype::f64);
+
+    af::array result = khiva::distances::manhattan(tss);
+    af::array condensed = khiva::distances::manhattan(tss, true);
+
+    auto hostTss = khiva::utils::makeScopedHostPtr(tss.host<double>());
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<double>());
+    auto hostCondensed = khiva::utils::makeScopedHostPtr(condensed.host<double>());
+
+    int position = 0;
+    for (int i = 0; i < 150; i++) {
+        ASSERT_EQ(hostResult[i + i * 150], 0.0);
+        for (int j = i + 1; j < 150; j++) {
+            double expected = 0.0;
+            for (int k = 0; k < 1000; k++) {
+                expected += std::abs(hostTss[k + i * 1000] - hostTss[k + j * 1000]);
+            }
+            ASSERT_NEAR(hostResult[i + j * 150], expected, 1e-9);
+            ASSERT_EQ(hostResult[j + i * 150], 0.0);
+            ASSERT_NEAR(hostCondensed[position++], expected, 1e-9);
+        }
+    }
+}
+
+void manhattanAndHammingIntegers() {
+    // values that single precision cannot tell apart, so the integers must be compared in their own type
+    long long data[] = {1099511627776LL, -3LL, 1099511627777LL, 4LL, 1099511627776LL, -3LL};
+    af::array tss(2, 3, data);
+
+    af::array manhattan = khiva::distances::manhattan(tss, true);
+    af::array hamming = khiva::distances::hamming(tss, true);
+    ASSERT_EQ(manhattan.type(), af::dtype::s64);
+    ASSERT_EQ(hamming.type(), af::dtype::s64);
+
+    auto hostManhattan = khiva::utils::makeScopedHostPtr(manhattan.host<long long>());
+    auto hostHamming = khiva::utils::makeScopedHostPtr(hamming.host<long long>());
+    long long expectedManhattan[] = {8, 0, 8};
+    long long expectedHamming[] = {2, 0, 2};
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(hostManhattan[i], expectedManhattan[i]);
+        ASSERT_EQ(hostHamming[i], expectedHamming[i]);
+    }
+}
+
+void pairwiseUnsupportedTypes() {
+    ASSERT_THROW(khiva::distances::euclidean(af::constant(1, 4, 3, af::dtype::c32)), std::invalid_argument);
+    ASSERT_THROW(khiva::distances::manhattan(af::constant(1, 4, 3, af::dtype::c64)), std::invalid_argument);
+    ASSERT_THROW(khiva::distances::hamming(af::constant(1, 4, 3, af::dtype::b8)), std::invalid_argument);
+}
+
+void msm() {
+    std::vector<double> a = {1.0, 3.0, 4.0, 9.0, 8.0, 2.0, 1.0, 5.0, 7.0, 3.0};
+    std::vector<double> b = {1.0, 2.0, 5.0, 8.0, 9.0, 3.0, 1.0, 6.0, 6.0, 2.0, 4.0, 1.0};
+
+    ASSERT_NEAR(khiva::distances::msm(a, b), 13.0, 1e-9);
+    ASSERT_NEAR(khiva::distances::msm(a, b, 1.0, 1), 13.0, 1e-9);
+}
+
+void msmPairwise() {
+    float data[] = {1.0f, 3.0f, 4.0f, 9.0f, 8.0f, 2.0f, 1.0f, 2.0f, 5.0f, 8.0f, 9.0f,
+                    3.0f, 3.0f, 1.0f, 6.0f, 6.0f, 2.0f, 4.0f};
+    af::array tss(6, 3, data);
+
+    auto result = khiva::distances::msm(tss);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(3, 3, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto expected = std::vector<float>{0.0f, 0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 13.0f, 11.0f, 0.0f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(expected[i], hostResult[i], EPSILON);
+    }
+}
+
 void sbd() {
     float data[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 10.0f, 12.0f, 0.0f, 0.0f, 1.0f};
     af::array tss(5, 3, data);
@@ -124,6 +379,35 @@ void sbd() {
     }
 }
 
+void sbdBatched() {
+    af::setSeed(7);
+    af::array tss = af::randu(100, 40, af::dtype::f64);
+
+    auto result = khiva::distances::sbd(tss);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(40, 40, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check against the direct convolution of every pair
+    af::array zNorm = khiva::normalization::znorm(tss);
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<double>());
+    for (int j = 0; j < 40; j++) {
+        for (int i = 0; i < 40; i++) {
+            if (i >= j) {
+                ASSERT_EQ(hostResult[i + j * 40], 0.0);
+                continue;
+            }
+            af::array x = zNorm.col(i);
+            af::array y = zNorm.col(j);
+            af::array cc = af::convolve(x, af::flip(y, 0), AF_CONV_EXPAND);
+            double expected = 1.0 - af::max<double>(cc) / std::sqrt(af::sum<double>(x * x) * af::sum<double>(y * y));
+            ASSERT_NEAR(hostResult[i + j * 40], expected, 1e-9);
+        }
+    }
+}
+
 void squaredEuclidean() {
     float data[] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f};
     af::array tss(4, 3, data);
@@ -142,10 +426,75 @@ void squaredEuclidean() {
     ASSERT_EQ(resultVector, expected);
 }
 
+void squaredEuclideanCondensed() {
+    float data[] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f};
+    af::array tss(4, 3, data);
+
+    auto result = khiva::distances::squaredEuclidean(tss, true);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(3, 1, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto resultVector = std::vector<float>(hostResult.get(), hostResult.get() + result.elements());
+    auto expected = std::vector<float>{64.0f, 256.0f, 64.0f};
+    ASSERT_EQ(resultVector, expected);
+}
+
+void twe() {
+    std::vector<double> a = {1.0, 3.0, 4.0, 9.0, 8.0, 2.0, 1.0, 5.0, 7.0, 3.0};
+    std::vector<double> b = {1.0, 2.0, 5.0, 8.0, 9.0, 3.0, 1.0, 6.0, 6.0, 2.0, 4.0, 1.0};
+
+    ASSERT_NEAR(khiva::distances::twe(a, b), 22.002, 1e-9);
+    ASSERT_NEAR(khiva::distances::twe(a, b, 0.1, 0.5), 21.2, 1e-9);
+}
+
+void twePairwise() {
+    float data[] = {1.0f, 3.0f, 4.0f, 9.0f, 8.0f, 2.0f, 1.0f, 2.0f, 5.0f, 8.0f, 9.0f,
+                    3.0f, 3.0f, 1.0f, 6.0f, 6.0f, 2.0f, 4.0f};
+    af::array tss(6, 3, data);
+
+    auto result = khiva::distances::twe(tss);
+
+    // check dimensions
+    auto dims = result.dims();
+    auto expectedDims = af::dim4(3, 3, 1, 1);
+    EXPECT_EQ(expectedDims, dims);
+
+    // check distances
+    auto hostResult = khiva::utils::makeScopedHostPtr(result.host<float>());
+    auto expected = std::vector<float>{0.0f, 0.0f, 0.0f, 9.0f, 0.0f, 0.0f, 22.004f, 19.004f, 0.0f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(expected[i], hostResult[i], EPSILON);
+    }
+}
+
 KHIVA_TEST(DistanceTests, DTW, dtw)
 KHIVA_TEST(DistanceTests, DTW2, dtw2)
+KHIVA_TEST(DistanceTests, ERP, erp)
+KHIVA_TEST(DistanceTests, ERPEarlyAbandon, erpEarlyAbandon)
+KHIVA_TEST(DistanceTests, ERPPairwise, erpPairwise)
 KHIVA_TEST(DistanceTests, Euclidean, euclidean)
+KHIVA_TEST(DistanceTests, FastDTW, fastDtw)
+KHIVA_TEST(DistanceTests, FastDTWApproximation, fastDtwApproximation)
+KHIVA_TEST(DistanceTests, FastDTWPairwise, fastDtwPairwise)
 KHIVA_TEST(DistanceTests, Hamming, hamming)
+KHIVA_TEST(DistanceTests, HammingCondensed, hammingCondensed)
+KHIVA_TEST(DistanceTests, LCSS, lcss)
+KHIVA_TEST(DistanceTests, LCSSPairwise, lcssPairwise)
 KHIVA_TEST(DistanceTests, Manhattam, manhattan)
+KHIVA_TEST(DistanceTests, ManhattanCondensed, manhattanCondensed)
+KHIVA_TEST(DistanceTests, ManhattanTiled, manhattanTiled)
+KHIVA_TEST(DistanceTests, ManhattanAndHammingIntegers, manhattanAndHammingIntegers)
+KHIVA_TEST(DistanceTests, PairwiseUnsupportedTypes, pairwiseUnsupportedTypes)
+KHIVA_TEST(DistanceTests, MSM, msm)
+KHIVA_TEST(DistanceTests, MSMPairwise, msmPairwise)
 KHIVA_TEST(DistanceTests, SBD, sbd)
+KHIVA_TEST(DistanceTests, SBDBatched, sbdBatched)
 KHIVA_TEST(DistanceTests, SquaredEuclidean, squaredEuclidean)
+KHIVA_TEST(DistanceTests, SquaredEuclideanCondensed, squaredEuclideanCondensed)
+KHIVA_TEST(DistanceTests, TWE, twe)
+KHIVA_TEST(DistanceTests, TWEPairwise, twePairwise)
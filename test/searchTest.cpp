@@ -0,0 +1,365 @@
+// Copyright (c) 2019 Shapelets.io
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <gtest/gtest.h>
+#include <khiva/internal/scopedHostPtr.h>
+#include <khiva/search.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "khivaTest.h"
+
+void vpTreeKnn() {
+    float data[] = {0.0f, 0.0f, 1.0f, 0.0f, 2.0f, 0.0f, 3.0f, 0.0f, 10.0f, 0.0f, 11.0f, 0.0f};
+    af::array tss(2, 6, data);
+    float queryData[] = {2.2f, 0.0f, 10.4f, 0.0f};
+    af::array queries(2, 2, queryData);
+
+    khiva::search::VPTree tree(tss, khiva::search::KHIVA_METRIC_EUCLIDEAN, 1);
+    af::array distances;
+    af::array indexes;
+    tree.knn(queries, 3, distances, indexes);
+
+    // check dimensions
+    ASSERT_EQ(distances.dims(), af::dim4(3, 2, 1, 1));
+    ASSERT_EQ(indexes.dims(), af::dim4(3, 2, 1, 1));
+
+    auto hostDistances = khiva::utils::makeScopedHostPtr(distances.host<float>());
+    auto hostIndexes = khiva::utils::makeScopedHostPtr(indexes.host<unsigned int>());
+    auto expectedDistances = std::vector<float>{0.2f, 0.8f, 1.2f, 0.4f, 0.6f, 7.4f};
+    auto expectedIndexes = std::vector<unsigned int>{2, 3, 1, 4, 5, 3};
+    for (size_t i = 0; i < expectedDistances.size(); i++) {
+        ASSERT_NEAR(hostDistances[i], expectedDistances[i], EPSILON);
+        ASSERT_EQ(hostIndexes[i], expectedIndexes[i]);
+    }
+}
+
+void vpTreeKnnBruteForce() {
+    af::setSeed(11);
+    af::array tss = af::randn(16, 2000, f64);
+    af::array queries = af::randn(16, 20, f64);
+
+    khiva::search::VPTree tree(tss);
+    af::array distances;
+    af::array indexes;
+    tree.knn(queries, 5, distances, indexes);
+
+    auto hostTss = khiva::utils::makeScopedHostPtr(tss.host<double>());
+    auto hostQueries = khiva::utils::makeScopedHostPtr(queries.host<double>());
+    auto hostDistances = khiva::utils::makeScopedHostPtr(distances.host<double>());
+    auto hostIndexes = khiva::utils::makeScopedHostPtr(indexes.host<unsigned int>());
+    for (int q = 0; q < 20; q++) {
+        std::vector<std::pair<double, unsigned int>> all;
+        for (unsigned int i = 0; i < 2000; i++) {
+            double acc = 0.0;
+            for (int k = 0; k < 16; k++) {
+                acc += std::pow(hostQueries[q * 16 + k] - hostTss[i * 16 + k], 2);
+            }
+            all.emplace_back(std::sqrt(acc), i);
+        }
+        std::sort(all.begin(), all.end());
+        for (int k = 0; k < 5; k++) {
+            ASSERT_NEAR(hostDistances[q * 5 + k], all[k].first, 1e-9);
+            ASSERT_EQ(hostIndexes[q * 5 + k], all[k].second);
+        }
+    }
+}
+
+void vpTreeRange() {
+    float data[] = {0.0f, 0.0f, 1.0f, 0.0f, 2.0f, 0.0f, 3.0f, 0.0f, 10.0f, 0.0f, 11.0f, 0.0f};
+    af::array tss(2, 6, data);
+    float queryData[] = {2.2f, 0.0f, 20.0f, 0.0f};
+    af::array queries(2, 2, queryData);
+
+    khiva::search::VPTree tree(tss, khiva::search::KHIVA_METRIC_EUCLIDEAN, 1);
+    auto result = tree.range(queries, 1.0);
+
+    ASSERT_EQ(result.size(), 2u);
+    ASSERT_EQ(result[0].size(), 2u);
+    ASSERT_EQ(result[0][0].first, 2);
+    ASSERT_NEAR(result[0][0].second, 0.2, EPSILON);
+    ASSERT_EQ(result[0][1].first, 3);
+    ASSERT_NEAR(result[0][1].second, 0.8, EPSILON);
+    ASSERT_TRUE(result[1].empty());
+}
+
+void vpTreeZNormalised() {
+    float data[] = {1.0f, 2.0f, 3.0f, 4.0f, 4.0f, 3.0f, 2.0f, 1.0f, 10.0f, 20.0f, 30.0f, 40.0f};
+    af::array tss(4, 3, data);
+    float queryData[] = {-5.0f, -4.0f, -3.0f, -2.0f};
+    af::array queries(4, 1, queryData);
+
+    khiva::search::VPTree tree(tss, khiva::search::KHIVA_METRIC_ZNORM_EUCLIDEAN, 1);
+    af::array distances;
+    af::array indexes;
+    tree.knn(queries, 2, distances, indexes);
+
+    // the first and the last time series are the same once z-normalised
+    auto hostDistances = khiva::utils::makeScopedHostPtr(distances.host<float>());
+    auto hostIndexes = khiva::utils::makeScopedHostPtr(indexes.host<unsigned int>());
+    ASSERT_NEAR(hostDistances[0], 0.0f, EPSILON);
+    ASSERT_NEAR(hostDistances[1], 0.0f, EPSILON);
+    ASSERT_EQ(std::min(hostIndexes[0], hostIndexes[1]), 0u);
+    ASSERT_EQ(std::max(hostIndexes[0], hostIndexes[1]), 2u);
+}
+
+void vpTreeSaveLoad() {
+    af::setSeed(13);
+    af::array tss = af::randn(8, 300, f64);
+    af::array queries = af::randn(8, 10, f64);
+
+    khiva::search::VPTree tree(tss, khiva::search::KHIVA_METRIC_EUCLIDEAN, 4);
+    std::stringstream stream;
+    tree.save(stream);
+    auto loaded = khiva::search::VPTree::load(stream);
+
+    ASSERT_EQ(loaded.getLength(), 8);
+    ASSERT_EQ(loaded.getNumberOfTimeSeries(), 300);
+
+    af::array distances;
+    af::array indexes;
+    tree.knn(queries, 3, distances, indexes);
+    af::array loadedDistances;
+    af::array loadedIndexes;
+    loaded.knn(queries, 3, loadedDistances, loadedIndexes);
+    ASSERT_TRUE(af::allTrue<bool>(distances == loadedDistances));
+    ASSERT_TRUE(af::allTrue<bool>(indexes == loadedIndexes));
+
+    std::stringstream garbage("not a tree");
+    ASSERT_THROW(khiva::search::VPTree::load(garbage), std::runtime_error);
+
+    // The header and the time series precede the order, which precedes the nodes
+    auto serialised = stream.str();
+    size_t orderOffset = 28 + (8 + 8 * 300 * sizeof(double)) + 8;
+    size_t rootOffset = orderOffset + 8 * 300 + 8;
+    auto corrupt = [&](size_t offset, int64_t value) {
+        auto copy = serialised;
+        std::memcpy(&copy[offset], &value, sizeof(value));
+        std::stringstream corrupted(copy);
+        return khiva::search::VPTree::load(corrupted);
+    };
+    ASSERT_THROW(corrupt(orderOffset, 300), std::invalid_argument);
+    ASSERT_THROW(corrupt(rootOffset + 8, 301), std::invalid_argument);
+    ASSERT_THROW(corrupt(rootOffset + 32, 0), std::invalid_argument);
+
+    // The type of the distances follows the magic number, the version, the metric and the leaf size
+    auto copy = serialised;
+    auto type = static_cast<int32_t>(s32);
+    std::memcpy(&copy[16], &type, sizeof(type));
+    std::stringstream wrongType(copy);
+    ASSERT_THROW(khiva::search::VPTree::load(wrongType), std::invalid_argument);
+}
+
+void vpTreeIntegerDistances() {
+    af::setSeed(29);
+    af::array tss = af::round(af::randn(6, 200, f64) * 10.0);
+    af::array queries = af::round(af::randn(6, 5, f64) * 10.0);
+
+    khiva::search::VPTree tree(tss.as(s32));
+    af::array distances;
+    af::array indexes;
+    tree.knn(queries.as(s32), 4, distances, indexes);
+    ASSERT_EQ(distances.type(), f32);
+
+    khiva::search::VPTree exact(tss);
+    af::array exactDistances;
+    af::array exactIndexes;
+    exact.knn(queries, 4, exactDistances, exactIndexes);
+    ASSERT_LT(af::max<double>(af::abs(distances.as(f64) - exactDistances)), 1e-4);
+}
+
+void vpTreeInvalidQueries() {
+    af::array tss = af::randn(8, 10, f64);
+    khiva::search::VPTree tree(tss);
+    af::array distances;
+    af::array indexes;
+
+    ASSERT_THROW(tree.knn(af::randn(4, 1, f64), 1, distances, indexes), std::invalid_argument);
+    ASSERT_THROW(tree.knn(af::randn(8, 1, f64), 11, distances, indexes), std::invalid_argument);
+    ASSERT_THROW(tree.range(af::randn(8, 1, f64), -1.0), std::invalid_argument);
+}
+
+void isaxExact() {
+    af::setSeed(17);
+    af::array tss = af::accum(af::randn(32, 1000, f64));
+    af::array queries = af::accum(af::randn(32, 20, f64));
+
+    khiva::search::ISAXIndex index(tss, 8, 16);
+    af::array distances;
+    af::array indexes;
+    index.knn(queries, 5, distances, indexes);
+
+    // the exact search gives the same neighbours as a scan of all the z-normalised time series
+    khiva::search::VPTree tree(tss, khiva::search::KHIVA_METRIC_ZNORM_EUCLIDEAN);
+    af::array expectedDistances;
+    af::array expectedIndexes;
+    tree.knn(queries, 5, expectedDistances, expectedIndexes);
+    ASSERT_TRUE(af::allTrue<bool>(indexes == expectedIndexes));
+    ASSERT_LT(af::max<double>(af::abs(distances - expectedDistances)), 1e-9);
+
+    // the approximate search can only find farther neighbours
+    af::array approximateDistances;
+    af::array approximateIndexes;
+    index.knn(queries, 5, approximateDistances, approximateIndexes, false);
+    ASSERT_TRUE(af::allTrue<bool>(approximateDistances >= expectedDistances - 1e-9));
+
+    // an indexed time series is in the leaf of its own word
+    index.knn(tss(af::span, af::seq(0, 9)), 1, approximateDistances, approximateIndexes, false);
+    auto hostIndexes = khiva::utils::makeScopedHostPtr(approximateIndexes.host<unsigned int>());
+    for (unsigned int i = 0; i < 10; i++) {
+        ASSERT_EQ(hostIndexes[i], i);
+    }
+    ASSERT_LT(af::max<double>(approximateDistances), 1e-9);
+}
+
+void isaxSubsequences() {
+    af::setSeed(19);
+    af::array ts = af::accum(af::randn(400, 1, f64));
+    auto window = 24;
+    auto numSubsequences = 400 - window + 1;
+
+    auto index = khiva::search::ISAXIndex::subsequences(ts, window, 4, 8);
+    ASSERT_EQ(index.getNumberOfTimeSeries(), numSubsequences);
+    ASSERT_EQ(index.getLength(), window);
+
+    af::array subsequences = af::constant(0, window, numSubsequences, f64);
+    for (int i = 0; i < numSubsequences; i++) {
+        subsequences(af::span, i) = ts(af::seq(i, i + window - 1));
+    }
+    af::array queries = af::accum(af::randn(window, 10, f64));
+
+    af::array distances;
+    af::array indexes;
+    index.knn(queries, 3, distances, indexes);
+    khiva::search::VPTree tree(subsequences, khiva::search::KHIVA_METRIC_ZNORM_EUCLIDEAN);
+    af::array expectedDistances;
+    af::array expectedIndexes;
+    tree.knn(queries, 3, expectedDistances, expectedIndexes);
+    ASSERT_TRUE(af::allTrue<bool>(indexes == expectedIndexes));
+    ASSERT_LT(af::max<double>(af::abs(distances - expectedDistances)), 1e-6);
+}
+
+namespace {
+
+// A file in the temporary directory, removed when it goes out of scope even if an assertion fails
+struct TemporaryFile {
+    explicit TemporaryFile(const std::string &name) {
+        const char *dir = std::getenv("TMPDIR");
+        if (dir == nullptr) {
+            dir = std::getenv("TEMP");
+        }
+        path = std::string((dir == nullptr) ? "/tmp" : dir) + "/" + name;
+    }
+    ~TemporaryFile() { std::remove(path.c_str()); }
+    std::string path;
+};
+
+}  // namespace
+
+void isaxLeavesFileSaveLoad() {
+    af::setSeed(23);
+    af::array tss = af::accum(af::randn(16, 500, f64));
+    af::array queries = af::accum(af::randn(16, 10, f64));
+    TemporaryFile leaves("isaxLeavesFileSaveLoad.bin");
+
+    khiva::search::ISAXIndex memory(tss, 4, 8);
+    khiva::search::ISAXIndex file(tss, 4, 8, leaves.path);
+    std::stringstream stream;
+    file.save(stream);
+    auto loaded = khiva::search::ISAXIndex::load(stream);
+    ASSERT_EQ(loaded.getSegments(), 4);
+    ASSERT_EQ(loaded.getNumberOfTimeSeries(), 500);
+
+    af::array distances;
+    af::array indexes;
+    memory.knn(queries, 3, distances, indexes);
+    af::array fileDistances;
+    af::array fileIndexes;
+    loaded.knn(queries, 3, fileDistances, fileIndexes);
+    ASSERT_TRUE(af::allTrue<bool>(distances == fileDistances));
+    ASSERT_TRUE(af::allTrue<bool>(indexes == fileIndexes));
+
+    std::stringstream garbage("not an index");
+    ASSERT_THROW(khiva::search::ISAXIndex::load(garbage), std::runtime_error);
+
+    // The header, the name of the file, the step and the empty values, means and standard deviations precede the
+    // order, which precedes the nodes
+    auto serialised = stream.str();
+    auto orderOffset = 28 + (8 + leaves.path.size()) + 8 + 3 * 8 + 8;
+    auto rootOffset = orderOffset + 8 * 500 + 8;
+    auto corrupt = [&](size_t offset, int64_t value) {
+        auto copy = serialised;
+        std::memcpy(&copy[offset], &value, sizeof(value));
+        std::stringstream corrupted(copy);
+        return khiva::search::ISAXIndex::load(corrupted);
+    };
+    ASSERT_THROW(corrupt(orderOffset, 500), std::invalid_argument);
+    ASSERT_THROW(corrupt(rootOffset + 8, 501), std::invalid_argument);
+    ASSERT_THROW(corrupt(rootOffset + 16, 0), std::invalid_argument);
+
+    // The type of the distances follows the magic number, the version, the segments and the leaf size
+    auto copy = serialised;
+    auto type = static_cast<int32_t>(u8);
+    std::memcpy(&copy[16], &type, sizeof(type));
+    std::stringstream wrongType(copy);
+    ASSERT_THROW(khiva::search::ISAXIndex::load(wrongType), std::invalid_argument);
+}
+
+void isaxIntegerDistances() {
+    af::setSeed(31);
+    af::array tss = af::round(af::accum(af::randn(16, 300, f64)) * 10.0);
+    af::array queries = af::round(af::accum(af::randn(16, 5, f64)) * 10.0);
+
+    khiva::search::ISAXIndex index(tss.as(s32), 4, 8);
+    af::array distances;
+    af::array indexes;
+    index.knn(queries.as(s32), 3, distances, indexes);
+    ASSERT_EQ(distances.type(), f32);
+
+    khiva::search::ISAXIndex exact(tss, 4, 8);
+    af::array exactDistances;
+    af::array exactIndexes;
+    exact.knn(queries, 3, exactDistances, exactIndexes);
+    ASSERT_LT(af::max<double>(af::abs(distances.as(f64) - exactDistances)), 1e-5);
+}
+
+void isaxInvalidArguments() {
+    af::array tss = af::randn(8, 10, f64);
+    ASSERT_THROW(khiva::search::ISAXIndex(tss, 0), std::invalid_argument);
+    ASSERT_THROW(khiva::search::ISAXIndex(tss, 9), std::invalid_argument);
+    ASSERT_THROW(khiva::search::ISAXIndex(tss, 4, 0), std::invalid_argument);
+    ASSERT_THROW(khiva::search::ISAXIndex::subsequences(tss, 4), std::invalid_argument);
+    ASSERT_THROW(khiva::search::ISAXIndex::subsequences(tss.col(0), 9), std::invalid_argument);
+
+    khiva::search::ISAXIndex index(tss, 4);
+    af::array distances;
+    af::array indexes;
+    ASSERT_THROW(index.knn(af::randn(4, 1, f64), 1, distances, indexes), std::invalid_argument);
+    ASSERT_THROW(index.knn(af::randn(8, 1, f64), 11, distances, indexes), std::invalid_argument);
+}
+
+KHIVA_TEST(SearchTests, VPTreeKnn, vpTreeKnn)
+KHIVA_TEST(SearchTests, VPTreeKnnBruteForce, vpTreeKnnBruteForce)
+KHIVA_TEST(SearchTests, VPTreeRange, vpTreeRange)
+KHIVA_TEST(SearchTests, VPTreeZNormalised, vpTreeZNormalised)
+KHIVA_TEST(SearchTests, VPTreeSaveLoad, vpTreeSaveLoad)
+KHIVA_TEST(SearchTests, VPTreeInvalidQueries, vpTreeInvalidQueries)
+KHIVA_TEST(SearchTests, VPTreeIntegerDistances, vpTreeIntegerDistances)
+KHIVA_TEST(SearchTests, ISAXExact, isaxExact)
+KHIVA_TEST(SearchTests, ISAXSubsequences, isaxSubsequences)
+KHIVA_TEST(SearchTests, ISAXLeavesFileSaveLoad, isaxLeavesFileSaveLoad)
+KHIVA_TEST(SearchTests, ISAXInvalidArguments, isaxInvalidArguments)
+KHIVA_TEST(SearchTests, ISAXIntegerDistances, isaxIntegerDistances)